@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Minimal timing for the benchmark executables, which print their results. Build them optimized, e.g. with
+// -DCMAKE_BUILD_TYPE=Release.
+namespace benchmark {
+// Fastest of the runs in seconds, the others being slowed down by whatever else ran at the time
+template <typename Function>
+double MeasureSeconds(uint32_t run_count, Function function) {
+  double best = 0.0;
+  for (uint32_t run = 0; run < run_count; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+// Keeps the compiler from optimizing away a computation whose result is otherwise unused
+template <typename T>
+void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+}  // namespace benchmark
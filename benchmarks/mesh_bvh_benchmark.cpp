@@ -0,0 +1,147 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tiny_obj_loader.h>
+
+#include "benchmark.h"
+#include "engine/mesh.h"
+#include "engine/mesh_bvh.h"
+
+// MeshBvh build time and rays per second for nearest and any hits, on the viking room model and on cube-spheres. A
+// sample of the rays is checked against a brute-force search first. Run from the build directory, where the assets
+// are copied, or pass the path of viking_room.obj.
+namespace {
+constexpr uint32_t kRayCount = 200000;
+
+struct MeshData {
+  std::string name;
+  std::vector<engine::Vertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+MeshData LoadObj(const std::string& file_path) {
+  tinyobj::ObjReader reader;
+  if (!reader.ParseFromFile(file_path)) {
+    throw std::runtime_error{"Failed to load " + file_path + "!"};
+  }
+  MeshData mesh{.name = "viking_room"};
+  const std::vector<float>& positions = reader.GetAttrib().vertices;
+  for (const tinyobj::shape_t& shape : reader.GetShapes()) {
+    for (const tinyobj::index_t& index : shape.mesh.indices) {
+      engine::Vertex vertex{};
+      vertex.position = {positions[3 * index.vertex_index + 0], positions[3 * index.vertex_index + 1],
+                         positions[3 * index.vertex_index + 2]};
+      mesh.indices.push_back(static_cast<uint32_t>(mesh.vertices.size()));
+      mesh.vertices.push_back(vertex);
+    }
+  }
+  return mesh;
+}
+
+MeshData CreateSphere(uint32_t cube_face_resolution) {
+  MeshData mesh{.name = "sphere " + std::to_string(cube_face_resolution)};
+  engine::Mesh::GenerateSphere(cube_face_resolution, true, mesh.vertices, mesh.indices);
+  return mesh;
+}
+
+std::optional<engine::RayHit> IntersectBruteForce(const MeshData& mesh, const engine::Ray& ray) {
+  std::optional<engine::RayHit> nearest;
+  float max_t = ray.max_t;
+  for (uint32_t triangle = 0; triangle < mesh.indices.size() / 3; ++triangle) {
+    const glm::vec3& v0 = mesh.vertices[mesh.indices[3 * triangle + 0]].position;
+    const glm::vec3 e1 = mesh.vertices[mesh.indices[3 * triangle + 1]].position - v0;
+    const glm::vec3 e2 = mesh.vertices[mesh.indices[3 * triangle + 2]].position - v0;
+    const glm::vec3 p = glm::cross(ray.direction, e2);
+    const float determinant = glm::dot(e1, p);
+    if (determinant == 0.0f) {
+      continue;
+    }
+    const glm::vec3 s = ray.origin - v0;
+    const float u = glm::dot(s, p) / determinant;
+    const glm::vec3 q = glm::cross(s, e1);
+    const float v = glm::dot(ray.direction, q) / determinant;
+    const float t = glm::dot(e2, q) / determinant;
+    if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= max_t) {
+      max_t = t;
+      nearest = engine::RayHit{.t = t, .triangle = triangle, .barycentrics = {u, v}};
+    }
+  }
+  return nearest;
+}
+
+// From a sphere around the mesh's bounds towards random points within them, so that most rays hit
+std::vector<engine::Ray> CreateRays(const MeshData& mesh) {
+  glm::vec3 min = mesh.vertices[0].position;
+  glm::vec3 max = mesh.vertices[0].position;
+  for (const engine::Vertex& vertex : mesh.vertices) {
+    min = glm::min(min, vertex.position);
+    max = glm::max(max, vertex.position);
+  }
+  const glm::vec3 center = (min + max) * 0.5f;
+  const float radius = glm::length(max - min);
+  std::mt19937 random{7};
+  std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+  std::vector<engine::Ray> rays(kRayCount);
+  for (engine::Ray& ray : rays) {
+    const glm::vec3 origin =
+        center + radius * glm::normalize(glm::vec3{distribution(random), distribution(random), distribution(random)});
+    const glm::vec3 target =
+        center + (max - min) * 0.5f * glm::vec3{distribution(random), distribution(random), distribution(random)};
+    ray = {.origin = origin, .direction = target - origin};
+  }
+  return rays;
+}
+
+// Returns the number of rays whose hits differ from those of the brute-force search
+uint32_t Run(const MeshData& mesh, uint32_t checked_ray_count) {
+  std::optional<engine::MeshBvh> bvh;
+  const double build_seconds = benchmark::MeasureSeconds(1, [&] { bvh.emplace(mesh.vertices, mesh.indices); });
+  const std::vector<engine::Ray> rays = CreateRays(mesh);
+
+  uint32_t mismatch_count = 0;
+  for (uint32_t i = 0; i < checked_ray_count; ++i) {
+    const std::optional<engine::RayHit> expected = IntersectBruteForce(mesh, rays[i]);
+    const std::optional<engine::RayHit> hit = bvh->Intersect(rays[i]);
+    // Rays grazing an edge may hit or miss depending on the order of operations
+    if (hit.has_value() != expected.has_value() || bvh->IntersectsAny(rays[i]) != expected.has_value() ||
+        (hit && std::abs(hit->t - expected->t) > 1e-5f * std::max(1.0f, expected->t))) {
+      ++mismatch_count;
+    }
+  }
+
+  uint32_t hit_count = 0;
+  const double nearest_seconds = benchmark::MeasureSeconds(3, [&] {
+    hit_count = 0;
+    for (const engine::Ray& ray : rays) {
+      hit_count += bvh->Intersect(ray).has_value();
+    }
+  });
+  uint32_t any_hit_count = 0;
+  const double any_seconds = benchmark::MeasureSeconds(3, [&] {
+    any_hit_count = 0;
+    for (const engine::Ray& ray : rays) {
+      any_hit_count += bvh->IntersectsAny(ray);
+    }
+  });
+  std::printf("%-12s %8zu triangles %7u nodes, build %8.1f ms, %5.1f%% hit, %6.2f Mrays/s nearest, %6.2f Mrays/s any, "
+              "%u/%u mismatches\n",
+              mesh.name.c_str(), mesh.indices.size() / 3, bvh->GetNodeCount(), 1e3 * build_seconds,
+              100.0 * hit_count / kRayCount, kRayCount / nearest_seconds / 1e6, kRayCount / any_seconds / 1e6,
+              mismatch_count, checked_ray_count);
+  return mismatch_count + (any_hit_count != hit_count);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::string obj_path = argc > 1 ? argv[1] : "assets/viking_room.obj";
+  uint32_t mismatch_count = Run(LoadObj(obj_path), 2000);
+  mismatch_count += Run(CreateSphere(64), 2000);
+  mismatch_count += Run(CreateSphere(512), 50);
+  return mismatch_count == 0 ? 0 : 1;
+}
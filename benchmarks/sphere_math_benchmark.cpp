@@ -0,0 +1,67 @@
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "engine/sphere_math.h"
+
+// Scalar and batch CubeToSphere and SphereToUV over a million points, about as many as a cube-sphere of 418 points per
+// face edge
+int main() {
+  constexpr uint32_t kPointCount = 1 << 20;
+  constexpr uint32_t kRunCount = 10;
+
+  std::mt19937 random{1};
+  std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+  std::vector<float> x(kPointCount);
+  std::vector<float> y(kPointCount);
+  std::vector<float> z(kPointCount, 1.0f);
+  for (uint32_t i = 0; i < kPointCount; ++i) {
+    x[i] = distribution(random);
+    y[i] = distribution(random);
+  }
+  std::vector<float> out_x(kPointCount);
+  std::vector<float> out_y(kPointCount);
+  std::vector<float> out_z(kPointCount);
+
+  const double scalar_cube_to_sphere = benchmark::MeasureSeconds(kRunCount, [&] {
+    for (uint32_t i = 0; i < kPointCount; ++i) {
+      const glm::vec3 p = engine::sphere_math::CubeToSphere({x[i], y[i], z[i]});
+      out_x[i] = p.x;
+      out_y[i] = p.y;
+      out_z[i] = p.z;
+    }
+    benchmark::DoNotOptimize(out_x.data());
+  });
+  const double batch_cube_to_sphere = benchmark::MeasureSeconds(kRunCount, [&] {
+    engine::sphere_math::CubeToSphere(x.data(), y.data(), z.data(), out_x.data(), out_y.data(), out_z.data(),
+                                      kPointCount);
+    benchmark::DoNotOptimize(out_x.data());
+  });
+
+  // On the sphere from here on
+  x = out_x;
+  y = out_y;
+  z = out_z;
+  const double scalar_sphere_to_uv = benchmark::MeasureSeconds(kRunCount, [&] {
+    for (uint32_t i = 0; i < kPointCount; ++i) {
+      const glm::vec2 uv = engine::sphere_math::SphereToUV({x[i], y[i], z[i]});
+      out_x[i] = uv.x;
+      out_y[i] = uv.y;
+    }
+    benchmark::DoNotOptimize(out_x.data());
+  });
+  const double batch_sphere_to_uv = benchmark::MeasureSeconds(kRunCount, [&] {
+    engine::sphere_math::SphereToUV(x.data(), y.data(), z.data(), out_x.data(), out_y.data(), kPointCount);
+    benchmark::DoNotOptimize(out_x.data());
+  });
+
+  auto print = [](const char* name, double scalar_seconds, double batch_seconds) {
+    std::printf("%-13s scalar %6.2f ns/point, batch %6.2f ns/point, %.1fx\n", name, 1e9 * scalar_seconds / kPointCount,
+                1e9 * batch_seconds / kPointCount, scalar_seconds / batch_seconds);
+  };
+  std::printf("Batch width %u, %u points\n", engine::sphere_math::GetBatchWidth(), kPointCount);
+  print("CubeToSphere", scalar_cube_to_sphere, batch_cube_to_sphere);
+  print("SphereToUV", scalar_sphere_to_uv, batch_sphere_to_uv);
+}
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "engine/mesh.h"
+#include "engine/thread_pool.h"
+
+// Cube-sphere generation as done by Mesh::CreateSphereMesh() before optimization and upload, across resolutions and
+// thread counts. The calling thread takes part, so n threads are n - 1 workers.
+int main() {
+  const uint32_t max_thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+  std::vector<uint32_t> thread_counts;
+  for (uint32_t thread_count = 1; thread_count < max_thread_count; thread_count *= 2) {
+    thread_counts.push_back(thread_count);
+  }
+  thread_counts.push_back(max_thread_count);
+
+  std::printf("%10s", "resolution");
+  for (const uint32_t thread_count : thread_counts) {
+    std::printf("%9u thr", thread_count);
+  }
+  std::printf("   (ms, welded)\n");
+
+  std::vector<engine::Vertex> vertices;
+  std::vector<uint32_t> indices;
+  for (uint32_t resolution = 64; resolution <= 2048; resolution *= 2) {
+    std::printf("%10u", resolution);
+    for (const uint32_t thread_count : thread_counts) {
+      engine::ThreadPool thread_pool{thread_count - 1};
+      const uint32_t run_count = resolution <= 512 ? 5 : 2;
+      const double seconds = benchmark::MeasureSeconds(run_count, [&] {
+        engine::Mesh::GenerateSphere(resolution, true, vertices, indices, thread_pool);
+        benchmark::DoNotOptimize(vertices.data());
+      });
+      std::printf("%13.1f", 1e3 * seconds);
+      std::fflush(stdout);
+    }
+    std::printf("\n");
+  }
+}
@@ -1,15 +1,22 @@
 #pragma once
 
 #include <cstdint>
+#include <filesystem>
 #include <string>
 #include <vector>
 
 #include "engine/camera.h"
 #include "engine/device.h"
+#include "engine/dynamic_mesh.h"
+#include "engine/frame_arena.h"
+#include "engine/mesh.h"
 #include "engine/model.h"
+#include "engine/procedural_sphere.h"
 #include "engine/renderer.h"
+#include "engine/slot_map.h"
 #include "engine/systems/model_render_system.h"
 #include "engine/systems/point_light_render_system.h"
+#include "engine/systems/procedural_sphere_render_system.h"
 #include "engine/window.h"
 #include "engine/texture.h"
 
@@ -18,6 +25,9 @@ struct ApplicationInfo {
   std::string title = "Application";
   uint32_t window_width = 800;
   uint32_t window_height = 600;
+
+  float memory_stats_interval = 0.0f;  // Seconds between memory stats dumps, disabled if zero
+  std::filesystem::path memory_stats_path;  // Overwritten with JSON on each dump, logged to stdout if empty
 };
 
 class Application {
@@ -35,18 +45,29 @@ class Application {
   Renderer renderer_{window_, device_};
   Camera camera_{window_};
   engine::TextureManager texture_manager_{device_};
+  engine::MeshManager mesh_manager_{device_};
 
-  std::vector<std::unique_ptr<Model>> models_;
+  SlotMap<Model> models_;
+  SlotMap<DynamicModel> dynamic_models_;
+  SlotMap<ProceduralSphere> procedural_spheres_;
 
  private:
   std::unique_ptr<engine::systems::ModelRenderSystem> model_render_system_;
   std::unique_ptr<engine::systems::PointLightRenderSystem> point_light_render_system_;
+  std::unique_ptr<engine::systems::ProceduralSphereRenderSystem> procedural_sphere_render_system_;
 
   // TODO Abstraction?
   std::vector<std::unique_ptr<Buffer>> uniform_buffers_{Swapchain::kMaxFramesInFlight};
+  std::vector<std::unique_ptr<FrameArena>> frame_arenas_{Swapchain::kMaxFramesInFlight};
   VkDescriptorSetLayout global_descriptor_set_layout_ = VK_NULL_HANDLE;
   std::vector<VkDescriptorSet> global_descriptor_sets_{Swapchain::kMaxFramesInFlight, VK_NULL_HANDLE};
 
+  float memory_stats_interval_;
+  std::filesystem::path memory_stats_path_;
+  float memory_stats_timer_ = 0.0f;
+
+  void WriteGlobalDescriptorSet(uint32_t frame_index);
   void DrawFrame();
+  void DumpMemoryStats() const;
 };
 }  // namespace engine
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "engine/math.h"
+#include "engine/transform.h"
+#include "engine/vertex.h"
+
+namespace engine {
+struct BoundingBox {
+  glm::vec3 min{0.0f};
+  glm::vec3 max{0.0f};
+
+  [[nodiscard]] glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+  [[nodiscard]] glm::vec3 GetExtent() const { return max - min; }
+};
+
+struct BoundingSphere {
+  glm::vec3 center{0.0f};
+  float radius = 0.0f;
+};
+
+struct Bounds {
+  BoundingBox box;
+  BoundingSphere sphere;
+
+  // Bounds after the transform, which only translates and scales uniformly so both stay exact
+  [[nodiscard]] Bounds Transformed(const Transform& transform) const;
+};
+
+// Bounding box of the positions, reduced with SSE2 or NEON depending on the target
+BoundingBox ComputeBoundingBox(const std::vector<Vertex>& vertices);
+// Box and the tighter of a Ritter sphere and the sphere around the box's center. The vertices must not be empty.
+Bounds ComputeBounds(const std::vector<Vertex>& vertices);
+}  // namespace engine
@@ -5,20 +5,27 @@
 namespace engine {
 class Buffer {
  public:
+  // Preferred memory property flags are used when a memory type with them exists, e.g. host-visible device-local
   Buffer(Device& device, VkDeviceSize size, VkBufferUsageFlags usage_flags,
-         VkMemoryPropertyFlags memory_property_flags);
+         VkMemoryPropertyFlags memory_property_flags, MemoryCategory memory_category,
+         VkMemoryPropertyFlags preferred_memory_property_flags = 0);
   ~Buffer();
 
   Buffer(const Buffer&) = delete;
   Buffer& operator=(const Buffer&) = delete;
 
   [[nodiscard]] VkBuffer GetHandle() const { return buffer_; }
+  [[nodiscard]] void* GetMappedMemory() const { return mapped_; }
+  // Host-visible memory is persistently mapped, so it can be written without a staging copy
+  [[nodiscard]] bool IsHostVisible() const { return allocation_.mapped != nullptr; }
 
   VkResult Map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
   void Unmap();
 
   void Write(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
-  void Flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+  void Flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+  // Writes through the persistent mapping and flushes, regardless of Map(). Must be host-visible.
+  void WriteDirect(const void* data, VkDeviceSize size, VkDeviceSize offset = 0) const;
 
   void CopyTo(const Buffer& dst, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize src_offset = 0, VkDeviceSize dst_offset = 0);
 
@@ -27,10 +34,11 @@ class Buffer {
 
   VkDeviceSize size_ = 0;
   VkBuffer buffer_ = VK_NULL_HANDLE;
-  VkDeviceMemory buffer_memory_ = VK_NULL_HANDLE;
+  MemoryAllocation allocation_{};
 
   void* mapped_ = nullptr;
 
-  void Create(VkDeviceSize size, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags);
+  void Create(VkDeviceSize size, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags,
+              MemoryCategory memory_category, VkMemoryPropertyFlags preferred_memory_property_flags);
 };
 }  // namespace engine
@@ -15,6 +15,7 @@ class Camera {
 
   [[nodiscard]] const glm::mat4& GetProjection() const { return projection_; }
   [[nodiscard]] const glm::mat4& GetView() const { return view_; }
+  [[nodiscard]] const glm::vec3& GetPosition() const { return position_; }
 
   void ProcessInput(float delta_time);
   void SetPerspective(float fov_y, float aspect, float near, float far);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace engine {
+// Defers the destruction of Vulkan objects until the GPU can no longer use them. Deleters are tagged with the frame
+// being recorded when they are enqueued, and run once the renderer has retired that frame, i.e. waited on its fence.
+// Resources can thus be released mid-session without vkDeviceWaitIdle.
+class DeletionQueue {
+ public:
+  DeletionQueue() = default;
+  ~DeletionQueue();
+
+  DeletionQueue(const DeletionQueue&) = delete;
+  DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+  [[nodiscard]] bool IsEmpty() const { return deleters_.empty(); }
+
+  void Enqueue(std::function<void()> deleter);
+
+  // Deleters enqueued from now on wait for the given frame.
+  void BeginFrame(uint64_t frame);
+  // Runs the deleters of all frames up to and including the given one.
+  void Retire(uint64_t frame);
+  // Runs all deleters, the device must be idle.
+  void Flush();
+
+ private:
+  uint64_t current_frame_ = 0;
+  std::deque<std::pair<uint64_t, std::function<void()>>> deleters_;  // Ordered by frame
+};
+}  // namespace engine
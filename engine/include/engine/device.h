@@ -2,6 +2,7 @@
 
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <vulkan/vulkan.h>
@@ -10,9 +11,14 @@
 #define ENABLE_VALIDATION_LAYERS
 #endif
 
+#include "engine/deletion_queue.h"
+#include "engine/memory_allocator.h"
 #include "engine/window.h"
 
 namespace engine {
+class GeometryArena;
+class StagingRing;
+
 struct SwapchainSupportDetails {
   VkSurfaceCapabilitiesKHR capabilities;
   std::vector<VkSurfaceFormatKHR> formats;
@@ -29,23 +35,50 @@ class Device {
 
   [[nodiscard]] VkDescriptorPool GetDescriptorPool() const { return descriptor_pool_; }
   [[nodiscard]] VkCommandPool GetGraphicsCommandPool() const { return graphics_command_pool_; }
+  [[nodiscard]] VkCommandPool GetTransferCommandPool() const { return transfer_command_pool_; }
   [[nodiscard]] VkDevice GetHandle() const { return device_; }
   [[nodiscard]] VkSurfaceKHR GetSurface() const { return surface_; }
+  [[nodiscard]] const VkPhysicalDeviceProperties& GetProperties() const { return physical_device_properties_; }
+  [[nodiscard]] const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return enabled_features_; }
 
   VkQueue GetGraphicsQueue() { return graphics_queue_; }
   [[nodiscard]] uint32_t GetGraphicsQueueFamilyIndex() const { return graphics_queue_family_index_; }
   VkQueue GetPresentQueue() { return present_queue_; }
   [[nodiscard]] uint32_t GetPresentQueueFamilyIndex() const { return present_queue_family_index_; }
+  VkQueue GetTransferQueue() { return transfer_queue_; }
+  [[nodiscard]] uint32_t GetTransferQueueFamilyIndex() const { return transfer_queue_family_index_; }
+  [[nodiscard]] bool HasDedicatedTransferQueue() const {
+    return transfer_queue_family_index_ != graphics_queue_family_index_;
+  }
 
-  [[nodiscard]] uint32_t QueryMemoryType(uint32_t type_filter, VkMemoryPropertyFlags memory_property_flags) const;
+  // Picks the best memory type with all required flags: the most preferred flags first, then the fewest unrequested
+  // flags (e.g. no device-local staging on discrete GPUs), then the largest heap.
+  [[nodiscard]] uint32_t QueryMemoryType(uint32_t type_filter, VkMemoryPropertyFlags required_flags,
+                                         VkMemoryPropertyFlags preferred_flags = 0) const;
   [[nodiscard]] VkFormat QuerySupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling,
                                               VkFormatFeatureFlags features) const;
   [[nodiscard]] SwapchainSupportDetails QuerySwapchainSupportDetails() const {
     return QuerySwapchainSupportDetails(physical_device_, surface_);
   }
 
-  VkCommandBuffer BeginSingleTimeCommands();
-  void EndSingleTimeCommands(VkCommandBuffer command_buffer);
+  // Integrated GPUs, all memory is device-local
+  [[nodiscard]] bool IsUnifiedMemory() const { return unified_memory_; }
+  // Device-local memory the host can write directly, either unified memory or a resizable BAR larger than the legacy
+  // 256 MiB window. Large resources can then skip staging copies.
+  [[nodiscard]] bool HasLargeHostVisibleDeviceLocalMemory() const { return large_host_visible_device_local_; }
+
+  [[nodiscard]] MemoryAllocator& GetMemoryAllocator() { return *memory_allocator_; }
+  MemoryAllocation AllocateMemory(const VkMemoryRequirements& memory_requirements,
+                                  VkMemoryPropertyFlags memory_property_flags, FreeListAllocator::ResourceKind kind,
+                                  MemoryCategory category, VkMemoryPropertyFlags preferred_memory_property_flags = 0);
+  void FreeMemory(MemoryAllocation& allocation) { memory_allocator_->Free(allocation); }
+  [[nodiscard]] bool HasMemoryBudget() const { return memory_budget_enabled_; }
+  [[nodiscard]] MemoryStats QueryMemoryStats() const;
+
+  // Resources that a submitted frame may still use must be destroyed through this
+  [[nodiscard]] DeletionQueue& GetDeletionQueue() { return deletion_queue_; }
+  [[nodiscard]] StagingRing& GetStagingRing() { return *staging_ring_; }
+  [[nodiscard]] GeometryArena& GetGeometryArena() { return *geometry_arena_; }
 
  private:
   Window& window_;
@@ -56,6 +89,14 @@ class Device {
 #endif
   VkPhysicalDevice physical_device_ = VK_NULL_HANDLE;
   VkPhysicalDeviceProperties physical_device_properties_{};
+  VkPhysicalDeviceFeatures enabled_features_{};
+
+  bool physical_device_properties2_enabled_ = false;
+  bool memory_budget_enabled_ = false;
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_physical_device_memory_properties2_ = nullptr;
+
+  bool unified_memory_ = false;
+  bool large_host_visible_device_local_ = false;
 
   VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkDevice device_ = VK_NULL_HANDLE;
@@ -63,8 +104,16 @@ class Device {
   uint32_t graphics_queue_family_index_ = 0;
   VkQueue present_queue_ = VK_NULL_HANDLE;
   uint32_t present_queue_family_index_ = 0;
+  VkQueue transfer_queue_ = VK_NULL_HANDLE;
+  uint32_t transfer_queue_family_index_ = 0;
 
   VkCommandPool graphics_command_pool_ = VK_NULL_HANDLE;
+  VkCommandPool transfer_command_pool_ = VK_NULL_HANDLE;
+
+  std::unique_ptr<MemoryAllocator> memory_allocator_;
+  DeletionQueue deletion_queue_;
+  std::unique_ptr<StagingRing> staging_ring_;
+  std::unique_ptr<GeometryArena> geometry_arena_;
 
   VkDescriptorPool descriptor_pool_ = VK_NULL_HANDLE;
 
@@ -77,10 +126,16 @@ class Device {
   void PickPhysicalDevice();
   void CreateLogicalDevice();
   void CreateGraphicsCommandPool();
+  void CreateTransferCommandPool();
+  void CreateMemoryAllocator();
+  void DetectMemoryArchitecture();
+  void CreateStagingRing();
+  void CreateGeometryArena();
   void CreateDescriptorPool();
 
   int32_t RatePhysicalDeviceSuitability(VkPhysicalDevice physical_device);
   static bool CheckPhysicalDeviceExtensionSupport(VkPhysicalDevice physical_device);
+  static bool CheckPhysicalDeviceExtensionSupport(VkPhysicalDevice physical_device, const char* extension_name);
 
   static SwapchainSupportDetails QuerySwapchainSupportDetails(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
 
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "engine/buffer.h"
+#include "engine/device.h"
+#include "engine/swap_chain.h"
+#include "engine/texture.h"
+#include "engine/transform.h"
+#include "engine/vertex.h"
+
+namespace engine {
+// Geometry rewritten from the CPU as often as every frame, e.g. deformations, terrain edits or debug geometry, where a
+// Mesh would have to be rebuilt and uploaded through staging. Writes go to a CPU copy. Each frame in flight has a
+// region of its own in a host-visible buffer, and Commit() brings the frame's region up to date by copying only what
+// was written since that region was last committed, so editing a few vertices copies a few vertices. Vertices are
+// interleaved 32-bit floats and indices 32-bit, the counts may change up to the capacities given at construction.
+class DynamicMesh {
+ public:
+  DynamicMesh(Device& device, uint32_t vertex_capacity, uint32_t index_capacity);
+  ~DynamicMesh() = default;
+
+  DynamicMesh(const DynamicMesh&) = delete;
+  DynamicMesh& operator=(const DynamicMesh&) = delete;
+  DynamicMesh(DynamicMesh&&) noexcept = default;
+  DynamicMesh& operator=(DynamicMesh&&) noexcept = default;
+
+  [[nodiscard]] uint32_t GetVertexCapacity() const { return vertex_capacity_; }
+  [[nodiscard]] uint32_t GetIndexCapacity() const { return index_capacity_; }
+  [[nodiscard]] std::span<const Vertex> GetVertices() const { return vertices_; }
+  [[nodiscard]] std::span<const uint32_t> GetIndices() const { return indices_; }
+
+  // Sets the counts drawn, within the capacities. Vertices and indices past the previous counts are zero until written.
+  void Resize(uint32_t vertex_count, uint32_t index_count);
+  // Range within the counts to be written before the next Commit(), the returned span is valid until Resize()
+  [[nodiscard]] std::span<Vertex> WriteVertices(uint32_t first_vertex, uint32_t vertex_count);
+  [[nodiscard]] std::span<uint32_t> WriteIndices(uint32_t first_index, uint32_t index_count);
+
+  // Copies the writes the frame's region is missing into it, once per frame before Bind(). The region's previous
+  // submission must have completed.
+  void Commit(uint32_t frame_index);
+  // Binds the last committed region
+  void Bind(VkCommandBuffer command_buffer) const;
+  void Draw(VkCommandBuffer command_buffer, uint32_t first_instance = 0) const;
+
+ private:
+  // Elements [begin, end) written since a region was last committed. Separate writes merge into the range covering
+  // both, which is exact for the common single edit per frame.
+  struct DirtyRange {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+
+    void Add(uint32_t first, uint32_t count);
+  };
+
+  std::unique_ptr<Buffer> buffer_;
+  uint32_t vertex_capacity_;
+  uint32_t index_capacity_;
+  VkDeviceSize region_size_;
+
+  std::vector<Vertex> vertices_;
+  std::vector<uint32_t> indices_;
+  std::array<DirtyRange, Swapchain::kMaxFramesInFlight> dirty_vertices_{};
+  std::array<DirtyRange, Swapchain::kMaxFramesInFlight> dirty_indices_{};
+  // Counts as of each region's last commit, those drawn from it
+  std::array<uint32_t, Swapchain::kMaxFramesInFlight> committed_index_counts_{};
+  uint32_t frame_index_ = 0;  // Of the last commit
+
+  [[nodiscard]] VkDeviceSize GetVertexOffset(uint32_t frame_index) const { return region_size_ * frame_index; }
+  [[nodiscard]] VkDeviceSize GetIndexOffset(uint32_t frame_index) const {
+    return region_size_ * frame_index + sizeof(Vertex) * static_cast<VkDeviceSize>(vertex_capacity_);
+  }
+  void MarkDirty(std::array<DirtyRange, Swapchain::kMaxFramesInFlight>& dirty_ranges, uint32_t first, uint32_t count);
+};
+
+// Drawn by systems::ModelRenderSystem along with the models
+struct DynamicModel {
+  Transform transform;
+  DynamicMesh mesh;
+  TextureHandle texture;
+};
+}  // namespace engine
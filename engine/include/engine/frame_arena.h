@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include <vulkan/vulkan.h>
+
+namespace engine {
+class Buffer;
+class Device;
+
+// Persistently mapped linear allocator for data that lives for a single frame, such as per-object blocks and indirect
+// draw commands. There is one arena per frame in flight, it is reset once the frame's previous submission has
+// completed. Allocations are bound either with a dynamic offset into GetBuffer() or, when the buffer is viewed as an
+// array through a storage buffer descriptor, by element index. A frame that asks for more than fits gets nothing for
+// the allocations past the end, and the arena grows to fit the whole frame when it is next reset.
+class FrameArena {
+ public:
+  static constexpr VkDeviceSize kDefaultSize = 4 * 1024 * 1024;
+
+  struct Allocation {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;
+  };
+
+  explicit FrameArena(Device& device, VkDeviceSize size = kDefaultSize);
+  ~FrameArena();
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  [[nodiscard]] const Buffer& GetBuffer() const { return *buffer_; }
+  [[nodiscard]] VkDeviceSize GetSize() const { return size_; }
+  [[nodiscard]] VkDeviceSize GetUsedSize() const { return head_; }
+  // Satisfies the offset alignment of both uniform and storage buffer descriptors
+  [[nodiscard]] VkDeviceSize GetMinAlignment() const { return min_alignment_; }
+
+  // Bytes that an allocation of the given alignment can still have this frame
+  [[nodiscard]] VkDeviceSize GetAvailableSize(VkDeviceSize alignment) const;
+
+  // Returns std::nullopt if the arena is out of memory for this frame
+  std::optional<Allocation> Allocate(VkDeviceSize size, VkDeviceSize alignment);
+  std::optional<Allocation> Allocate(VkDeviceSize size) { return Allocate(size, min_alignment_); }
+  // Allocates count elements at a whole element offset, returns them with the index of the first one, or nullptr if
+  // the arena is out of memory for this frame.
+  template <typename T>
+  std::pair<T*, uint32_t> AllocateElements(uint32_t count) {
+    const std::optional<Allocation> allocation = Allocate(sizeof(T) * count, sizeof(T));
+    if (!allocation) {
+      return {nullptr, 0};
+    }
+    return {static_cast<T*>(allocation->mapped), static_cast<uint32_t>(allocation->offset / sizeof(T))};
+  }
+
+  // Makes everything allocated this frame visible to the device
+  void Flush();
+  // Returns true if the arena grew into a new buffer, descriptors of the old one must then be rewritten. The old buffer
+  // is released once the frames in flight are done with it.
+  [[nodiscard]] bool Reset();
+
+ private:
+  Device& device_;
+
+  VkDeviceSize size_;
+  VkDeviceSize min_alignment_ = 1;
+  std::unique_ptr<Buffer> buffer_;
+  uint8_t* mapped_ = nullptr;
+
+  VkDeviceSize head_ = 0;
+  VkDeviceSize required_size_ = 0;  // What this frame would have needed, more than the size if allocations failed
+
+  void CreateBuffer();
+};
+}  // namespace engine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace engine {
+// Offset allocator for a contiguous range [0, size). Free ranges are kept in a size-ordered free-list and served
+// best-fit; neighbouring free ranges are coalesced on release.
+// Allocations are tagged linear (buffers) or optimal (tiled images), and neighbours of different kinds never share a
+// granularity page (bufferImageGranularity). Knows nothing about Vulkan, so it runs without a GPU.
+class FreeListAllocator {
+ public:
+  enum class ResourceKind : uint8_t {
+    kLinear,
+    kOptimal,
+  };
+
+  struct Statistics {
+    uint64_t size = 0;
+    uint64_t used = 0;
+    uint32_t allocation_count = 0;
+    uint32_t free_range_count = 0;
+    uint64_t largest_free_range = 0;
+  };
+
+  explicit FreeListAllocator(uint64_t size, uint64_t granularity = 1);
+
+  FreeListAllocator(const FreeListAllocator&) = delete;
+  FreeListAllocator& operator=(const FreeListAllocator&) = delete;
+
+  [[nodiscard]] uint64_t GetSize() const { return size_; }
+  [[nodiscard]] uint64_t GetUsed() const { return used_; }
+  [[nodiscard]] uint32_t GetAllocationCount() const { return allocation_count_; }
+  [[nodiscard]] bool IsEmpty() const { return allocation_count_ == 0; }
+
+  // Returns std::nullopt if no free range can hold the allocation.
+  std::optional<uint64_t> Allocate(uint64_t size, uint64_t alignment = 1, ResourceKind kind = ResourceKind::kLinear);
+  void Free(uint64_t offset);
+
+  [[nodiscard]] Statistics QueryStatistics() const;
+
+ private:
+  struct Range {
+    uint64_t size = 0;
+    bool free = true;
+    ResourceKind kind = ResourceKind::kLinear;
+  };
+
+  uint64_t size_;
+  uint64_t granularity_;
+  uint64_t used_ = 0;
+  uint32_t allocation_count_ = 0;
+
+  std::map<uint64_t, Range> ranges_;                // Offset -> range, covers [0, size_) without gaps
+  std::multimap<uint64_t, uint64_t> free_by_size_;  // Size -> offset of a free range
+
+  void InsertFree(uint64_t offset, uint64_t size);
+  void EraseFree(uint64_t offset, uint64_t size);
+
+  [[nodiscard]] bool OnSamePage(uint64_t end_of_first, uint64_t start_of_second) const;
+};
+}  // namespace engine
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <array>
+
+#include "engine/math.h"
+
+namespace engine {
+// View frustum as six inward-facing planes (xyz normal, w distance) in the space the matrix transforms from
+class Frustum {
+ public:
+  // Planes of a projection * view (* model) matrix with a [0, 1] depth range
+  explicit Frustum(const glm::mat4& matrix);
+
+  [[nodiscard]] bool IntersectsSphere(const glm::vec3& center, float radius) const;
+
+ private:
+  std::array<glm::vec4, 6> planes_{};
+};
+}  // namespace engine
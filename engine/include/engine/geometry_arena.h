@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "engine/free_list_allocator.h"
+#include "engine/vertex.h"
+
+namespace engine {
+class Buffer;
+class Device;
+
+// Offsets are in vertices and indices, as expected by the draw commands
+struct GeometryRange {
+  uint32_t page = 0;
+  int32_t vertex_offset = 0;
+  uint32_t vertex_count = 0;
+  uint32_t first_index = 0;
+  uint32_t index_count = 0;
+};
+
+// One indexed draw within a range, offsets are absolute in the page like the range's own
+struct DrawRange {
+  int32_t vertex_offset = 0;
+  uint32_t first_index = 0;
+  uint32_t index_count = 0;
+};
+
+// Geometry of different formats never shares a page
+struct GeometryFormat {
+  VertexFormat vertex_format = VertexFormat::kFloat32;
+  VertexStreams vertex_streams = VertexStreams::kInterleaved;
+  VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+
+  bool operator==(const GeometryFormat&) const = default;
+};
+
+[[nodiscard]] inline uint32_t GetIndexSize(VkIndexType index_type) {
+  return index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+// Shared vertex and index buffers for all meshes. Ranges are sub-allocated from pages, each page being a pair of
+// device-local vertex and index buffers, so everything on a page is drawn with a single bind. A page holds vertices of
+// a single format: vertex format, streams and index type. Split pages have a position buffer next to the attribute
+// buffer. Geometry larger than a default page gets a page of its own.
+class GeometryArena {
+ public:
+  static constexpr uint32_t kDefaultPageVertexCount = 1024 * 1024;
+  static constexpr uint32_t kDefaultPageIndexCount = 4 * 1024 * 1024;
+
+  explicit GeometryArena(Device& device);
+  ~GeometryArena();
+
+  GeometryArena(const GeometryArena&) = delete;
+  GeometryArena& operator=(const GeometryArena&) = delete;
+
+  [[nodiscard]] uint32_t GetPageCount() const { return static_cast<uint32_t>(pages_.size()); }
+  // Interleaved vertices, or the attribute stream of a split page
+  [[nodiscard]] const Buffer& GetVertexBuffer(uint32_t page) const { return *pages_[page]->vertex_buffer; }
+  [[nodiscard]] const Buffer& GetPositionBuffer(uint32_t page) const { return *pages_[page]->position_buffer; }
+  [[nodiscard]] const Buffer& GetIndexBuffer(uint32_t page) const { return *pages_[page]->index_buffer; }
+  [[nodiscard]] const GeometryFormat& GetFormat(uint32_t page) const { return pages_[page]->format; }
+
+  GeometryRange Allocate(const GeometryFormat& format, uint32_t vertex_count, uint32_t index_count);
+  void Free(GeometryRange& range);
+
+  // Binds every stream of the page and its index buffer
+  void Bind(VkCommandBuffer command_buffer, uint32_t page) const;
+  // Binds only the position stream of a split page and its index buffer, for pipelines using a PositionLayout
+  void BindPositions(VkCommandBuffer command_buffer, uint32_t page) const;
+
+ private:
+  struct Page {
+    GeometryFormat format;
+    std::unique_ptr<Buffer> position_buffer;  // Split pages only
+    std::unique_ptr<Buffer> vertex_buffer;
+    std::unique_ptr<Buffer> index_buffer;
+    FreeListAllocator vertices;
+    FreeListAllocator indices;
+
+    Page(const GeometryFormat& format, uint32_t vertex_capacity, uint32_t index_capacity);
+    ~Page();
+  };
+
+  Device& device_;
+
+  std::vector<std::unique_ptr<Page>> pages_;  // Never shrinks, a range refers to its page by index
+
+  Page& CreatePage(const GeometryFormat& format, uint32_t vertex_capacity, uint32_t index_capacity);
+};
+}  // namespace engine
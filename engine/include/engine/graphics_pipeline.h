@@ -13,8 +13,8 @@ namespace engine {
 struct GraphicsPipelineConfig {
   VkPipelineCreateFlags flags = 0;
 
-  std::array<VkVertexInputBindingDescription, 1> vertex_binding_descriptions = Vertex::BindingDescriptions();
-  std::array<VkVertexInputAttributeDescription, 4> vertex_attribute_descriptions = Vertex::AttributeDescriptions();
+  std::vector<VkVertexInputBindingDescription> vertex_binding_descriptions;
+  std::vector<VkVertexInputAttributeDescription> vertex_attribute_descriptions;
 
   VkPipelineVertexInputStateCreateInfo vertex_input_info{};
   VkPipelineInputAssemblyStateCreateInfo input_assembly_info{};
@@ -36,7 +36,22 @@ struct GraphicsPipelineConfig {
   VkPipeline base_pipeline_handle{};
   int32_t base_pipeline_index{};
 
-  static GraphicsPipelineConfig Default();
+  static GraphicsPipelineConfig Default(VertexFormat vertex_format = VertexFormat::kFloat32,
+                                        VertexStreams vertex_streams = VertexStreams::kInterleaved);
+
+  // Also point vertex_input_info at the new descriptions
+  void SetVertexFormat(VertexFormat vertex_format, VertexStreams vertex_streams = VertexStreams::kInterleaved);
+  template <typename Layout>
+  void SetVertexLayout() {
+    constexpr auto binding_descriptions = Layout::BindingDescriptions();
+    constexpr auto attribute_descriptions = Layout::AttributeDescriptions();
+    vertex_binding_descriptions.assign(binding_descriptions.begin(), binding_descriptions.end());
+    vertex_attribute_descriptions.assign(attribute_descriptions.begin(), attribute_descriptions.end());
+    UpdateVertexInputInfo();
+  }
+
+ private:
+  void UpdateVertexInputInfo();
 };
 
 class GraphicsPipeline {
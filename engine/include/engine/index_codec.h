@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+// Compression of triangle-list indices for storage on disk. Each triangle is a code byte that either refers to an
+// edge of a recent triangle, leaving only the third vertex to encode, or encodes all three vertices. Vertices are
+// predicted as the next unseen index or one past the last encoded one, else stored as a zigzag varint delta. Grids in
+// vertex fetch order compress to a byte per triangle. Triangles sharing an edge may come back rotated, the winding is
+// preserved.
+std::vector<uint8_t> EncodeIndices(const std::vector<uint32_t>& indices);
+// Throws if the data is not a valid encoding of index_count indices. Indices are not range checked, corrupt data may
+// decode to indices past the vertices.
+std::vector<uint32_t> DecodeIndices(const uint8_t* data, size_t size, uint32_t index_count);
+}  // namespace engine
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "engine/free_list_allocator.h"
+#include "engine/memory_stats.h"
+
+namespace engine {
+struct MemoryBlock;
+
+struct MemoryAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  uint32_t memory_type_index = 0;
+  void* mapped = nullptr;  // Points at offset, only for host-visible memory
+  MemoryCategory category = MemoryCategory::kOther;
+  MemoryBlock* block = nullptr;
+};
+
+// Sub-allocates buffers and images from large VkDeviceMemory blocks, one block list per memory type.
+// Host-visible blocks stay mapped for their whole lifetime, so allocations expose a ready-to-use pointer.
+class MemoryAllocator {
+ public:
+  static constexpr VkDeviceSize kDefaultBlockSize = 64 * 1024 * 1024;
+
+  MemoryAllocator(VkDevice device, VkPhysicalDevice physical_device);
+  ~MemoryAllocator();
+
+  MemoryAllocator(const MemoryAllocator&) = delete;
+  MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+  [[nodiscard]] const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return memory_properties_; }
+
+  MemoryAllocation Allocate(const VkMemoryRequirements& memory_requirements, uint32_t memory_type_index,
+                            FreeListAllocator::ResourceKind kind, MemoryCategory category);
+  void Free(MemoryAllocation& allocation);
+
+  void Flush(const MemoryAllocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+
+  // Heap budget and usage are left for the caller, see Device::QueryMemoryStats()
+  [[nodiscard]] MemoryStats QueryStats() const;
+
+ private:
+  VkDevice device_;
+  VkPhysicalDeviceMemoryProperties memory_properties_{};
+  VkDeviceSize buffer_image_granularity_ = 1;
+  VkDeviceSize non_coherent_atom_size_ = 1;
+  uint32_t max_memory_allocation_count_ = 0;
+  uint32_t memory_allocation_count_ = 0;
+
+  std::array<std::vector<std::unique_ptr<MemoryBlock>>, VK_MAX_MEMORY_TYPES> blocks_;
+  std::array<MemoryCategoryStatistics, kMemoryCategoryCount> category_stats_{};
+
+  [[nodiscard]] VkDeviceSize PreferredBlockSize(uint32_t memory_type_index) const;
+  MemoryBlock& CreateBlock(uint32_t memory_type_index, VkDeviceSize size, bool dedicated);
+  void DestroyBlock(MemoryBlock& block);
+};
+}  // namespace engine
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include <vulkan/vulkan.h>
+
+namespace engine {
+enum class MemoryCategory : uint8_t {
+  kGeometry,
+  kTexture,
+  kDepthAttachment,
+  kUniform,
+  kStaging,
+  kOther,
+};
+inline constexpr uint32_t kMemoryCategoryCount = 6;
+
+const char* ToString(MemoryCategory category);
+
+struct MemoryStatistics {
+  uint32_t block_count = 0;
+  uint32_t allocation_count = 0;
+  VkDeviceSize block_bytes = 0;
+  VkDeviceSize allocation_bytes = 0;
+};
+
+struct MemoryCategoryStatistics {
+  uint32_t allocation_count = 0;
+  VkDeviceSize allocation_bytes = 0;
+};
+
+struct MemoryHeapBudget {
+  VkDeviceSize size = 0;
+  VkDeviceSize block_bytes = 0;  // Allocated by the engine
+  // Process-wide, from VK_EXT_memory_budget. Without it, the heap size and the engine's blocks.
+  VkDeviceSize budget = 0;
+  VkDeviceSize usage = 0;
+};
+
+struct MemoryStats {
+  MemoryStatistics total;
+  std::array<MemoryStatistics, VK_MAX_MEMORY_TYPES> memory_types{};
+  std::array<MemoryCategoryStatistics, kMemoryCategoryCount> categories{};
+
+  bool has_budget = false;  // Whether VK_EXT_memory_budget reported the heap budgets
+  uint32_t heap_count = 0;
+  std::array<MemoryHeapBudget, VK_MAX_MEMORY_HEAPS> heaps{};
+
+  [[nodiscard]] const MemoryCategoryStatistics& GetCategory(MemoryCategory category) const {
+    return categories[static_cast<uint32_t>(category)];
+  }
+};
+
+// Human-readable summary in MiB, one line per heap and category.
+void LogMemoryStats(std::ostream& os, const MemoryStats& stats);
+// All values in bytes.
+void WriteMemoryStatsJson(std::ostream& os, const MemoryStats& stats);
+}  // namespace engine
@@ -2,37 +2,138 @@
 
 #include <filesystem>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <vulkan/vulkan.h>
 
+#include <engine/bounds.h>
 #include <engine/buffer.h>
 #include <engine/device.h>
+#include <engine/geometry_arena.h>
+#include <engine/mesh_bvh.h>
+#include <engine/mesh_simplifier.h>
+#include <engine/meshlet.h>
+#include <engine/slot_map.h>
+#include <engine/thread_pool.h>
+#include <engine/upload_batch.h>
 #include <engine/vertex.h>
 
 namespace engine {
+class Mesh;
+class MeshManager;
+
+using MeshHandle = Handle<Mesh>;
+
+struct MeshOptions {
+  VertexFormat vertex_format = VertexFormat::kFloat32;
+  VertexStreams vertex_streams = VertexStreams::kInterleaved;
+  // Split into meshlets that are culled individually, worth it for large meshes only
+  bool meshlets = false;
+  // Levels of detail generated with BuildLodChain(), one for the full detail mesh only
+  uint32_t lod_count = 1;
+  // Build a MeshBvh of the full detail triangles for ray queries on the CPU
+  bool bvh = false;
+};
+
+// Quadtree node of a cube face: cell (x, y) of the face's 2^level by 2^level grid
+struct CubeSpherePatch {
+  uint32_t face = 0;
+  uint32_t level = 0;
+  uint32_t x = 0;
+  uint32_t y = 0;
+};
+
+struct MeshLod {
+  float error = 0.0f;  // See LodLevel::error
+  std::vector<DrawRange> draw_ranges;
+};
 
 class Mesh {
  public:
-  Mesh(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices = {});
+  Mesh(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices = {},
+       const MeshOptions& options = {});
+  Mesh(Device& device, UploadBatch& upload_batch, const std::vector<Vertex>& vertices,
+       const std::vector<uint32_t>& indices = {}, const MeshOptions& options = {});
   ~Mesh();
 
   Mesh(const Mesh&) = delete;
   Mesh& operator=(const Mesh&) = delete;
+  Mesh(Mesh&& other) noexcept;
+  Mesh& operator=(Mesh&& other) noexcept;
+
+  // Cube-sphere with cube_face_resolution^2 grid points per face. Welded faces share their edge and corner vertices,
+  // only vertices along the texture's U seam are duplicated. Otherwise each face has vertices of its own.
+  static MeshHandle CreateSphereMesh(MeshManager& manager, uint32_t cube_face_resolution, bool welded = true,
+                                     const MeshOptions& options = {});
+  static MeshHandle CreateSphereMesh(MeshManager& manager, UploadBatch& upload_batch, uint32_t cube_face_resolution,
+                                     bool welded = true, const MeshOptions& options = {});
+  // The vertices and indices of CreateSphereMesh() before optimization, faces in order. The faces are generated in
+  // parallel on the thread pool, so not to be called from its tasks.
+  static void GenerateSphere(uint32_t cube_face_resolution, bool welded, std::vector<Vertex>& vertices,
+                             std::vector<uint32_t>& indices, ThreadPool& thread_pool = ThreadPool::Get());
+  // Unit sphere part over the patch with resolution^2 grid points, like those of CreateSphereMesh(). A skirt sinks
+  // skirt_depth below each edge to hide cracks against neighbouring patches of another level. Safe to call from worker
+  // threads.
+  static void GenerateSpherePatch(const CubeSpherePatch& patch, uint32_t resolution, float skirt_depth,
+                                  std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
 
-  static std::unique_ptr<Mesh> CreateSphereMesh(Device& device, uint32_t cube_face_resolution);
+  [[nodiscard]] const GeometryRange& GetGeometry() const { return geometry_; }
+  // In the mesh's space, covering every level of detail
+  [[nodiscard]] const Bounds& GetBounds() const { return bounds_; }
+  // Meshes too large for 16-bit indices may be drawn in several chunks
+  [[nodiscard]] const std::vector<DrawRange>& GetDrawRanges(uint32_t lod = 0) const { return lods_[lod].draw_ranges; }
+  // Level 0 is the full detail mesh, each further level has about half the triangles of the previous one
+  [[nodiscard]] uint32_t GetLodCount() const { return static_cast<uint32_t>(lods_.size()); }
+  [[nodiscard]] float GetLodError(uint32_t lod) const { return lods_[lod].error; }
+  // Empty unless built with MeshOptions::meshlets, level 0 only. Each meshlet is drawn with the draw range at the same
+  // index.
+  [[nodiscard]] const std::vector<Meshlet>& GetMeshlets() const { return meshlets_; }
+  [[nodiscard]] const std::vector<DrawRange>& GetMeshletDrawRanges() const { return meshlet_draw_ranges_; }
+  // Null unless built with MeshOptions::bvh. The triangles are those of the indices the mesh was created with.
+  [[nodiscard]] const MeshBvh* GetBvh() const { return bvh_.get(); }
+  [[nodiscard]] VertexFormat GetVertexFormat() const { return options_.vertex_format; }
+  [[nodiscard]] VertexStreams GetVertexStreams() const { return options_.vertex_streams; }
+  [[nodiscard]] const VertexDequantization& GetDequantization() const { return dequantization_; }
 
   void Bind(VkCommandBuffer command_buffer) const;
+  // Split streams only, see GeometryArena::BindPositions()
+  void BindPositions(VkCommandBuffer command_buffer) const;
   void Draw(VkCommandBuffer command_buffer) const;
 
  private:
-  std::unique_ptr<Buffer> vertex_buffer_;
-  uint32_t vertex_count_ = 0;
+  Device* device_;
+  GeometryArena* geometry_arena_;
+  GeometryRange geometry_{};  // Empty once moved from
+  Bounds bounds_;
+  std::vector<MeshLod> lods_;
+  std::vector<Meshlet> meshlets_;
+  std::vector<DrawRange> meshlet_draw_ranges_;
+  std::unique_ptr<MeshBvh> bvh_;
+  MeshOptions options_;
+  VertexDequantization dequantization_;
 
-  std::unique_ptr<Buffer> index_buffer_;
-  uint32_t index_count_ = 0;
+  void CreateGeometry(UploadBatch& upload_batch, const std::vector<Vertex>& vertices,
+                      const std::vector<uint32_t>& indices);
+};
+
+class MeshManager {
+ public:
+  explicit MeshManager(Device& device) : device_{device} {}
+
+  MeshManager(const MeshManager&) = delete;
+  MeshManager& operator=(const MeshManager&) = delete;
+
+  [[nodiscard]] Device& GetDevice() const { return device_; }
+
+  MeshHandle Add(Mesh mesh) { return meshes_.Insert(std::move(mesh)); }
+  void Remove(MeshHandle handle) { meshes_.Remove(handle); }
+  // Null if the mesh has been removed
+  [[nodiscard]] const Mesh* Get(MeshHandle handle) const { return meshes_.Get(handle); }
+
+ private:
+  Device& device_;
 
-  void CreateVertexBuffer(Device& device, const std::vector<Vertex>& vertices);
-  void CreateIndexBuffer(Device& device, const std::vector<uint32_t>& indices);
+  SlotMap<Mesh> meshes_;
 };
 }  // namespace engine
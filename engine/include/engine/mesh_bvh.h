@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "engine/math.h"
+#include "engine/vertex.h"
+
+namespace engine {
+struct Ray {
+  glm::vec3 origin{0.0f};
+  glm::vec3 direction{0.0f, 0.0f, -1.0f};  // Need not be normalized
+  float max_t = std::numeric_limits<float>::max();  // May be infinite
+};
+
+struct RayHit {
+  float t = 0.0f;  // The hit is at origin + t * direction
+  uint32_t triangle = 0;  // Index of the triangle's first index divided by three
+  glm::vec2 barycentrics{0.0f};  // Weights of the triangle's second and third vertex
+};
+
+// Bounding volume hierarchy over a mesh's triangles for ray queries on the CPU, e.g. picking. Built top-down with the
+// surface area heuristic, then collapsed into nodes of four children laid out depth-first. The child boxes and the
+// leaf triangles are stored as structures of arrays, so that a ray is tested against four of either at once with SSE2
+// or NEON. Keeps a copy of the triangles of its own, as the mesh's vertices may be quantized or on the GPU only.
+class MeshBvh {
+ public:
+  // Large meshes are built in parallel on the shared thread pool, so not to be constructed from its tasks
+  MeshBvh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+  // Nearest hit with t in [0, ray.max_t]
+  [[nodiscard]] std::optional<RayHit> Intersect(const Ray& ray) const;
+  // Whether there is any hit with t in [0, ray.max_t], cheaper than Intersect() e.g. for visibility tests
+  [[nodiscard]] bool IntersectsAny(const Ray& ray) const;
+
+  [[nodiscard]] uint32_t GetNodeCount() const { return static_cast<uint32_t>(nodes_.size()); }
+
+ private:
+  // Two cache lines. Unused children have neither a child index nor triangle blocks.
+  struct alignas(64) Node {
+    std::array<float, 4> min_x{};
+    std::array<float, 4> min_y{};
+    std::array<float, 4> min_z{};
+    std::array<float, 4> max_x{};
+    std::array<float, 4> max_y{};
+    std::array<float, 4> max_z{};
+    std::array<uint32_t, 4> children{};  // Node index of an inner child, first triangle block of a leaf, zero if unused
+    std::array<uint32_t, 4> block_counts{};  // Triangle blocks of a leaf, zero for inner children
+  };
+  // Four triangles as a vertex and the edges from it. Leaves are padded with degenerate triangles that no ray hits.
+  struct alignas(16) TriangleBlock {
+    std::array<float, 4> v0_x{};
+    std::array<float, 4> v0_y{};
+    std::array<float, 4> v0_z{};
+    std::array<float, 4> e1_x{};
+    std::array<float, 4> e1_y{};
+    std::array<float, 4> e1_z{};
+    std::array<float, 4> e2_x{};
+    std::array<float, 4> e2_y{};
+    std::array<float, 4> e2_z{};
+    std::array<uint32_t, 4> triangles{};
+  };
+
+  std::vector<Node> nodes_;  // Root first, empty if there are no triangles
+  std::vector<TriangleBlock> triangle_blocks_;
+
+  // Stops at the first hit if kAnyHit, otherwise finds the nearest one
+  template <bool kAnyHit>
+  bool Traverse(const Ray& ray, RayHit& hit) const;
+};
+}  // namespace engine
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "engine/vertex.h"
+
+namespace engine {
+// Size of the FIFO post-transform cache the optimizer targets and simulates, conservative for current GPUs
+constexpr uint32_t kVertexCacheSize = 16;
+
+struct VertexCacheStatistics {
+  float acmr = 0.0f;  // Average cache miss ratio, transformed vertices per triangle: 0.5 at best, 3 at worst
+  float atvr = 0.0f;  // Average transform to vertex ratio, transformed vertices per vertex: 1 at best
+};
+
+struct MeshOptimizationStatistics {
+  VertexCacheStatistics before;
+  VertexCacheStatistics after;
+};
+
+// Simulates a FIFO post-transform cache over a triangle list
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertex_count,
+                                         uint32_t cache_size = kVertexCacheSize);
+
+// Reorders triangles for the post-transform cache with Tipsify (Sander et al. 2007), fanning around recently
+// transformed vertices. Returns the first triangle of each cluster, a cluster ending where the fanning ran into a dead
+// end.
+std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertex_count,
+                                          uint32_t cache_size = kVertexCacheSize);
+// Reorders the clusters of OptimizeVertexCache() so that those facing out from the mesh's center are drawn first,
+// occluding the rest from most view directions. Clusters are split further where the cache miss ratio of a part stays
+// within threshold times the whole cluster's.
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                      const std::vector<uint32_t>& clusters, float threshold = 1.05f);
+// Renumbers vertices in the order the indices first use them, so vertex fetch walks memory forward. Unused vertices
+// are dropped.
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// All of the above, in order, on a triangle list. A non-zero segment_triangle_count optimizes segments of that many
+// consecutive triangles independently on the worker pool, for large meshes whose triangle order is already spatially
+// coherent, e.g. generated ones; a segment of scattered triangles would leave most of the cache misses in place.
+MeshOptimizationStatistics OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                        uint32_t segment_triangle_count = 0);
+
+// One line with the ACMR and ATVR before and after
+void LogMeshOptimizationStatistics(std::ostream& os, const MeshOptimizationStatistics& statistics);
+}  // namespace engine
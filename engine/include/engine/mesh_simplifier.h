@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "engine/vertex.h"
+
+namespace engine {
+constexpr uint32_t kMaxLodCount = 6;
+
+// A level of detail as a range of a shared index buffer
+struct LodLevel {
+  uint32_t first_index = 0;
+  uint32_t index_count = 0;
+  // Estimated deviation from the full detail surface, in the mesh's units: the root mean square of the distances to
+  // the planes of the triangles merged, weighted by area. Not a bound, single vertices may deviate further.
+  float error = 0.0f;
+};
+
+// Collapses edges in order of quadric error (Garland & Heckbert 1997) until at most target_index_count indices remain
+// or the next collapse would deviate more than max_error. Vertices are collapsed onto their neighbours rather than
+// moved, so the result indexes the same vertices. Open borders and UV seams only collapse along themselves. The error
+// of a collapse is the root mean square of the distances to the planes merged, weighted by area with borders and
+// seams weighted up. The largest error of the collapses made is written to error, if given.
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                   size_t target_index_count, float max_error = std::numeric_limits<float>::max(),
+                                   float* error = nullptr);
+
+// Appends successively halved levels of detail to the indices, each simplified from the previous one and optimized for
+// the vertex cache. Returns the levels, the given indices first. A level's error adds up those of the
+// simplifications leading to it. Stops early once a level no longer shrinks.
+std::vector<LodLevel> BuildLodChain(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                    uint32_t max_lod_count = kMaxLodCount);
+}  // namespace engine
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "engine/math.h"
+#include "engine/vertex.h"
+
+namespace engine {
+constexpr uint32_t kMaxMeshletVertices = 64;
+constexpr uint32_t kMaxMeshletTriangles = 124;
+
+// Culling data in the mesh's space
+struct MeshletBounds {
+  glm::vec3 center{0.0f};
+  float radius = 0.0f;
+  // All triangle normals are within the cone around the axis, cone_cutoff being the sine of its half-angle. A cutoff
+  // of 1 never culls, e.g. when the normals spread over more than a hemisphere.
+  glm::vec3 cone_axis{0.0f, 0.0f, 1.0f};
+  float cone_cutoff = 1.0f;
+
+  // Whether every triangle faces away from a viewer at the position
+  [[nodiscard]] bool IsBackfacing(const glm::vec3& view_position) const {
+    const glm::vec3 offset = center - view_position;
+    return glm::dot(offset, cone_axis) > cone_cutoff * glm::length(offset) + radius;
+  }
+};
+
+// Consecutive triangles of an index buffer, small enough to be culled as a unit
+struct Meshlet {
+  uint32_t first_triangle = 0;
+  uint32_t triangle_count = 0;
+  uint32_t vertex_count = 0;  // Unique vertices
+  MeshletBounds bounds;
+};
+
+// Groups the triangles, in order, into meshlets of at most max_vertices unique vertices and max_triangles triangles.
+// Triangles are not reordered, so the index buffer should already be in a spatially coherent order such as that of
+// OptimizeMesh(); a triangle sharing no vertex with a meshlet that is a quarter full starts a new one. Deterministic,
+// the meshlets depend only on the input.
+std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                   uint32_t max_vertices = kMaxMeshletVertices,
+                                   uint32_t max_triangles = kMaxMeshletTriangles);
+MeshletBounds ComputeMeshletBounds(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                   uint32_t first_triangle, uint32_t triangle_count);
+}  // namespace engine
@@ -1,23 +1,32 @@
 #pragma once
 
 #include <filesystem>
-#include <memory>
-#include <utility>
+#include <optional>
 #include <vector>
 
+#include "engine/bounds.h"
 #include "engine/device.h"
 #include "engine/mesh.h"
+#include "engine/mesh_bvh.h"
 #include "engine/transform.h"
+#include "engine/upload_batch.h"
 #include "engine/vertex.h"
 #include "texture.h"
 
 namespace engine {
+// Levels of detail are built at load time from the cached full detail mesh. A BVH for picking is opt-in, it costs
+// memory and load time that most models don't need.
+constexpr MeshOptions kModelMeshOptions{.lod_count = kMaxLodCount};
+
 struct ModelLoader {
-  std::shared_ptr<Mesh> mesh;
+  MeshHandle mesh;
 
-  void Load(Device& device, const std::filesystem::path& file_path);
+  void Load(MeshManager& mesh_manager, UploadBatch& upload_batch, const std::filesystem::path& file_path,
+            const MeshOptions& options = kModelMeshOptions);
 };
 
+// Meshes and textures are referenced by handle, so they can be shared between models and removed from their managers
+// without leaving dangling pointers behind. A model whose mesh has been removed is not drawn.
 class Model {
  public:
   Model() = default;
@@ -25,20 +34,31 @@ class Model {
 
   Model(const Model&) = delete;
   Model& operator=(const Model&) = delete;
+  Model(Model&&) noexcept = default;
+  Model& operator=(Model&&) noexcept = default;
 
-  static std::unique_ptr<Model> CreateFromFile(Device& device, const std::filesystem::path& file_path);
+  static Model CreateFromFile(MeshManager& mesh_manager, const std::filesystem::path& file_path,
+                              const MeshOptions& options = kModelMeshOptions);
+  static Model CreateFromFile(MeshManager& mesh_manager, UploadBatch& upload_batch,
+                              const std::filesystem::path& file_path, const MeshOptions& options = kModelMeshOptions);
 
   Transform& GetTransform() { return transform_; }
-  void AttachMesh(std::shared_ptr<Mesh> mesh) { mesh_ = std::move(mesh); }
-  void AttachTexture(Texture* texture) { texture_ = texture; }
-
-  void Bind(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) const;
-  void Draw(VkCommandBuffer command_buffer) const;
+  [[nodiscard]] const Transform& GetTransform() const { return transform_; }
+  [[nodiscard]] MeshHandle GetMesh() const { return mesh_; }
+  [[nodiscard]] TextureHandle GetTexture() const { return texture_; }
+  // The mesh's bounds in world space, none if the mesh has been removed
+  [[nodiscard]] std::optional<Bounds> GetWorldBounds(const MeshManager& mesh_manager) const;
+  // Nearest hit of a world-space ray, none if the mesh has been removed or has no BVH, see MeshOptions::bvh
+  [[nodiscard]] std::optional<RayHit> Intersect(const MeshManager& mesh_manager, const Ray& ray) const;
+  void AttachMesh(MeshHandle mesh) { mesh_ = mesh; }
+  void AttachTexture(TextureHandle texture) { texture_ = texture; }
 
  private:
   Transform transform_;
 
-  std::shared_ptr<Mesh> mesh_;
-  Texture* texture_ = nullptr;
+  MeshHandle mesh_;
+  TextureHandle texture_;
 };
+
+using ModelHandle = Handle<Model>;
 }  // namespace engine
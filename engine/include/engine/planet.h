@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "engine/math.h"
+#include "engine/mesh.h"
+#include "engine/model.h"
+#include "engine/slot_map.h"
+#include "engine/texture.h"
+#include "engine/transform.h"
+
+namespace engine {
+struct PlanetInfo {
+  uint32_t patch_resolution = 33;  // Grid points along a patch edge
+  uint32_t max_level = 12;
+  // A patch splits once the camera is closer to it than split_distance times its size
+  float split_distance = 3.0f;
+  // Patches being generated on the worker pool, and patches uploaded per Update(), at most
+  uint32_t max_patch_updates = 16;
+  MeshOptions mesh_options{.vertex_format = VertexFormat::kSnorm16};
+};
+
+// Cube-sphere whose six faces are quadtrees of fixed-resolution patches, each drawn as a model of its own. Patches
+// split as the camera approaches and merge as it moves away; patches behind the horizon never split, so the triangle
+// count follows what can be seen rather than the worst case. Missing patches are generated by background jobs on the
+// worker pool, which Update() never waits for, and uploaded a few per frame once done; their parent stays drawn until
+// all four children are ready. Interior nodes keep their meshes, so merging is immediate.
+class Planet {
+ public:
+  Planet(MeshManager& mesh_manager, SlotMap<Model>& models, TextureHandle texture, const Transform& transform = {},
+         const PlanetInfo& info = {});
+  ~Planet();
+
+  Planet(const Planet&) = delete;
+  Planet& operator=(const Planet&) = delete;
+
+  // Splits and merges patches for the camera and generates missing ones, once per frame before rendering
+  void Update(const glm::vec3& camera_position);
+
+  [[nodiscard]] uint32_t GetDrawnPatchCount() const { return drawn_patch_count_; }
+  [[nodiscard]] uint32_t GetDrawnTriangleCount() const { return drawn_triangle_count_; }
+
+  // Whether a bounding sphere of the unit sphere's surface is entirely behind the horizon seen from the camera, with
+  // both in the planet's unit space. Never true for a camera inside the unit sphere.
+  [[nodiscard]] static bool IsBehindHorizon(const glm::vec3& center, float radius, const glm::vec3& camera_position);
+  // Whether a patch with the given bounds is to be drawn as its four children, split telling whether it is already. A
+  // split patch only merges once the camera is somewhat further than the split distance, so that a camera hovering
+  // around it doesn't keep regenerating the same patches.
+  [[nodiscard]] static bool ShouldSplit(const CubeSpherePatch& patch, const glm::vec3& center, float radius, bool split,
+                                        const glm::vec3& camera_position, const PlanetInfo& info);
+
+ private:
+  // Written by a job on the worker pool, shared so that a node destroyed meanwhile leaves the job a place to write to
+  struct PatchGeometry {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::atomic<bool> ready = false;
+  };
+
+  struct Node {
+    CubeSpherePatch patch;
+    std::shared_ptr<PatchGeometry> geometry;  // While being generated and until uploaded
+    MeshHandle mesh;  // Null until uploaded
+    ModelHandle model;  // Null unless drawn
+    glm::vec3 center{0.0f};  // Bounding sphere on the unit sphere
+    float radius = 0.0f;
+    uint32_t triangle_count = 0;
+    std::array<std::unique_ptr<Node>, 4> children;
+  };
+
+  MeshManager& mesh_manager_;
+  SlotMap<Model>& models_;
+  TextureHandle texture_;
+  Transform transform_;
+  PlanetInfo info_;
+
+  std::array<std::unique_ptr<Node>, 6> roots_;
+  std::vector<Node*> pending_nodes_;  // Waiting for their mesh, rebuilt each Update()
+  uint32_t drawn_patch_count_ = 0;
+  uint32_t drawn_triangle_count_ = 0;
+
+  void UpdateNode(Node& node, const glm::vec3& camera_position);
+  // Uploads the pending nodes whose geometry is ready and starts generating that of further ones
+  void GeneratePendingNodes(const glm::vec3& camera_position);
+
+  void Show(Node& node);
+  void Hide(Node& node);
+  void DestroyChildren(Node& node);
+};
+}  // namespace engine
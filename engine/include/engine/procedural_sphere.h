@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+#include "engine/texture.h"
+#include "engine/transform.h"
+
+namespace engine {
+// Unit cube-sphere computed entirely in the vertex shader, with no vertex or index buffers; the geometry matches
+// Mesh::CreateSphereMesh() for the resolution. Drawn by systems::ProceduralSphereRenderSystem.
+struct ProceduralSphere {
+  Transform transform;
+  uint32_t cube_face_resolution = 512;  // Grid points along a cube face edge
+  TextureHandle texture;
+};
+}  // namespace engine
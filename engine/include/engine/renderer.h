@@ -34,13 +34,21 @@ class Renderer {
   uint32_t image_index_ = 0;
 
   uint32_t frame_index_ = 0;  // [0, Swapchain::kMaxFramesInFlight)
+  uint64_t frame_number_ = 0;  // Frames begun so far, tags deferred deletions
 
   std::array<VkCommandBuffer, Swapchain::kMaxFramesInFlight> command_buffers_{};
 
+  // Owned here rather than by the swapchain, so that they outlive swapchain recreation
+  std::array<VkSemaphore, Swapchain::kMaxFramesInFlight> image_available_semaphores_{};
+  std::array<VkSemaphore, Swapchain::kMaxFramesInFlight> render_finished_semaphores_{};
+  std::array<VkFence, Swapchain::kMaxFramesInFlight> in_flight_fences_{};
+
   [[nodiscard]] VkCommandBuffer GetCurrentCommandBuffer() const { return command_buffers_[frame_index_]; }
 
   void AllocateCommandBuffers();
   void FreeCommandBuffers();
+  void CreateSynchronizationObjects();
+  void DestroySynchronizationObjects();
 
   void RecreateSwapchain();
 };
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace engine {
+// 32-bit reference into a SlotMap<T>: a slot index and the generation of the slot when the value was inserted.
+// A default-constructed handle is null, generations start at 1.
+template <typename T>
+class Handle {
+ public:
+  static constexpr uint32_t kIndexBits = 20;
+  static constexpr uint32_t kMaxIndex = (1u << kIndexBits) - 1;
+  static constexpr uint32_t kMaxGeneration = (1u << (32 - kIndexBits)) - 1;
+
+  constexpr Handle() = default;
+  constexpr Handle(uint32_t index, uint32_t generation) : value_{generation << kIndexBits | index} {
+    assert(index <= kMaxIndex && generation <= kMaxGeneration);
+  }
+
+  [[nodiscard]] constexpr uint32_t GetIndex() const { return value_ & kMaxIndex; }
+  [[nodiscard]] constexpr uint32_t GetGeneration() const { return value_ >> kIndexBits; }
+  [[nodiscard]] constexpr uint32_t GetValue() const { return value_; }
+  [[nodiscard]] constexpr bool IsNull() const { return value_ == 0; }
+
+  constexpr bool operator==(const Handle&) const = default;
+
+ private:
+  uint32_t value_ = 0;
+};
+
+// Generational slot map. Values are packed densely, in no particular order, so iterating them touches contiguous
+// memory; handles go through a slot that records the value's dense index. Removal moves the last value into the hole.
+// A handle whose slot has since been reused has a stale generation, so Get() returns nullptr instead of another value.
+template <typename T>
+class SlotMap {
+ public:
+  SlotMap() = default;
+
+  SlotMap(const SlotMap&) = delete;
+  SlotMap& operator=(const SlotMap&) = delete;
+
+  [[nodiscard]] uint32_t GetSize() const { return static_cast<uint32_t>(values_.size()); }
+  [[nodiscard]] bool IsEmpty() const { return values_.empty(); }
+
+  template <typename... Args>
+  Handle<T> Emplace(Args&&... args) {
+    uint32_t slot_index;
+    if (free_head_ != kNoSlot) {
+      slot_index = free_head_;
+      free_head_ = slots_[slot_index].dense_index;
+    } else {
+      assert(slots_.size() <= Handle<T>::kMaxIndex);
+      slot_index = static_cast<uint32_t>(slots_.size());
+      slots_.push_back({});
+    }
+    Slot& slot = slots_[slot_index];
+    slot.dense_index = static_cast<uint32_t>(values_.size());
+    values_.emplace_back(std::forward<Args>(args)...);
+    dense_to_slot_.push_back(slot_index);
+    return {slot_index, slot.generation};
+  }
+  Handle<T> Insert(T value) { return Emplace(std::move(value)); }
+
+  // Returns false if the handle is stale.
+  bool Remove(Handle<T> handle) {
+    if (!Contains(handle)) {
+      return false;
+    }
+    Slot& slot = slots_[handle.GetIndex()];
+    const uint32_t last = static_cast<uint32_t>(values_.size()) - 1;
+    if (slot.dense_index != last) {
+      values_[slot.dense_index] = std::move(values_[last]);
+      dense_to_slot_[slot.dense_index] = dense_to_slot_[last];
+      slots_[dense_to_slot_[slot.dense_index]].dense_index = slot.dense_index;
+    }
+    values_.pop_back();
+    dense_to_slot_.pop_back();
+
+    // A slot whose generation would wrap around is retired, old handles to it stay detectable
+    if (slot.generation < Handle<T>::kMaxGeneration) {
+      ++slot.generation;
+      slot.dense_index = free_head_;
+      free_head_ = handle.GetIndex();
+    } else {
+      slot.generation = 0;
+      slot.dense_index = kNoSlot;
+    }
+    return true;
+  }
+
+  void Clear() {
+    while (!values_.empty()) {
+      Remove(GetHandle(GetSize() - 1));
+    }
+  }
+
+  [[nodiscard]] bool Contains(Handle<T> handle) const {
+    const uint32_t index = handle.GetIndex();
+    // Retired slots have generation 0 and no dense index
+    return !handle.IsNull() && index < slots_.size() && slots_[index].generation == handle.GetGeneration() &&
+           slots_[index].dense_index < values_.size();
+  }
+
+  [[nodiscard]] T* Get(Handle<T> handle) {
+    return Contains(handle) ? &values_[slots_[handle.GetIndex()].dense_index] : nullptr;
+  }
+  [[nodiscard]] const T* Get(Handle<T> handle) const {
+    return Contains(handle) ? &values_[slots_[handle.GetIndex()].dense_index] : nullptr;
+  }
+
+  // Handle of the value at a dense index, for iterating over values together with their handles
+  [[nodiscard]] Handle<T> GetHandle(uint32_t dense_index) const {
+    const uint32_t slot_index = dense_to_slot_[dense_index];
+    return {slot_index, slots_[slot_index].generation};
+  }
+
+  auto begin() { return values_.begin(); }
+  auto end() { return values_.end(); }
+  [[nodiscard]] auto begin() const { return values_.begin(); }
+  [[nodiscard]] auto end() const { return values_.end(); }
+  [[nodiscard]] T& operator[](uint32_t dense_index) { return values_[dense_index]; }
+  [[nodiscard]] const T& operator[](uint32_t dense_index) const { return values_[dense_index]; }
+
+ private:
+  static constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+
+  struct Slot {
+    uint32_t dense_index = kNoSlot;  // Next free slot while free
+    uint32_t generation = 1;
+  };
+
+  std::vector<T> values_;
+  std::vector<uint32_t> dense_to_slot_;
+  std::vector<Slot> slots_;
+  uint32_t free_head_ = kNoSlot;
+};
+}  // namespace engine
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "engine/math.h"
+
+namespace engine::sphere_math {
+// Maximum absolute error of the batch atan2/asin approximations in radians, i.e. about 3e-7 in UV space
+constexpr float kMaxAngleError = 2e-6f;
+
+// Maps a point on the surface of the [-1, 1] cube onto the unit sphere, spreading the points more evenly than
+// normalization would.
+glm::vec3 CubeToSphere(glm::vec3 cube_point);
+// Equirectangular texture coordinates of a point on the unit sphere
+glm::vec2 SphereToUV(glm::vec3 sphere_point);
+
+// Batch versions of the above over structure-of-arrays input, vectorized with AVX2, SSE2 or NEON depending on the
+// target. Outputs may alias the inputs. The batch SphereToUV is within kMaxAngleError of the scalar one.
+void CubeToSphere(const float* x, const float* y, const float* z, float* out_x, float* out_y, float* out_z,
+                  uint32_t count);
+void SphereToUV(const float* x, const float* y, const float* z, float* out_u, float* out_v, uint32_t count);
+
+// Number of points transformed per iteration by the batch functions
+[[nodiscard]] uint32_t GetBatchWidth();
+}  // namespace engine::sphere_math
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace engine {
+class Buffer;
+class Device;
+
+// Fixed-size, persistently mapped staging buffer used as a ring. Regions are handed out in order and become reusable
+// once the submission that consumed them has signalled its fence, so uploads of any size never need more host-visible
+// memory than the ring itself.
+// Regions must be acquired while the command buffer consuming them is being recorded (between BeginCommands() and
+// Submit()), which keeps them alive even if other command buffers are submitted and complete in the meantime.
+// Command buffers run on the device's transfer queue. With a dedicated transfer queue, Submit() can chain a command
+// buffer from BeginAcquireCommands() on the graphics queue to acquire ownership of the uploaded resources.
+class StagingRing {
+ public:
+  static constexpr VkDeviceSize kDefaultSize = 16 * 1024 * 1024;
+  static constexpr VkDeviceSize kDefaultAlignment = 16;
+
+  struct Region {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;
+  };
+
+  explicit StagingRing(Device& device, VkDeviceSize size = kDefaultSize);
+  ~StagingRing();
+
+  StagingRing(const StagingRing&) = delete;
+  StagingRing& operator=(const StagingRing&) = delete;
+
+  [[nodiscard]] VkDeviceSize GetSize() const { return size_; }
+  // Largest chunk an upload stages at once, keeps several chunks in flight
+  [[nodiscard]] VkDeviceSize GetMaxChunkSize() const { return size_ / 4; }
+
+  // Returns std::nullopt if the ring has no room without waiting for the GPU.
+  std::optional<Region> TryAcquire(VkDeviceSize size, VkDeviceSize alignment = kDefaultAlignment);
+  // Waits for in-flight submissions until the region fits.
+  Region Acquire(VkDeviceSize size, VkDeviceSize alignment = kDefaultAlignment);
+  void Flush(const Region& region);
+
+  VkCommandBuffer BeginCommands();
+  VkCommandBuffer BeginAcquireCommands();
+  // Ends and submits the command buffer(s), returns a token that completes once they have executed.
+  uint64_t Submit(VkCommandBuffer command_buffer, VkCommandBuffer acquire_command_buffer = VK_NULL_HANDLE);
+  [[nodiscard]] bool IsComplete(uint64_t token);
+  void Wait(uint64_t token);
+  void WaitIdle();
+
+ private:
+  struct Submission {
+    uint64_t token = 0;
+    VkFence fence = VK_NULL_HANDLE;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkCommandBuffer acquire_command_buffer = VK_NULL_HANDLE;
+    uint64_t ring_end = 0;
+  };
+
+  Device& device_;
+
+  VkDeviceSize size_;
+  std::unique_ptr<Buffer> buffer_;
+  uint8_t* mapped_ = nullptr;
+
+  // Monotonic positions, the physical offset is position % size_
+  uint64_t head_ = 0;
+  uint64_t tail_ = 0;
+  uint64_t completed_end_ = 0;
+
+  std::vector<VkCommandBuffer> free_command_buffers_;
+  std::vector<VkCommandBuffer> free_acquire_command_buffers_;
+  std::vector<std::pair<VkCommandBuffer, uint64_t>> recording_;  // Command buffer -> head_ when recording began
+  std::vector<VkFence> free_fences_;
+  std::vector<VkSemaphore> free_semaphores_;
+
+  std::deque<Submission> submissions_;
+  uint64_t next_token_ = 1;
+  uint64_t completed_token_ = 0;
+
+  VkCommandBuffer BeginCommandBuffer(VkCommandPool command_pool, std::vector<VkCommandBuffer>& free_command_buffers);
+  void Reclaim();
+};
+}  // namespace engine
@@ -13,7 +13,8 @@ class Swapchain {
  public:
   static constexpr uint32_t kMaxFramesInFlight = 2;
 
-  Swapchain(Device& device, VkExtent2D window_extent, std::unique_ptr<Swapchain> old_swapchain = nullptr);
+  // The old swapchain is retired, but stays valid until its presentations have completed
+  Swapchain(Device& device, VkExtent2D window_extent, const Swapchain* old_swapchain = nullptr);
   ~Swapchain();
 
   Swapchain(const Swapchain&) = delete;
@@ -26,8 +27,8 @@ class Swapchain {
   [[nodiscard]] VkFramebuffer GetFramebuffer(uint32_t image_index) const { return framebuffers_[image_index]; }
   [[nodiscard]] VkRenderPass GetRenderPass() const { return render_pass_; }
 
-  VkResult AcquireNextImage(uint32_t* image_index);
-  VkResult SubmitAndPresent(const VkCommandBuffer& command_buffer, uint32_t image_index);
+  VkResult AcquireNextImage(VkSemaphore image_available_semaphore, uint32_t* image_index);
+  VkResult Present(VkSemaphore render_finished_semaphore, uint32_t image_index);
 
  private:
   Device& device_;
@@ -41,28 +42,17 @@ class Swapchain {
 
   VkFormat depth_image_format_ = VK_FORMAT_UNDEFINED;
   std::vector<VkImage> depth_images_;
-  std::vector<VkDeviceMemory> depth_images_memory_;
+  std::vector<MemoryAllocation> depth_image_allocations_;
   std::vector<VkImageView> depth_image_views_;
 
   VkRenderPass render_pass_ = VK_NULL_HANDLE;
   std::vector<VkFramebuffer> framebuffers_;
 
-  uint32_t frame_index_ = 0;  // [0, kMaxFramesInFlight)
-
-  std::array<VkSemaphore, kMaxFramesInFlight> image_available_semaphores_{};
-  std::array<VkSemaphore, kMaxFramesInFlight> render_finished_semaphores_{};
-  std::array<VkFence, kMaxFramesInFlight> in_flight_fences_{};
-
-  [[nodiscard]] VkSemaphore* GetImageAvailableSemaphore() { return &image_available_semaphores_[frame_index_]; }
-  [[nodiscard]] VkSemaphore* GetRenderFinishedSemaphore() { return &render_finished_semaphores_[frame_index_]; }
-  [[nodiscard]] VkFence* GetInFlightFence() { return &in_flight_fences_[frame_index_]; }
-
-  void CreateSwapChain(std::unique_ptr<Swapchain> old_swapchain);
+  void CreateSwapChain(const Swapchain* old_swapchain);
   void CreateImageViews();
   void CreateDepthResources();
   void CreateRenderPass();
   void CreateFrameBuffers();
-  void CreateSynchronizationObjects();
 
   static VkSurfaceFormatKHR PickSwapchainSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& available_formats);
   static VkPresentModeKHR PickSwapchainPresentMode(const std::vector<VkPresentModeKHR>& available_present_modes);
@@ -1,33 +1,79 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vector>
 
 #include <vulkan/vulkan.h>
 
+#include "engine/camera.h"
 #include "engine/device.h"
+#include "engine/dynamic_mesh.h"
+#include "engine/frame_arena.h"
 #include "engine/graphics_pipeline.h"
+#include "engine/mesh.h"
 #include "engine/model.h"
+#include "engine/slot_map.h"
+#include "engine/texture.h"
+#include "engine/vertex.h"
 
 namespace engine::systems {
+// Draws all models with indirect draw commands built on the CPU each frame. Draws are grouped by vertex format,
+// geometry arena page and texture, so each group costs one bind and one vkCmdDrawIndexedIndirect. Per-object data and
+// the commands are allocated from the frame arena, the commands point at their object through firstInstance. Meshes
+// split into meshlets get a command per visible run of meshlets, culled against the camera's frustum and normal cones.
+// Meshes with levels of detail are drawn at the coarsest level whose error stays below about a pixel on screen.
+// Dynamic models are drawn directly after, one draw each from the frame's region of their mesh.
 class ModelRenderSystem {
  public:
-  ModelRenderSystem(Device& device, VkRenderPass render_pass, VkDescriptorSetLayout global_descriptor_set_layout);
+  ModelRenderSystem(Device& device, const MeshManager& mesh_manager, TextureManager& texture_manager,
+                    VkRenderPass render_pass, VkDescriptorSetLayout global_descriptor_set_layout);
   ~ModelRenderSystem();
 
   ModelRenderSystem(const ModelRenderSystem&) = delete;
   ModelRenderSystem& operator=(const ModelRenderSystem&) = delete;
 
-  void Render(VkCommandBuffer command_buffer, const std::vector<std::unique_ptr<Model>>& models,
-              VkDescriptorSet global_descriptor_set);
+  // Dynamic models must have been committed for the frame
+  void Render(VkCommandBuffer command_buffer, FrameArena& frame_arena, const SlotMap<Model>& models,
+              const SlotMap<DynamicModel>& dynamic_models, const Camera& camera, VkDescriptorSet global_descriptor_set);
 
  private:
+  struct Draw {
+    const Mesh* mesh = nullptr;
+    TextureHandle texture;
+    uint32_t model_index = 0;  // Dense index into the models
+    uint32_t lod = 0;
+    uint32_t first_command = 0;
+    uint32_t command_count = 0;
+  };
+  struct ModelLod {
+    ModelHandle model;
+    uint32_t lod = 0;
+  };
+
   Device& device_;
+  const MeshManager& mesh_manager_;
+  TextureManager& texture_manager_;
 
+  VkDescriptorSetLayout texture_descriptor_set_layout_ = VK_NULL_HANDLE;
   VkPipelineLayout pipeline_layout_ = VK_NULL_HANDLE;
-  std::unique_ptr<GraphicsPipeline> pipeline_;
+  // By vertex format, then vertex streams
+  std::array<std::unique_ptr<GraphicsPipeline>, kVertexFormatCount * kVertexStreamsCount> pipelines_;
+
+  std::vector<Draw> draws_;
+  // Level of detail each model was last drawn at, by the handle's slot index
+  std::vector<ModelLod> model_lods_;
 
+  void RenderModels(VkCommandBuffer command_buffer, FrameArena& frame_arena, const SlotMap<Model>& models,
+                    const Camera& camera);
+  void RenderDynamicModels(VkCommandBuffer command_buffer, FrameArena& frame_arena,
+                           const SlotMap<DynamicModel>& dynamic_models);
+
+  void CreateDescriptorSetLayout();
   void CreatePipelineLayout(VkDescriptorSetLayout global_descriptor_set_layout);
   void CreatePipeline(VkRenderPass render_pass);
+
+  void DrawIndirect(VkCommandBuffer command_buffer, const FrameArena::Allocation& commands, uint32_t first_draw,
+                    uint32_t draw_count) const;
 };
 }  // namespace engine::systems
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+
+#include <vulkan/vulkan.h>
+
+#include "engine/device.h"
+#include "engine/graphics_pipeline.h"
+#include "engine/procedural_sphere.h"
+#include "engine/slot_map.h"
+#include "engine/texture.h"
+
+namespace engine::systems {
+// Draws procedural spheres with one non-indexed draw each. The vertex shader derives every vertex from gl_VertexIndex
+// and the resolution in the push constants, so the spheres take no geometry memory and no uploads.
+class ProceduralSphereRenderSystem {
+ public:
+  ProceduralSphereRenderSystem(Device& device, TextureManager& texture_manager, VkRenderPass render_pass,
+                               VkDescriptorSetLayout global_descriptor_set_layout);
+  ~ProceduralSphereRenderSystem();
+
+  ProceduralSphereRenderSystem(const ProceduralSphereRenderSystem&) = delete;
+  ProceduralSphereRenderSystem& operator=(const ProceduralSphereRenderSystem&) = delete;
+
+  void Render(VkCommandBuffer command_buffer, const SlotMap<ProceduralSphere>& spheres,
+              VkDescriptorSet global_descriptor_set);
+
+ private:
+  Device& device_;
+  TextureManager& texture_manager_;
+
+  VkDescriptorSetLayout texture_descriptor_set_layout_ = VK_NULL_HANDLE;
+  VkPipelineLayout pipeline_layout_ = VK_NULL_HANDLE;
+  std::unique_ptr<GraphicsPipeline> pipeline_;
+
+  void CreateDescriptorSetLayout();
+  void CreatePipelineLayout(VkDescriptorSetLayout global_descriptor_set_layout);
+  void CreatePipeline(VkRenderPass render_pass);
+};
+}  // namespace engine::systems
@@ -5,22 +5,33 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include <vulkan/vulkan.h>
 
 #include "engine/device.h"
+#include "engine/slot_map.h"
+#include "engine/upload_batch.h"
 
 namespace engine {
+class Texture;
 class TextureManager;
 
+using TextureHandle = Handle<Texture>;
+
 class Texture {
  public:
-  static Texture* CreateFromFile(TextureManager& manager, const std::filesystem::path& file_path);
+  // Textures are shared by file path, an already loaded file is not loaded again
+  static TextureHandle CreateFromFile(TextureManager& manager, const std::filesystem::path& file_path);
+  static TextureHandle CreateFromFile(TextureManager& manager, UploadBatch& upload_batch,
+                                      const std::filesystem::path& file_path);
 
   ~Texture();
 
   Texture(const Texture&) = delete;
   Texture& operator=(const Texture&) = delete;
+  Texture(Texture&& other) noexcept;
+  Texture& operator=(Texture&& other) noexcept;
 
   [[nodiscard]] VkDescriptorImageInfo GetDescriptorInfo() const {
     return {.sampler = sampler_, .imageView = image_view_, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
@@ -29,23 +40,21 @@ class Texture {
   void Bind(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout);
 
  private:
-  Texture(Device& device, const std::filesystem::path& file_path);
+  Texture(Device& device, UploadBatch& upload_batch, const std::filesystem::path& file_path);
 
-  Device& device_;
+  Device* device_;  // Null once moved from
 
   VkImage image_ = VK_NULL_HANDLE;
-  VkDeviceMemory memory_ = VK_NULL_HANDLE;
+  MemoryAllocation allocation_{};
   VkImageView image_view_ = VK_NULL_HANDLE;
   VkSampler sampler_ = VK_NULL_HANDLE;
 
   VkDescriptorSetLayout descriptor_set_layout_ = VK_NULL_HANDLE;
   VkDescriptorSet descriptor_set_ = VK_NULL_HANDLE;
 
-  void CreateImage(const std::vector<uint8_t>& bytes, uint32_t width, uint32_t height);
+  void CreateImage(UploadBatch& upload_batch, const std::vector<uint8_t>& bytes, uint32_t width, uint32_t height);
   void CreateImageView();
   void CreateSampler();
-
-  void TransitionImageLayout(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout);
 };
 
 class TextureManager {
@@ -55,22 +64,35 @@ class TextureManager {
   TextureManager(const TextureManager&) = delete;
   TextureManager& operator=(const TextureManager&) = delete;
 
-  Texture* Add(const std::string& name, std::unique_ptr<Texture> texture) {
-    auto [it, success] = textures_.try_emplace(name, std::move(texture));
-    return it->second.get();
+  // Returns the existing texture if the name is taken
+  TextureHandle Add(const std::string& name, Texture texture) {
+    auto it = names_.find(name);
+    if (it != names_.end()) {
+      return it->second;
+    }
+    TextureHandle handle = textures_.Insert(std::move(texture));
+    names_.emplace(name, handle);
+    return handle;
+  }
+  void Remove(TextureHandle handle) {
+    std::erase_if(names_, [handle](const auto& name) { return name.second == handle; });
+    textures_.Remove(handle);
   }
-  [[nodiscard]] Texture* Get(const std::string& name) const {
-    auto it = textures_.find(name);
-    if (it == textures_.end()) {
-      return nullptr;
+  [[nodiscard]] TextureHandle Get(const std::string& name) const {
+    auto it = names_.find(name);
+    if (it == names_.end()) {
+      return {};
     }
-    return it->second.get();
+    return it->second;
   }
+  // Null if the texture has been removed
+  [[nodiscard]] Texture* Get(TextureHandle handle) { return textures_.Get(handle); }
 
  private:
   Device& device_;
 
-  std::unordered_map<std::string, std::unique_ptr<Texture>> textures_;
+  SlotMap<Texture> textures_;
+  std::unordered_map<std::string, TextureHandle> names_;
 
   friend class Texture;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+// Fixed set of worker threads for data-parallel CPU work, e.g. mesh generation. ParallelFor hands out task indices
+// one at a time, so tasks of uneven cost still balance across the workers. Submit queues background jobs that nobody
+// waits for, which the workers pick up whenever no ParallelFor needs them.
+class ThreadPool {
+ public:
+  // Zero worker threads runs everything on the calling thread
+  explicit ThreadPool(uint32_t worker_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Shared pool with a worker per hardware thread, besides the calling thread
+  static ThreadPool& Get();
+
+  [[nodiscard]] uint32_t GetWorkerCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+  // Runs task(i) for each i in [0, task_count) and returns once all have finished. The calling thread takes part.
+  // Tasks must not throw nor call ParallelFor themselves.
+  void ParallelFor(uint32_t task_count, const std::function<void(uint32_t)>& task);
+  // Queues a job and returns at once, the job signals its completion itself. Without workers the job runs before
+  // Submit returns. Jobs must not throw, and those still queued when the pool is destroyed never run.
+  void Submit(std::function<void()> job);
+
+ private:
+  std::vector<std::thread> workers_;
+
+  std::mutex parallel_for_mutex_;  // One ParallelFor at a time
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_finished_;
+  const std::function<void(uint32_t)>* task_ = nullptr;
+  uint32_t task_count_ = 0;
+  uint32_t next_task_ = 0;
+  uint32_t finished_task_count_ = 0;
+  uint64_t generation_ = 0;  // Bumped for each ParallelFor so that workers wake up once per call
+  std::deque<std::function<void()>> jobs_;
+  bool stopping_ = false;
+
+  void WorkerLoop();
+  // Runs tasks until none are left, the lock is held on entry and on return
+  void RunTasks(std::unique_lock<std::mutex>& lock);
+};
+}  // namespace engine
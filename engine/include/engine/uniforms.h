@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "engine/math.h"
 
 namespace engine {
@@ -11,4 +13,17 @@ struct GlobalUniformBufferObject {
   glm::vec3 light_position{1.0f};
   alignas(16) glm::vec4 light_color{2.0f};  // w is intensity
 };
+
+// Per-object block in the frame arena, indexed with gl_InstanceIndex
+struct ObjectData {
+  glm::mat4 model;   // Includes the mesh's position dequantization
+  glm::mat4 normal;  // Inverse transpose of the model's transform
+  glm::vec4 uv_transform;  // xy scale, zw offset
+};
+
+// Per-sphere push constants of shaders/procedural_sphere.vert
+struct ProceduralSpherePushConstants {
+  glm::mat4 model;
+  uint32_t cube_face_resolution;
+};
 }  // namespace engine
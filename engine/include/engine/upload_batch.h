@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "engine/staging_ring.h"
+
+namespace engine {
+class Buffer;
+class Device;
+
+// Records buffer copies, image copies and layout transitions for any number of resources into a single command
+// buffer, staged through the device's staging ring. Submit() hands everything to the GPU at once and returns a
+// token for StagingRing::Wait()/IsComplete(). If the ring fills up mid-batch, the commands recorded so far are
+// submitted early so their staging regions can be recycled.
+// On a dedicated transfer queue, ownership of every uploaded buffer range and image is released there and acquired
+// on the graphics queue when the batch is submitted. Buffers used as a Copy() source must not have been touched by
+// the graphics queue.
+class UploadBatch {
+ public:
+  explicit UploadBatch(Device& device);
+  ~UploadBatch();
+
+  UploadBatch(const UploadBatch&) = delete;
+  UploadBatch& operator=(const UploadBatch&) = delete;
+
+  [[nodiscard]] bool IsEmpty() const { return command_buffer_ == VK_NULL_HANDLE; }
+
+  // Host-visible destinations are written immediately instead, without recording anything.
+  void Upload(const Buffer& dst, const void* data, VkDeviceSize size, VkDeviceSize dst_offset = 0);
+  void Copy(const Buffer& src, const Buffer& dst, VkDeviceSize size, VkDeviceSize src_offset = 0,
+            VkDeviceSize dst_offset = 0);
+  // Uploads tightly packed texels to the whole image and leaves it in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+  void UploadImage(VkImage image, const void* data, uint32_t width, uint32_t height, uint32_t texel_size);
+  void TransitionImageLayout(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout);
+
+  // Makes all transfer writes visible to subsequent vertex, index, indirect and shader reads and submits the batch.
+  // The batch can be reused afterwards.
+  uint64_t Submit();
+
+ private:
+  Device& device_;
+  StagingRing& staging_ring_;
+
+  VkCommandBuffer command_buffer_ = VK_NULL_HANDLE;
+
+  std::vector<VkBufferMemoryBarrier> buffer_ownership_transfers_;
+  std::vector<VkImageMemoryBarrier> image_ownership_transfers_;
+
+  VkCommandBuffer GetCommandBuffer();
+  void TransferOwnership(const Buffer& buffer, VkDeviceSize offset, VkDeviceSize size);
+  StagingRing::Region Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment);
+};
+}  // namespace engine
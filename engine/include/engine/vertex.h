@@ -1,11 +1,16 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
 #include "engine/math.h"
 #include "engine/utils.h"
+#include "engine/vertex_layout.h"
 
 namespace engine {
 struct Vertex {
@@ -18,9 +23,118 @@ struct Vertex {
     return position == other.position && normal == other.normal && color == other.color && uv == other.uv;
   }
 
-  static std::array<VkVertexInputBindingDescription, 1> BindingDescriptions();
-  static std::array<VkVertexInputAttributeDescription, 4> AttributeDescriptions();
+  using Layout = VertexLayout<Position<F32x3>, Normal<F32x3>, Color<F32x3>, UV<F32x2>>;
+  using SplitLayout = VertexLayout<Position<F32x3>, Normal<F32x3, 1>, Color<F32x3, 1>, UV<F32x2, 1>>;
 };
+static_assert(Vertex::Layout::StrideOf() == sizeof(Vertex));
+static_assert(Vertex::Layout::OffsetOf<0>() == offsetof(Vertex, position));
+static_assert(Vertex::Layout::OffsetOf<1>() == offsetof(Vertex, normal));
+static_assert(Vertex::Layout::OffsetOf<2>() == offsetof(Vertex, color));
+static_assert(Vertex::Layout::OffsetOf<3>() == offsetof(Vertex, uv));
+
+// Layout of a mesh's vertices in the vertex buffer. Quantized formats store positions normalized to the mesh bounds,
+// octahedral normals and UVs normalized to the mesh's UV bounds, and drop the color.
+enum class VertexFormat : uint32_t {
+  kFloat32,  // Vertex, 44 bytes
+  kSnorm16,  // QuantizedVertex with snorm16 positions, 16 bytes
+  kHalf,     // QuantizedVertex with half-float positions, 16 bytes
+};
+constexpr uint32_t kVertexFormatCount = 3;
+
+// How a mesh's vertices are laid out across vertex buffers. Split streams keep positions in a buffer of their own at
+// binding 0 and the remaining attributes at binding 1, so position-only passes (depth pre-pass, shadows, picking) bind
+// just the position stream and fetch a fraction of the memory.
+enum class VertexStreams : uint32_t {
+  kInterleaved,
+  kSplitPositions,
+};
+constexpr uint32_t kVertexStreamsCount = 2;
+
+struct QuantizedVertex {
+  std::array<uint16_t, 4> position{};  // w is unused, 3-component 16-bit formats are not widely supported
+  std::array<int16_t, 2> normal{};     // Octahedral, snorm16
+  std::array<uint16_t, 2> uv{};        // unorm16
+
+  template <typename PositionEncoding>
+  using Layout = VertexLayout<Position<PositionEncoding>, Normal<Oct16>, UV<Unorm16x2>>;
+  template <typename PositionEncoding>
+  using SplitLayout = VertexLayout<Position<PositionEncoding>, Normal<Oct16, 1>, UV<Unorm16x2, 1>>;
+};
+static_assert(QuantizedVertex::Layout<Snorm16x4>::StrideOf() == sizeof(QuantizedVertex));
+static_assert(QuantizedVertex::Layout<Snorm16x4>::OffsetOf<0>() == offsetof(QuantizedVertex, position));
+static_assert(QuantizedVertex::Layout<Snorm16x4>::OffsetOf<1>() == offsetof(QuantizedVertex, normal));
+static_assert(QuantizedVertex::Layout<Snorm16x4>::OffsetOf<3>() == offsetof(QuantizedVertex, uv));
+
+// Layout: interleaved, SplitLayout: split streams, PositionLayout: the position stream alone
+template <VertexFormat kFormat>
+struct VertexFormatTraits;
+template <>
+struct VertexFormatTraits<VertexFormat::kFloat32> {
+  using Layout = Vertex::Layout;
+  using SplitLayout = Vertex::SplitLayout;
+  using PositionLayout = VertexLayout<Position<F32x3>>;
+};
+template <>
+struct VertexFormatTraits<VertexFormat::kSnorm16> {
+  using Layout = QuantizedVertex::Layout<Snorm16x4>;
+  using SplitLayout = QuantizedVertex::SplitLayout<Snorm16x4>;
+  using PositionLayout = VertexLayout<Position<Snorm16x4>>;
+};
+template <>
+struct VertexFormatTraits<VertexFormat::kHalf> {
+  using Layout = QuantizedVertex::Layout<Half16x4>;
+  using SplitLayout = QuantizedVertex::SplitLayout<Half16x4>;
+  using PositionLayout = VertexLayout<Position<Half16x4>>;
+};
+
+// Calls function.template operator()<Traits>() with the format's VertexFormatTraits
+template <typename Function>
+decltype(auto) VisitVertexFormat(VertexFormat format, Function&& function) {
+  switch (format) {
+    case VertexFormat::kFloat32:
+      return function.template operator()<VertexFormatTraits<VertexFormat::kFloat32>>();
+    case VertexFormat::kSnorm16:
+      return function.template operator()<VertexFormatTraits<VertexFormat::kSnorm16>>();
+    case VertexFormat::kHalf:
+      return function.template operator()<VertexFormatTraits<VertexFormat::kHalf>>();
+  }
+  throw std::runtime_error{"Unknown vertex format!"};
+}
+
+// Calls function.template operator()<Layout>() with the layout of the format in the given streams
+template <typename Function>
+decltype(auto) VisitVertexLayout(VertexFormat format, VertexStreams streams, Function&& function) {
+  return VisitVertexFormat(format, [&]<typename Traits>() -> decltype(auto) {
+    if (streams == VertexStreams::kSplitPositions) {
+      return function.template operator()<typename Traits::SplitLayout>();
+    }
+    return function.template operator()<typename Traits::Layout>();
+  });
+}
+
+// Maps decoded attributes back to the mesh's space, identity for kFloat32
+struct VertexDequantization {
+  glm::vec3 position_offset{0.0f};
+  glm::vec3 position_scale{1.0f};
+  glm::vec4 uv_transform{1.0f, 1.0f, 0.0f, 0.0f};  // xy scale, zw offset
+
+  [[nodiscard]] glm::mat4 PositionMat4() const;
+};
+
+// Stride of a binding, 0 if the streams have no such binding
+[[nodiscard]] inline uint32_t GetVertexStride(VertexFormat format, VertexStreams streams = VertexStreams::kInterleaved,
+                                              uint32_t binding = 0) {
+  return VisitVertexLayout(format, streams, [binding]<typename Layout>() {
+    return binding < Layout::kBindingCount ? Layout::BindingDescriptions()[binding].stride : 0;
+  });
+}
+
+// Encodes vertices in the given format on the CPU, e.g. at load time
+std::vector<uint8_t> EncodeVertices(const std::vector<Vertex>& vertices, VertexFormat format,
+                                    VertexDequantization& dequantization);
+// De-interleaves encoded vertices into the position and attribute streams of the format's split layout
+std::array<std::vector<uint8_t>, 2> SplitVertexStreams(const std::vector<uint8_t>& encoded_vertices,
+                                                       VertexFormat format);
 }  // namespace engine
 
 namespace std {
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "engine/math.h"
+
+namespace engine {
+// Attribute encodings: the CPU-side type written to the vertex buffer and the format the vertex fetch decodes it with
+struct F32x2 {
+  using Type = glm::vec2;
+  static constexpr VkFormat kFormat = VK_FORMAT_R32G32_SFLOAT;
+};
+struct F32x3 {
+  using Type = glm::vec3;
+  static constexpr VkFormat kFormat = VK_FORMAT_R32G32B32_SFLOAT;
+};
+struct Snorm16x4 {
+  using Type = std::array<uint16_t, 4>;
+  static constexpr VkFormat kFormat = VK_FORMAT_R16G16B16A16_SNORM;
+};
+struct Half16x4 {
+  using Type = std::array<uint16_t, 4>;
+  static constexpr VkFormat kFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+};
+struct Oct16 {  // Octahedral unit vector
+  using Type = std::array<int16_t, 2>;
+  static constexpr VkFormat kFormat = VK_FORMAT_R16G16_SNORM;
+};
+struct Unorm16x2 {
+  using Type = std::array<uint16_t, 2>;
+  static constexpr VkFormat kFormat = VK_FORMAT_R16G16_UNORM;
+};
+
+template <uint32_t kLocationValue, typename EncodingType, uint32_t kBindingValue>
+struct VertexAttribute {
+  static constexpr uint32_t kLocation = kLocationValue;
+  static constexpr uint32_t kBinding = kBindingValue;
+  using Encoding = EncodingType;
+};
+
+// Shader input locations shared by all model shaders
+template <typename Encoding, uint32_t kBinding = 0>
+using Position = VertexAttribute<0, Encoding, kBinding>;
+template <typename Encoding, uint32_t kBinding = 0>
+using Normal = VertexAttribute<1, Encoding, kBinding>;
+template <typename Encoding, uint32_t kBinding = 0>
+using Color = VertexAttribute<2, Encoding, kBinding>;
+template <typename Encoding, uint32_t kBinding = 0>
+using UV = VertexAttribute<3, Encoding, kBinding>;
+
+// Vertex layout over one or more bindings, each interleaving its attributes in declaration order with natural
+// alignment. Offsets, strides, descriptions and a hash identifying the layout are all computed at compile time. An
+// empty layout has no vertex input at all.
+template <typename... Attributes>
+class VertexLayout {
+ public:
+  static constexpr uint32_t kAttributeCount = sizeof...(Attributes);
+  static constexpr uint32_t kBindingCount = std::max({0u, (Attributes::kBinding + 1)...});
+
+ private:
+  static constexpr std::array<uint32_t, kAttributeCount> kLocations{Attributes::kLocation...};
+  static constexpr std::array<uint32_t, kAttributeCount> kBindings{Attributes::kBinding...};
+  static constexpr std::array<VkFormat, kAttributeCount> kFormats{Attributes::Encoding::kFormat...};
+  static constexpr std::array<uint32_t, kAttributeCount> kSizes{sizeof(typename Attributes::Encoding::Type)...};
+  static constexpr std::array<uint32_t, kAttributeCount> kAlignments{alignof(typename Attributes::Encoding::Type)...};
+
+  static constexpr uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  struct Offsets {
+    std::array<uint32_t, kAttributeCount> attributes{};
+    std::array<uint32_t, kBindingCount> strides{};
+  };
+  static constexpr Offsets ComputeOffsets() {
+    Offsets offsets{};
+    std::array<uint32_t, kBindingCount> max_alignments{};
+    for (uint32_t i = 0; i < kAttributeCount; ++i) {
+      uint32_t& stride = offsets.strides[kBindings[i]];
+      stride = AlignUp(stride, kAlignments[i]);
+      offsets.attributes[i] = stride;
+      stride += kSizes[i];
+      max_alignments[kBindings[i]] = std::max(max_alignments[kBindings[i]], kAlignments[i]);
+    }
+    for (uint32_t binding = 0; binding < kBindingCount; ++binding) {
+      offsets.strides[binding] = AlignUp(offsets.strides[binding], max_alignments[binding]);
+    }
+    return offsets;
+  }
+  static constexpr Offsets kOffsets = ComputeOffsets();
+
+  static constexpr bool IsValid() {
+    for (uint32_t i = 0; i < kAttributeCount; ++i) {
+      for (uint32_t j = i + 1; j < kAttributeCount; ++j) {
+        if (kLocations[i] == kLocations[j]) {
+          return false;
+        }
+      }
+    }
+    // Bindings are numbered without gaps
+    for (uint32_t binding = 0; binding < kBindingCount; ++binding) {
+      if (kOffsets.strides[binding] == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+  static_assert(IsValid(), "Vertex attributes must have unique locations and bindings without gaps!");
+
+  // FNV-1a over the strides and each attribute's location, binding, format and offset
+  static constexpr uint64_t ComputeHash() {
+    uint64_t hash = 14695981039346656037ull;
+    auto combine = [&hash](uint64_t value) {
+      hash ^= value;
+      hash *= 1099511628211ull;
+    };
+    for (uint32_t binding = 0; binding < kBindingCount; ++binding) {
+      combine(kOffsets.strides[binding]);
+    }
+    for (uint32_t i = 0; i < kAttributeCount; ++i) {
+      combine(kLocations[i]);
+      combine(kBindings[i]);
+      combine(static_cast<uint64_t>(kFormats[i]));
+      combine(kOffsets.attributes[i]);
+    }
+    return hash;
+  }
+
+  static constexpr uint32_t IndexOf(uint32_t location) {
+    for (uint32_t i = 0; i < kAttributeCount; ++i) {
+      if (kLocations[i] == location) {
+        return i;
+      }
+    }
+    throw "No attribute at the location!";  // Not a constant expression, fails compilation
+  }
+
+ public:
+  static constexpr uint64_t kHash = ComputeHash();
+
+  template <uint32_t kBinding = 0>
+  static constexpr uint32_t StrideOf() {
+    static_assert(kBinding < kBindingCount);
+    return kOffsets.strides[kBinding];
+  }
+  template <uint32_t kLocation>
+  static constexpr uint32_t OffsetOf() {
+    return kOffsets.attributes[IndexOf(kLocation)];
+  }
+
+  static constexpr std::array<uint32_t, kAttributeCount> AttributeSizes() { return kSizes; }
+
+  static constexpr std::array<VkVertexInputBindingDescription, kBindingCount> BindingDescriptions() {
+    std::array<VkVertexInputBindingDescription, kBindingCount> binding_descriptions{};
+    for (uint32_t binding = 0; binding < kBindingCount; ++binding) {
+      binding_descriptions[binding] = {
+          .binding = binding,
+          .stride = kOffsets.strides[binding],
+          .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+      };
+    }
+    return binding_descriptions;
+  }
+
+  static constexpr std::array<VkVertexInputAttributeDescription, kAttributeCount> AttributeDescriptions() {
+    std::array<VkVertexInputAttributeDescription, kAttributeCount> attribute_descriptions{};
+    for (uint32_t i = 0; i < kAttributeCount; ++i) {
+      attribute_descriptions[i] = {
+          .location = kLocations[i],
+          .binding = kBindings[i],
+          .format = kFormats[i],
+          .offset = kOffsets.attributes[i],
+      };
+    }
+    return attribute_descriptions;
+  }
+};
+}  // namespace engine
@@ -1,6 +1,8 @@
 #include "engine/application.h"
 
 #include <chrono>
+#include <fstream>
+#include <iostream>
 
 #include <vulkan/vulkan.h>
 
@@ -8,18 +10,23 @@
 
 namespace engine {
 Application::Application(const ApplicationInfo& application_info)
-    : window_{application_info.title, application_info.window_width, application_info.window_height} {
+    : window_{application_info.title, application_info.window_width, application_info.window_height},
+      memory_stats_interval_{application_info.memory_stats_interval},
+      memory_stats_path_{application_info.memory_stats_path} {
 
   for (uint32_t i = 0; i < Swapchain::kMaxFramesInFlight; ++i) {
     uniform_buffers_[i] =
         std::make_unique<Buffer>(device_, sizeof(GlobalUniformBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                 MemoryCategory::kUniform, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
     uniform_buffers_[i]->Map();
+    frame_arenas_[i] = std::make_unique<FrameArena>(device_);
   }
 
   // Descriptor set layout
-  std::array<VkDescriptorSetLayoutBinding, 1> global_descriptor_set_layout_bindings{
-      {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr}},
+  std::array<VkDescriptorSetLayoutBinding, 2> global_descriptor_set_layout_bindings{
+      {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+       {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr}},
   };
   VkDescriptorSetLayoutCreateInfo descriptor_set_layout_info{};
   descriptor_set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -43,23 +50,15 @@ Application::Application(const ApplicationInfo& application_info)
       throw std::runtime_error{"Failed to allocate descriptor sets"};
     }
 
-    VkDescriptorBufferInfo buffer_info{};
-    buffer_info.buffer = uniform_buffers_[i]->GetHandle();
-    buffer_info.offset = 0;
-    buffer_info.range = sizeof(GlobalUniformBufferObject);
-
-    std::array<VkWriteDescriptorSet, 1> descriptor_writes{
-        {{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, global_descriptor_sets_[i], 0, 0, 1,
-          VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &buffer_info, nullptr}},
-    };
-    vkUpdateDescriptorSets(device_.GetHandle(), static_cast<uint32_t>(descriptor_writes.size()),
-                           descriptor_writes.data(), 0, nullptr);
+    WriteGlobalDescriptorSet(i);
   }
 
-  model_render_system_ =
-      std::make_unique<systems::ModelRenderSystem>(device_, renderer_.GetRenderPass(), global_descriptor_set_layout_);
+  model_render_system_ = std::make_unique<systems::ModelRenderSystem>(
+      device_, mesh_manager_, texture_manager_, renderer_.GetRenderPass(), global_descriptor_set_layout_);
   point_light_render_system_ = std::make_unique<systems::PointLightRenderSystem>(device_, renderer_.GetRenderPass(),
                                                                                  global_descriptor_set_layout_);
+  procedural_sphere_render_system_ = std::make_unique<systems::ProceduralSphereRenderSystem>(
+      device_, texture_manager_, renderer_.GetRenderPass(), global_descriptor_set_layout_);
 }
 
 Application::~Application() {
@@ -79,6 +78,14 @@ void Application::Run() {
     camera_.ProcessInput(frame_time);
     OnFrame(frame_time);
     DrawFrame();
+
+    if (memory_stats_interval_ > 0.0f) {
+      memory_stats_timer_ += frame_time;
+      if (memory_stats_timer_ >= memory_stats_interval_) {
+        memory_stats_timer_ = 0.0f;
+        DumpMemoryStats();
+      }
+    }
   }
   vkDeviceWaitIdle(device_.GetHandle());
 }
@@ -87,6 +94,13 @@ void Application::DrawFrame() {
   camera_.SetPerspective(glm::radians(45.0f), renderer_.GetAspectRatio(), 0.1f, 1000.0f);
 
   if (auto command_buffer = renderer_.BeginFrame()) {
+    // The frame's previous submission has completed
+    FrameArena& frame_arena = *frame_arenas_[renderer_.GetFrameIndex()];
+    // nor is the frame's descriptor set, so it can take a grown arena's new buffer
+    if (frame_arena.Reset()) {
+      WriteGlobalDescriptorSet(renderer_.GetFrameIndex());
+    }
+
     // Update
     GlobalUniformBufferObject ubo{
         .projection = camera_.GetProjection(),
@@ -94,16 +108,58 @@ void Application::DrawFrame() {
     };
     uniform_buffers_[renderer_.GetFrameIndex()]->Write(&ubo);
     uniform_buffers_[renderer_.GetFrameIndex()]->Flush();
+    for (DynamicModel& dynamic_model : dynamic_models_) {
+      dynamic_model.mesh.Commit(renderer_.GetFrameIndex());
+    }
 
     // Render
     renderer_.BeginRenderPass(command_buffer);
 
-    model_render_system_->Render(command_buffer, models_, global_descriptor_sets_[renderer_.GetFrameIndex()]);
+    model_render_system_->Render(command_buffer, frame_arena, models_, dynamic_models_, camera_,
+                                 global_descriptor_sets_[renderer_.GetFrameIndex()]);
+    procedural_sphere_render_system_->Render(command_buffer, procedural_spheres_,
+                                             global_descriptor_sets_[renderer_.GetFrameIndex()]);
     point_light_render_system_->Render(command_buffer, global_descriptor_sets_[renderer_.GetFrameIndex()]);
 
     renderer_.EndRenderPass(command_buffer);
+    frame_arena.Flush();
     renderer_.EndFrame();
   }
 }
 
+void Application::WriteGlobalDescriptorSet(uint32_t frame_index) {
+  VkDescriptorBufferInfo buffer_info{};
+  buffer_info.buffer = uniform_buffers_[frame_index]->GetHandle();
+  buffer_info.offset = 0;
+  buffer_info.range = sizeof(GlobalUniformBufferObject);
+
+  // The whole frame arena, per-object data is indexed rather than bound per draw
+  VkDescriptorBufferInfo frame_arena_info{};
+  frame_arena_info.buffer = frame_arenas_[frame_index]->GetBuffer().GetHandle();
+  frame_arena_info.offset = 0;
+  frame_arena_info.range = VK_WHOLE_SIZE;
+
+  std::array<VkWriteDescriptorSet, 2> descriptor_writes{
+      {{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, global_descriptor_sets_[frame_index], 0, 0, 1,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &buffer_info, nullptr},
+       {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, global_descriptor_sets_[frame_index], 1, 0, 1,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &frame_arena_info, nullptr}},
+  };
+  vkUpdateDescriptorSets(device_.GetHandle(), static_cast<uint32_t>(descriptor_writes.size()),
+                         descriptor_writes.data(), 0, nullptr);
+}
+
+void Application::DumpMemoryStats() const {
+  const MemoryStats stats = device_.QueryMemoryStats();
+  if (memory_stats_path_.empty()) {
+    LogMemoryStats(std::cout, stats);
+    return;
+  }
+  std::ofstream file{memory_stats_path_, std::ios::trunc};
+  if (!file.is_open()) {
+    throw std::runtime_error{"Failed to open file: " + memory_stats_path_.string()};
+  }
+  WriteMemoryStatsJson(file, stats);
+}
+
 }  // namespace engine
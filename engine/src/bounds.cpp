@@ -0,0 +1,101 @@
+#include "engine/bounds.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+#include "simd.h"
+
+namespace {
+// The reduction loads a vertex's position as four floats, the fourth being the normal's x which is ignored
+static_assert(offsetof(engine::Vertex, normal) == offsetof(engine::Vertex, position) + sizeof(glm::vec3));
+
+// Sphere with the given center reaching the farthest vertex
+engine::BoundingSphere EncloseFrom(const std::vector<engine::Vertex>& vertices, const glm::vec3& center) {
+  float max_distance_squared = 0.0f;
+  for (const engine::Vertex& vertex : vertices) {
+    const glm::vec3 offset = vertex.position - center;
+    max_distance_squared = std::max(max_distance_squared, glm::dot(offset, offset));
+  }
+  return {.center = center, .radius = std::sqrt(max_distance_squared)};
+}
+
+const engine::Vertex& FindFarthest(const std::vector<engine::Vertex>& vertices, const glm::vec3& point) {
+  return *std::max_element(vertices.begin(), vertices.end(), [&](const engine::Vertex& lhs, const engine::Vertex& rhs) {
+    const glm::vec3 lhs_offset = lhs.position - point;
+    const glm::vec3 rhs_offset = rhs.position - point;
+    return glm::dot(lhs_offset, lhs_offset) < glm::dot(rhs_offset, rhs_offset);
+  });
+}
+
+// Ritter's sphere: starts from two far apart vertices and grows just enough to take in each vertex outside of it
+engine::BoundingSphere ComputeRitterSphere(const std::vector<engine::Vertex>& vertices) {
+  const glm::vec3 a = FindFarthest(vertices, vertices[0].position).position;
+  const glm::vec3 b = FindFarthest(vertices, a).position;
+  glm::vec3 center = (a + b) * 0.5f;
+  float radius = glm::length(b - a) * 0.5f;
+  for (const engine::Vertex& vertex : vertices) {
+    const float distance = glm::length(vertex.position - center);
+    if (distance > radius) {
+      const float grown_radius = (radius + distance) * 0.5f;
+      center += (vertex.position - center) * ((grown_radius - radius) / distance);
+      radius = grown_radius;
+    }
+  }
+  // The growth steps accumulate rounding errors, the final radius is measured instead
+  return EncloseFrom(vertices, center);
+}
+}  // namespace
+
+namespace engine {
+Bounds Bounds::Transformed(const Transform& transform) const {
+  const glm::vec3 scaled_min = box.min * transform.scale;
+  const glm::vec3 scaled_max = box.max * transform.scale;
+  return {
+      .box = {.min = glm::min(scaled_min, scaled_max) + transform.translation,
+              .max = glm::max(scaled_min, scaled_max) + transform.translation},
+      .sphere = {.center = sphere.center * transform.scale + transform.translation,
+                 .radius = sphere.radius * std::abs(transform.scale)},
+  };
+}
+
+BoundingBox ComputeBoundingBox(const std::vector<Vertex>& vertices) {
+  assert(!vertices.empty());
+  const size_t count = vertices.size();
+  using simd::Floats4;
+  // Two accumulators per bound to hide the latency of the min/max chains
+  Floats4 min0 = Floats4::Load(&vertices[0].position.x);
+  Floats4 max0 = min0;
+  Floats4 min1 = min0;
+  Floats4 max1 = min0;
+  size_t i = 1;
+  for (; i + 1 < count; i += 2) {
+    const Floats4 p0 = Floats4::Load(&vertices[i].position.x);
+    const Floats4 p1 = Floats4::Load(&vertices[i + 1].position.x);
+    min0 = Min(min0, p0);
+    max0 = Max(max0, p0);
+    min1 = Min(min1, p1);
+    max1 = Max(max1, p1);
+  }
+  if (i < count) {
+    const Floats4 p = Floats4::Load(&vertices[i].position.x);
+    min0 = Min(min0, p);
+    max0 = Max(max0, p);
+  }
+  std::array<float, 4> min{};
+  std::array<float, 4> max{};
+  Min(min0, min1).Store(min.data());
+  Max(max0, max1).Store(max.data());
+  return {.min = {min[0], min[1], min[2]}, .max = {max[0], max[1], max[2]}};
+}
+
+Bounds ComputeBounds(const std::vector<Vertex>& vertices) {
+  const BoundingBox box = ComputeBoundingBox(vertices);
+  // Neither sphere is always the tighter one, e.g. the box's is better for boxes
+  const BoundingSphere ritter_sphere = ComputeRitterSphere(vertices);
+  const BoundingSphere box_sphere = EncloseFrom(vertices, box.GetCenter());
+  return {.box = box, .sphere = ritter_sphere.radius < box_sphere.radius ? ritter_sphere : box_sphere};
+}
+}  // namespace engine
@@ -1,31 +1,39 @@
 #include "engine/buffer.h"
 
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 
+#include "engine/upload_batch.h"
+
 namespace engine {
 Buffer::Buffer(Device& device, VkDeviceSize size, VkBufferUsageFlags usage_flags,
-               VkMemoryPropertyFlags memory_property_flags)
+               VkMemoryPropertyFlags memory_property_flags, MemoryCategory memory_category,
+               VkMemoryPropertyFlags preferred_memory_property_flags)
     : device_{device}, size_{size} {
-  Create(size, usage_flags, memory_property_flags);
+  Create(size, usage_flags, memory_property_flags, memory_category, preferred_memory_property_flags);
 }
 
 Buffer::~Buffer() {
   Unmap();
-  vkDestroyBuffer(device_.GetHandle(), buffer_, nullptr);
-  vkFreeMemory(device_.GetHandle(), buffer_memory_, nullptr);
+  device_.GetDeletionQueue().Enqueue([&device = device_, buffer = buffer_, allocation = allocation_]() mutable {
+    vkDestroyBuffer(device.GetHandle(), buffer, nullptr);
+    device.FreeMemory(allocation);
+  });
 }
 
-VkResult Buffer::Map(VkDeviceSize size, VkDeviceSize offset) {
-  return vkMapMemory(device_.GetHandle(), buffer_memory_, offset, size, 0, &mapped_);
+VkResult Buffer::Map(VkDeviceSize /* size */, VkDeviceSize offset) {
+  // Host-visible memory blocks are persistently mapped by the allocator
+  if (!allocation_.mapped) {
+    return VK_ERROR_MEMORY_MAP_FAILED;
+  }
+  mapped_ = static_cast<uint8_t*>(allocation_.mapped) + offset;
+  return VK_SUCCESS;
 }
 
 void Buffer::Unmap() {
-  if (mapped_) {
-    vkUnmapMemory(device_.GetHandle(), buffer_memory_);
-    mapped_ = nullptr;
-  }
+  mapped_ = nullptr;
 }
 
 void Buffer::Write(const void* data, VkDeviceSize size, VkDeviceSize offset) {
@@ -36,28 +44,29 @@ void Buffer::Write(const void* data, VkDeviceSize size, VkDeviceSize offset) {
   }
 }
 
-void Buffer::Flush(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange mapped_memory_range{};
-  mapped_memory_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  mapped_memory_range.memory = buffer_memory_;
-  mapped_memory_range.offset = offset;
-  mapped_memory_range.size = size;
-  vkFlushMappedMemoryRanges(device_.GetHandle(), 1, &mapped_memory_range);
+void Buffer::Flush(VkDeviceSize size, VkDeviceSize offset) const {
+  device_.GetMemoryAllocator().Flush(allocation_, size, offset);
 }
 
-void Buffer::CopyTo(const Buffer& dst, VkDeviceSize size, VkDeviceSize src_offset, VkDeviceSize dst_offset) {
-  VkCommandBuffer command_buffer = device_.BeginSingleTimeCommands();
-
-  VkBufferCopy copy_region{};
-  copy_region.srcOffset = src_offset;
-  copy_region.dstOffset = dst_offset;
-  copy_region.size = size;
-  vkCmdCopyBuffer(command_buffer, buffer_, dst.GetHandle(), 1, &copy_region);
+void Buffer::WriteDirect(const void* data, VkDeviceSize size, VkDeviceSize offset) const {
+  assert(IsHostVisible());
+  std::memcpy(static_cast<uint8_t*>(allocation_.mapped) + offset, data, size);
+  Flush(size, offset);
+}
 
-  device_.EndSingleTimeCommands(command_buffer);
+void Buffer::CopyTo(const Buffer& dst, VkDeviceSize size, VkDeviceSize src_offset, VkDeviceSize dst_offset) {
+  const VkDeviceSize copy_size = size == VK_WHOLE_SIZE ? size_ - src_offset : size;
+  if (IsHostVisible() && dst.IsHostVisible()) {
+    dst.WriteDirect(static_cast<const uint8_t*>(allocation_.mapped) + src_offset, copy_size, dst_offset);
+    return;
+  }
+  UploadBatch upload_batch{device_};
+  upload_batch.Copy(*this, dst, copy_size, src_offset, dst_offset);
+  device_.GetStagingRing().Wait(upload_batch.Submit());
 }
 
-void Buffer::Create(VkDeviceSize size, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags) {
+void Buffer::Create(VkDeviceSize size, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags,
+                    MemoryCategory memory_category, VkMemoryPropertyFlags preferred_memory_property_flags) {
   VkBufferCreateInfo buffer_create_info{};
   buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   buffer_create_info.size = size;
@@ -71,17 +80,13 @@ void Buffer::Create(VkDeviceSize size, VkBufferUsageFlags usage_flags, VkMemoryP
   VkMemoryRequirements memory_requirements;
   vkGetBufferMemoryRequirements(device_.GetHandle(), buffer_, &memory_requirements);
 
-  VkMemoryAllocateInfo memory_allocate_info{};
-  memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  memory_allocate_info.allocationSize = memory_requirements.size;
-  memory_allocate_info.memoryTypeIndex =
-      device_.QueryMemoryType(memory_requirements.memoryTypeBits, memory_property_flags);
+  allocation_ = device_.AllocateMemory(memory_requirements, memory_property_flags,
+                                       FreeListAllocator::ResourceKind::kLinear, memory_category,
+                                       preferred_memory_property_flags);
 
-  if (vkAllocateMemory(device_.GetHandle(), &memory_allocate_info, nullptr, &buffer_memory_) != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to allocate buffer memory!"};
+  if (vkBindBufferMemory(device_.GetHandle(), buffer_, allocation_.memory, allocation_.offset) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to bind buffer memory!"};
   }
-
-  vkBindBufferMemory(device_.GetHandle(), buffer_, buffer_memory_, 0);
 }
 
 }  // namespace engine
@@ -0,0 +1,35 @@
+#include "engine/deletion_queue.h"
+
+#include <cassert>
+
+namespace engine {
+DeletionQueue::~DeletionQueue() {
+  assert(IsEmpty());
+}
+
+void DeletionQueue::Enqueue(std::function<void()> deleter) {
+  deleters_.emplace_back(current_frame_, std::move(deleter));
+}
+
+void DeletionQueue::BeginFrame(uint64_t frame) {
+  assert(frame >= current_frame_);
+  current_frame_ = frame;
+}
+
+void DeletionQueue::Retire(uint64_t frame) {
+  // Deleters may enqueue more deleters, e.g. a resource owning other resources
+  while (!deleters_.empty() && deleters_.front().first <= frame) {
+    std::function<void()> deleter = std::move(deleters_.front().second);
+    deleters_.pop_front();
+    deleter();
+  }
+}
+
+void DeletionQueue::Flush() {
+  while (!deleters_.empty()) {
+    std::function<void()> deleter = std::move(deleters_.front().second);
+    deleters_.pop_front();
+    deleter();
+  }
+}
+}  // namespace engine
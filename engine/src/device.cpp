@@ -1,6 +1,7 @@
 #include "engine/device.h"
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #ifdef ENABLE_VALIDATION_LAYERS
 #include <iostream>
@@ -8,8 +9,12 @@
 #include <map>
 #include <optional>
 #include <stdexcept>
+#include <tuple>
 #include <unordered_set>
 
+#include "engine/geometry_arena.h"
+#include "engine/staging_ring.h"
+
 namespace {
 #ifdef ENABLE_VALIDATION_LAYERS
 VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT /* message_severity */,
@@ -45,6 +50,7 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
 struct QueueFamilyIndices {
   std::optional<uint32_t> graphics_family;
   std::optional<uint32_t> present_family;
+  std::optional<uint32_t> transfer_family;  // Only set for a transfer-only family
 
   [[nodiscard]] bool IsComplete() const { return graphics_family.has_value() && present_family.has_value(); }
 };
@@ -73,6 +79,16 @@ QueueFamilyIndices QueryQueueFamilyIndices(VkPhysicalDevice physical_device, VkS
     i++;
   }
   assert(indices.IsComplete());
+
+  // Families without graphics and compute support usually map to the DMA engines
+  for (uint32_t j = 0; j < queue_family_count; ++j) {
+    const VkQueueFlags queue_flags = queue_families[j].queueFlags;
+    if (queue_families[j].queueCount > 0 && (queue_flags & VK_QUEUE_TRANSFER_BIT) &&
+        !(queue_flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+      indices.transfer_family = j;
+      break;
+    }
+  }
   return indices;
 }
 
@@ -93,6 +109,17 @@ std::vector<const char*> RequiredExtensions() {
   return required_extensions;
 }
 
+bool IsInstanceExtensionAvailable(const char* extension_name) {
+  uint32_t extension_count = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
+  std::vector<VkExtensionProperties> extensions(extension_count);
+  vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, extensions.data());
+
+  return std::any_of(extensions.begin(), extensions.end(), [extension_name](const VkExtensionProperties& extension) {
+    return strcmp(extension_name, extension.extensionName) == 0;
+  });
+}
+
 void VerifyRequiredExtensions() {
   uint32_t extension_count = 0;
   vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
@@ -136,14 +163,30 @@ Device::Device(Window& window) : window_{window} {
   PickPhysicalDevice();
   CreateLogicalDevice();
   CreateGraphicsCommandPool();
+  CreateTransferCommandPool();
+  CreateMemoryAllocator();
+  DetectMemoryArchitecture();
+  CreateStagingRing();
+  CreateGeometryArena();
   CreateDescriptorPool();
 }
 
 Device::~Device() {
+  vkDeviceWaitIdle(device_);
+  deletion_queue_.Flush();
+
   vkDestroyDescriptorPool(device_, descriptor_pool_, nullptr);
 
+  geometry_arena_.reset();
+  staging_ring_.reset();
+  // Their buffers
+  deletion_queue_.Flush();
+
+  vkDestroyCommandPool(device_, transfer_command_pool_, nullptr);
   vkDestroyCommandPool(device_, graphics_command_pool_, nullptr);
 
+  memory_allocator_.reset();
+
   vkDestroyDevice(device_, nullptr);
 
   vkDestroySurfaceKHR(instance_, surface_, nullptr);
@@ -155,18 +198,66 @@ Device::~Device() {
   vkDestroyInstance(instance_, nullptr);
 }
 
-uint32_t Device::QueryMemoryType(uint32_t type_filter, VkMemoryPropertyFlags memory_property_flags) const {
-  VkPhysicalDeviceMemoryProperties memory_properties;
-  vkGetPhysicalDeviceMemoryProperties(physical_device_, &memory_properties);
+uint32_t Device::QueryMemoryType(uint32_t type_filter, VkMemoryPropertyFlags required_flags,
+                                 VkMemoryPropertyFlags preferred_flags) const {
+  const VkPhysicalDeviceMemoryProperties& memory_properties = memory_allocator_->GetMemoryProperties();
 
+  std::optional<uint32_t> best_memory_type;
+  std::tuple<int32_t, int32_t, VkDeviceSize> best_score{};
   for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
-    if ((type_filter & (1 << i)) &&
-        (memory_properties.memoryTypes[i].propertyFlags & memory_property_flags) == memory_property_flags) {
-      return i;
+    const VkMemoryPropertyFlags flags = memory_properties.memoryTypes[i].propertyFlags;
+    if (!(type_filter & (1 << i)) || (flags & required_flags) != required_flags) {
+      continue;
+    }
+    const std::tuple<int32_t, int32_t, VkDeviceSize> score{
+        std::popcount(flags & preferred_flags),
+        -std::popcount(flags & ~(required_flags | preferred_flags)),
+        memory_properties.memoryHeaps[memory_properties.memoryTypes[i].heapIndex].size,
+    };
+    if (!best_memory_type || score > best_score) {
+      best_memory_type = i;
+      best_score = score;
+    }
+  }
+
+  if (!best_memory_type) {
+    throw std::runtime_error{"Failed to find suitable memory type!"};
+  }
+  return *best_memory_type;
+}
+
+MemoryAllocation Device::AllocateMemory(const VkMemoryRequirements& memory_requirements,
+                                       VkMemoryPropertyFlags memory_property_flags,
+                                       FreeListAllocator::ResourceKind kind, MemoryCategory category,
+                                       VkMemoryPropertyFlags preferred_memory_property_flags) {
+  const uint32_t memory_type_index = QueryMemoryType(memory_requirements.memoryTypeBits, memory_property_flags,
+                                                     preferred_memory_property_flags);
+  return memory_allocator_->Allocate(memory_requirements, memory_type_index, kind, category);
+}
+
+MemoryStats Device::QueryMemoryStats() const {
+  MemoryStats stats = memory_allocator_->QueryStats();
+  if (!memory_budget_enabled_) {
+    for (uint32_t i = 0; i < stats.heap_count; ++i) {
+      stats.heaps[i].budget = stats.heaps[i].size;
+      stats.heaps[i].usage = stats.heaps[i].block_bytes;
     }
+    return stats;
   }
 
-  throw std::runtime_error{"Failed to find suitable memory type!"};
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT memory_budget_properties{};
+  memory_budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  VkPhysicalDeviceMemoryProperties2KHR memory_properties{};
+  memory_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+  memory_properties.pNext = &memory_budget_properties;
+  get_physical_device_memory_properties2_(physical_device_, &memory_properties);
+
+  stats.has_budget = true;
+  for (uint32_t i = 0; i < stats.heap_count; ++i) {
+    stats.heaps[i].budget = memory_budget_properties.heapBudget[i];
+    stats.heaps[i].usage = memory_budget_properties.heapUsage[i];
+  }
+  return stats;
 }
 
 VkFormat Device::QuerySupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling,
@@ -189,49 +280,6 @@ VkFormat Device::QuerySupportedFormat(const std::vector<VkFormat>& candidates, V
   throw std::runtime_error{"Failed to find supported format!"};
 }
 
-VkCommandBuffer Device::BeginSingleTimeCommands() {
-  VkCommandBufferAllocateInfo command_buffer_allocate_info{};
-  command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  command_buffer_allocate_info.commandPool = graphics_command_pool_;
-  command_buffer_allocate_info.commandBufferCount = 1;
-
-  VkCommandBuffer command_buffer;
-  if (vkAllocateCommandBuffers(device_, &command_buffer_allocate_info, &command_buffer) != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to allocate command buffer!"};
-  }
-
-  VkCommandBufferBeginInfo command_buffer_begin_info{};
-  command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-  if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to begin recording command buffer!"};
-  }
-  return command_buffer;
-}
-
-void Device::EndSingleTimeCommands(VkCommandBuffer command_buffer) {
-  if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to record command buffer!"};
-  }
-
-  VkSubmitInfo submit_info{};
-  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  submit_info.commandBufferCount = 1;
-  submit_info.pCommandBuffers = &command_buffer;
-
-  if (vkQueueSubmit(graphics_queue_, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to submit command buffer!"};
-  }
-
-  if (vkQueueWaitIdle(graphics_queue_) != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to wait for command buffer to finish!"};
-  }
-
-  vkFreeCommandBuffers(device_, graphics_command_pool_, 1, &command_buffer);
-}
-
 void Device::CreateInstance() {
 #ifdef ENABLE_VALIDATION_LAYERS
   if (!CheckValidationLayerSupport()) {
@@ -256,6 +304,15 @@ void Device::CreateInstance() {
 
   VerifyRequiredExtensions();
   auto required_extensions = RequiredExtensions();
+  // Optional, needed for VK_EXT_memory_budget
+  physical_device_properties2_enabled_ =
+      IsInstanceExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+  if (physical_device_properties2_enabled_ &&
+      std::none_of(required_extensions.begin(), required_extensions.end(), [](const char* extension) {
+        return strcmp(extension, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0;
+      })) {
+    required_extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+  }
   instance_info.enabledExtensionCount = static_cast<uint32_t>(required_extensions.size());
   instance_info.ppEnabledExtensionNames = required_extensions.data();
 
@@ -359,6 +416,9 @@ void Device::CreateLogicalDevice() {
   std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
   std::unordered_set<uint32_t> unique_queue_family_indices = {queue_family_indices.graphics_family.value(),
                                                               queue_family_indices.present_family.value()};
+  if (queue_family_indices.transfer_family.has_value()) {
+    unique_queue_family_indices.insert(queue_family_indices.transfer_family.value());
+  }
 
   constexpr float kQueuePriority = 1.0f;
   for (uint32_t queue_family_index : unique_queue_family_indices) {
@@ -370,8 +430,14 @@ void Device::CreateLogicalDevice() {
     queue_create_infos.push_back(queue_create_info);
   }
 
+  VkPhysicalDeviceFeatures supported_features;
+  vkGetPhysicalDeviceFeatures(physical_device_, &supported_features);
+
   VkPhysicalDeviceFeatures device_features{};
   //  device_features.samplerAnisotropy = VK_TRUE;
+  // Optional, indirect drawing falls back to one call per draw without them
+  device_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+  device_features.drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance;
 
   VkDeviceCreateInfo create_info{};
   create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -381,8 +447,15 @@ void Device::CreateLogicalDevice() {
 
   create_info.pEnabledFeatures = &device_features;
 
-  create_info.enabledExtensionCount = static_cast<uint32_t>(kDeviceExtensions.size());
-  create_info.ppEnabledExtensionNames = kDeviceExtensions.data();
+  std::vector<const char*> device_extensions(kDeviceExtensions.begin(), kDeviceExtensions.end());
+  const bool memory_budget_supported =
+      physical_device_properties2_enabled_ &&
+      CheckPhysicalDeviceExtensionSupport(physical_device_, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  if (memory_budget_supported) {
+    device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+  create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
+  create_info.ppEnabledExtensionNames = device_extensions.data();
 
 #ifdef ENABLE_VALIDATION_LAYERS
   create_info.enabledLayerCount = static_cast<uint32_t>(kValidationLayers.size());
@@ -394,11 +467,22 @@ void Device::CreateLogicalDevice() {
   if (vkCreateDevice(physical_device_, &create_info, nullptr, &device_) != VK_SUCCESS) {
     throw std::runtime_error("Failed to create logical device!");
   }
+  enabled_features_ = device_features;
+
+  if (memory_budget_supported) {
+    get_physical_device_memory_properties2_ = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+        vkGetInstanceProcAddr(instance_, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+    memory_budget_enabled_ = get_physical_device_memory_properties2_ != nullptr;
+  }
 
   vkGetDeviceQueue(device_, queue_family_indices.graphics_family.value(), 0, &graphics_queue_);
   graphics_queue_family_index_ = queue_family_indices.graphics_family.value();
   vkGetDeviceQueue(device_, queue_family_indices.present_family.value(), 0, &present_queue_);
   present_queue_family_index_ = queue_family_indices.present_family.value();
+  // Without a transfer-only family, uploads share the graphics queue
+  transfer_queue_family_index_ =
+      queue_family_indices.transfer_family.value_or(queue_family_indices.graphics_family.value());
+  vkGetDeviceQueue(device_, transfer_queue_family_index_, 0, &transfer_queue_);
 }
 
 void Device::CreateGraphicsCommandPool() {
@@ -414,10 +498,60 @@ void Device::CreateGraphicsCommandPool() {
   }
 }
 
+void Device::CreateTransferCommandPool() {
+  VkCommandPoolCreateInfo pool_info{};
+  pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pool_info.queueFamilyIndex = transfer_queue_family_index_;
+  pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+  if (vkCreateCommandPool(device_, &pool_info, nullptr, &transfer_command_pool_) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create command pool!");
+  }
+}
+
+void Device::CreateMemoryAllocator() {
+  memory_allocator_ = std::make_unique<MemoryAllocator>(device_, physical_device_);
+}
+
+void Device::DetectMemoryArchitecture() {
+  constexpr VkDeviceSize kBarWindowSize = 256 * 1024 * 1024;
+  constexpr VkMemoryPropertyFlags kHostVisibleDeviceLocal =
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+  const VkPhysicalDeviceMemoryProperties& memory_properties = memory_allocator_->GetMemoryProperties();
+  const bool all_heaps_device_local =
+      std::all_of(memory_properties.memoryHeaps, memory_properties.memoryHeaps + memory_properties.memoryHeapCount,
+                  [](const VkMemoryHeap& heap) { return (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0; });
+  unified_memory_ =
+      physical_device_properties_.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || all_heaps_device_local;
+
+  large_host_visible_device_local_ = false;
+  for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
+    const VkMemoryType& memory_type = memory_properties.memoryTypes[i];
+    if ((memory_type.propertyFlags & kHostVisibleDeviceLocal) == kHostVisibleDeviceLocal &&
+        (unified_memory_ || memory_properties.memoryHeaps[memory_type.heapIndex].size > kBarWindowSize)) {
+      large_host_visible_device_local_ = true;
+    }
+  }
+#ifdef ENABLE_VALIDATION_LAYERS
+  std::cout << "Unified memory: " << unified_memory_
+            << ", large host-visible device-local memory: " << large_host_visible_device_local_ << std::endl;
+#endif
+}
+
+void Device::CreateStagingRing() {
+  staging_ring_ = std::make_unique<StagingRing>(*this);
+}
+
+void Device::CreateGeometryArena() {
+  geometry_arena_ = std::make_unique<GeometryArena>(*this);
+}
+
 void Device::CreateDescriptorPool() {
-  std::array<VkDescriptorPoolSize, 2> pool_sizes{{
+  std::array<VkDescriptorPoolSize, 3> pool_sizes{{
       {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 100},
       {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 100},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100},
   }};
 
   VkDescriptorPoolCreateInfo pool_info{};
@@ -460,6 +594,18 @@ int32_t Device::RatePhysicalDeviceSuitability(VkPhysicalDevice physical_device)
   return score > 0 ? score : -1;
 }
 
+bool Device::CheckPhysicalDeviceExtensionSupport(VkPhysicalDevice physical_device, const char* extension_name) {
+  uint32_t extension_count;
+  vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+  std::vector<VkExtensionProperties> available_extensions(extension_count);
+  vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, available_extensions.data());
+
+  return std::any_of(available_extensions.begin(), available_extensions.end(),
+                     [extension_name](const VkExtensionProperties& extension_properties) {
+                       return strcmp(extension_name, extension_properties.extensionName) == 0;
+                     });
+}
+
 bool Device::CheckPhysicalDeviceExtensionSupport(VkPhysicalDevice physical_device) {
   uint32_t extension_count;
   vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
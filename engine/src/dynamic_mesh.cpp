@@ -0,0 +1,102 @@
+#include "engine/dynamic_mesh.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine {
+DynamicMesh::DynamicMesh(Device& device, uint32_t vertex_capacity, uint32_t index_capacity)
+    : vertex_capacity_{vertex_capacity},
+      index_capacity_{index_capacity},
+      region_size_{sizeof(Vertex) * static_cast<VkDeviceSize>(vertex_capacity) +
+                   sizeof(uint32_t) * static_cast<VkDeviceSize>(index_capacity)} {
+  assert(vertex_capacity > 0 && index_capacity > 0);
+  // Device-local when resizable BAR or unified memory makes it host-visible too, the GPU reads it every frame
+  buffer_ = std::make_unique<Buffer>(device, region_size_ * Swapchain::kMaxFramesInFlight,
+                                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                     MemoryCategory::kGeometry, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+void DynamicMesh::Resize(uint32_t vertex_count, uint32_t index_count) {
+  assert(vertex_count <= vertex_capacity_ && index_count <= index_capacity_);
+  if (vertex_count > vertices_.size()) {
+    MarkDirty(dirty_vertices_, static_cast<uint32_t>(vertices_.size()),
+              vertex_count - static_cast<uint32_t>(vertices_.size()));
+  }
+  if (index_count > indices_.size()) {
+    MarkDirty(dirty_indices_, static_cast<uint32_t>(indices_.size()),
+              index_count - static_cast<uint32_t>(indices_.size()));
+  }
+  vertices_.resize(vertex_count);
+  indices_.resize(index_count);
+}
+
+std::span<Vertex> DynamicMesh::WriteVertices(uint32_t first_vertex, uint32_t vertex_count) {
+  assert(first_vertex + vertex_count <= vertices_.size());
+  MarkDirty(dirty_vertices_, first_vertex, vertex_count);
+  return std::span<Vertex>{vertices_}.subspan(first_vertex, vertex_count);
+}
+
+std::span<uint32_t> DynamicMesh::WriteIndices(uint32_t first_index, uint32_t index_count) {
+  assert(first_index + index_count <= indices_.size());
+  MarkDirty(dirty_indices_, first_index, index_count);
+  return std::span<uint32_t>{indices_}.subspan(first_index, index_count);
+}
+
+void DynamicMesh::Commit(uint32_t frame_index) {
+  assert(frame_index < Swapchain::kMaxFramesInFlight);
+  frame_index_ = frame_index;
+  // Writes past counts shrunk since are dropped
+  DirtyRange& dirty_vertices = dirty_vertices_[frame_index];
+  dirty_vertices.end = std::min(dirty_vertices.end, static_cast<uint32_t>(vertices_.size()));
+  if (dirty_vertices.begin < dirty_vertices.end) {
+    buffer_->WriteDirect(vertices_.data() + dirty_vertices.begin,
+                         sizeof(Vertex) * (dirty_vertices.end - dirty_vertices.begin),
+                         GetVertexOffset(frame_index) + sizeof(Vertex) * dirty_vertices.begin);
+  }
+  dirty_vertices = {};
+  DirtyRange& dirty_indices = dirty_indices_[frame_index];
+  dirty_indices.end = std::min(dirty_indices.end, static_cast<uint32_t>(indices_.size()));
+  if (dirty_indices.begin < dirty_indices.end) {
+    buffer_->WriteDirect(indices_.data() + dirty_indices.begin,
+                         sizeof(uint32_t) * (dirty_indices.end - dirty_indices.begin),
+                         GetIndexOffset(frame_index) + sizeof(uint32_t) * dirty_indices.begin);
+  }
+  dirty_indices = {};
+  committed_index_counts_[frame_index] = static_cast<uint32_t>(indices_.size());
+}
+
+void DynamicMesh::Bind(VkCommandBuffer command_buffer) const {
+  const VkBuffer buffer = buffer_->GetHandle();
+  const VkDeviceSize vertex_offset = GetVertexOffset(frame_index_);
+  vkCmdBindVertexBuffers(command_buffer, 0, 1, &buffer, &vertex_offset);
+  vkCmdBindIndexBuffer(command_buffer, buffer, GetIndexOffset(frame_index_), VK_INDEX_TYPE_UINT32);
+}
+
+void DynamicMesh::Draw(VkCommandBuffer command_buffer, uint32_t first_instance) const {
+  if (committed_index_counts_[frame_index_] > 0) {
+    vkCmdDrawIndexed(command_buffer, committed_index_counts_[frame_index_], 1, 0, 0, first_instance);
+  }
+}
+
+void DynamicMesh::DirtyRange::Add(uint32_t first, uint32_t count) {
+  if (begin == end) {
+    begin = first;
+    end = first + count;
+    return;
+  }
+  begin = std::min(begin, first);
+  end = std::max(end, first + count);
+}
+
+void DynamicMesh::MarkDirty(std::array<DirtyRange, Swapchain::kMaxFramesInFlight>& dirty_ranges, uint32_t first,
+                            uint32_t count) {
+  if (count == 0) {
+    return;
+  }
+  // Every region misses the write until it is next committed
+  for (DirtyRange& dirty_range : dirty_ranges) {
+    dirty_range.Add(first, count);
+  }
+}
+}  // namespace engine
@@ -0,0 +1,73 @@
+#include "engine/frame_arena.h"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <stdexcept>
+
+#include "engine/buffer.h"
+#include "engine/device.h"
+
+namespace {
+// Alignments such as sizeof(T) need not be powers of two
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+namespace engine {
+FrameArena::FrameArena(Device& device, VkDeviceSize size) : device_{device}, size_{size} {
+  const VkPhysicalDeviceLimits& limits = device_.GetProperties().limits;
+  min_alignment_ = std::max<VkDeviceSize>(
+      {limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, 1});
+  CreateBuffer();
+}
+
+FrameArena::~FrameArena() = default;
+
+VkDeviceSize FrameArena::GetAvailableSize(VkDeviceSize alignment) const {
+  return size_ - std::min(AlignUp(head_, alignment), size_);
+}
+
+std::optional<FrameArena::Allocation> FrameArena::Allocate(VkDeviceSize size, VkDeviceSize alignment) {
+  required_size_ = AlignUp(required_size_, alignment) + size;
+  const VkDeviceSize offset = AlignUp(head_, alignment);
+  if (offset + size > size_) {
+    return std::nullopt;
+  }
+  head_ = offset + size;
+  return Allocation{.buffer = buffer_->GetHandle(), .offset = offset, .size = size, .mapped = mapped_ + offset};
+}
+
+void FrameArena::Flush() {
+  if (head_ > 0) {
+    buffer_->Flush(head_, 0);
+  }
+}
+
+bool FrameArena::Reset() {
+  const bool grow = required_size_ > size_;
+  if (grow) {
+    // Doubling leaves room for the scene to keep growing without reallocating every frame
+    size_ = std::max(2 * size_, std::bit_ceil(required_size_));
+    CreateBuffer();
+    std::cout << "Frame arena grown to " << size_ / 1024 << " KiB" << std::endl;
+  }
+  head_ = 0;
+  required_size_ = 0;
+  return grow;
+}
+
+void FrameArena::CreateBuffer() {
+  // Replacing the buffer defers the destruction of the old one through the device's deletion queue
+  buffer_ = std::make_unique<Buffer>(
+      device_, size_,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::kUniform,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  if (buffer_->Map() != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to map frame arena!"};
+  }
+  mapped_ = static_cast<uint8_t*>(buffer_->GetMappedMemory());
+}
+}  // namespace engine
@@ -0,0 +1,123 @@
+#include "engine/free_list_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+namespace engine {
+FreeListAllocator::FreeListAllocator(uint64_t size, uint64_t granularity)
+    : size_{size}, granularity_{std::max<uint64_t>(granularity, 1)} {
+  assert(size_ > 0);
+  ranges_.emplace(0, Range{.size = size_});
+  free_by_size_.emplace(size_, 0);
+}
+
+std::optional<uint64_t> FreeListAllocator::Allocate(uint64_t size, uint64_t alignment, ResourceKind kind) {
+  assert(size > 0);
+  alignment = std::max<uint64_t>(alignment, 1);
+
+  for (auto free_it = free_by_size_.lower_bound(size); free_it != free_by_size_.end(); ++free_it) {
+    const uint64_t range_offset = free_it->second;
+    const uint64_t range_end = range_offset + free_it->first;
+    auto range_it = ranges_.find(range_offset);
+    assert(range_it != ranges_.end() && range_it->second.free);
+
+    uint64_t offset = AlignUp(range_offset, alignment);
+    if (range_it != ranges_.begin()) {
+      const auto& [previous_offset, previous] = *std::prev(range_it);
+      if (previous.kind != kind && OnSamePage(previous_offset + previous.size, offset)) {
+        offset = AlignUp(offset, granularity_);
+      }
+    }
+    if (offset + size > range_end) {
+      continue;
+    }
+    auto next_it = std::next(range_it);
+    if (next_it != ranges_.end() && next_it->second.kind != kind && OnSamePage(offset + size, next_it->first)) {
+      continue;
+    }
+
+    EraseFree(range_offset, range_end - range_offset);
+    ranges_.erase(range_it);
+    if (offset > range_offset) {
+      InsertFree(range_offset, offset - range_offset);
+    }
+    if (offset + size < range_end) {
+      InsertFree(offset + size, range_end - (offset + size));
+    }
+    ranges_.emplace(offset, Range{.size = size, .free = false, .kind = kind});
+
+    used_ += size;
+    ++allocation_count_;
+    return offset;
+  }
+  return std::nullopt;
+}
+
+void FreeListAllocator::Free(uint64_t offset) {
+  auto it = ranges_.find(offset);
+  if (it == ranges_.end() || it->second.free) {
+    throw std::invalid_argument{"Freeing an offset that was not allocated!"};
+  }
+  uint64_t size = it->second.size;
+  used_ -= size;
+  --allocation_count_;
+
+  // Coalesce with free neighbours
+  if (auto next_it = std::next(it); next_it != ranges_.end() && next_it->second.free) {
+    size += next_it->second.size;
+    EraseFree(next_it->first, next_it->second.size);
+    ranges_.erase(next_it);
+  }
+  if (it != ranges_.begin()) {
+    if (auto previous_it = std::prev(it); previous_it->second.free) {
+      offset = previous_it->first;
+      size += previous_it->second.size;
+      EraseFree(previous_it->first, previous_it->second.size);
+      ranges_.erase(previous_it);
+    }
+  }
+  ranges_.erase(it);
+  InsertFree(offset, size);
+}
+
+FreeListAllocator::Statistics FreeListAllocator::QueryStatistics() const {
+  Statistics statistics{
+      .size = size_,
+      .used = used_,
+      .allocation_count = allocation_count_,
+      .free_range_count = static_cast<uint32_t>(free_by_size_.size()),
+  };
+  if (!free_by_size_.empty()) {
+    statistics.largest_free_range = free_by_size_.rbegin()->first;
+  }
+  return statistics;
+}
+
+void FreeListAllocator::InsertFree(uint64_t offset, uint64_t size) {
+  ranges_.insert_or_assign(offset, Range{.size = size});
+  free_by_size_.emplace(size, offset);
+}
+
+void FreeListAllocator::EraseFree(uint64_t offset, uint64_t size) {
+  auto [begin, end] = free_by_size_.equal_range(size);
+  auto it = std::find_if(begin, end, [offset](const auto& entry) { return entry.second == offset; });
+  assert(it != end);
+  free_by_size_.erase(it);
+}
+
+bool FreeListAllocator::OnSamePage(uint64_t end_of_first, uint64_t start_of_second) const {
+  if (granularity_ == 1 || end_of_first == 0) {
+    return false;
+  }
+  return (end_of_first - 1) / granularity_ == start_of_second / granularity_;
+}
+
+}  // namespace engine
@@ -0,0 +1,24 @@
+#include "engine/frustum.h"
+
+namespace engine {
+Frustum::Frustum(const glm::mat4& matrix) {
+  // Gribb & Hartmann, glm matrices are column-major
+  const glm::vec4 row0{matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]};
+  const glm::vec4 row1{matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]};
+  const glm::vec4 row2{matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]};
+  const glm::vec4 row3{matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]};
+  planes_ = {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row2, row3 - row2};
+  for (glm::vec4& plane : planes_) {
+    plane /= glm::length(glm::vec3{plane});
+  }
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const {
+  for (const glm::vec4& plane : planes_) {
+    if (glm::dot(glm::vec3{plane}, center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace engine
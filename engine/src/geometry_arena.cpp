@@ -0,0 +1,122 @@
+#include "engine/geometry_arena.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+#include "engine/buffer.h"
+#include "engine/device.h"
+#include "engine/vertex.h"
+
+namespace engine {
+GeometryArena::GeometryArena(Device& device) : device_{device} {}
+
+GeometryArena::~GeometryArena() = default;
+
+GeometryArena::Page::Page(const GeometryFormat& format, uint32_t vertex_capacity, uint32_t index_capacity)
+    : format{format}, vertices{vertex_capacity}, indices{index_capacity} {}
+
+GeometryArena::Page::~Page() = default;
+
+GeometryRange GeometryArena::Allocate(const GeometryFormat& format, uint32_t vertex_count, uint32_t index_count) {
+  assert(vertex_count > 0 && index_count > 0);
+
+  auto allocate_from = [&](uint32_t page_index) -> std::optional<GeometryRange> {
+    Page& page = *pages_[page_index];
+    if (page.format != format) {
+      return std::nullopt;
+    }
+    auto vertex_offset = page.vertices.Allocate(vertex_count);
+    if (!vertex_offset) {
+      return std::nullopt;
+    }
+    auto first_index = page.indices.Allocate(index_count);
+    if (!first_index) {
+      page.vertices.Free(*vertex_offset);
+      return std::nullopt;
+    }
+    return GeometryRange{
+        .page = page_index,
+        .vertex_offset = static_cast<int32_t>(*vertex_offset),
+        .vertex_count = vertex_count,
+        .first_index = static_cast<uint32_t>(*first_index),
+        .index_count = index_count,
+    };
+  };
+
+  for (uint32_t i = 0; i < GetPageCount(); ++i) {
+    if (auto range = allocate_from(i)) {
+      return *range;
+    }
+  }
+  CreatePage(format, std::max(vertex_count, kDefaultPageVertexCount),
+             std::max(index_count, kDefaultPageIndexCount));
+  auto range = allocate_from(GetPageCount() - 1);
+  assert(range.has_value());
+  return *range;
+}
+
+void GeometryArena::Free(GeometryRange& range) {
+  if (range.vertex_count == 0) {
+    return;
+  }
+  Page& page = *pages_[range.page];
+  page.vertices.Free(static_cast<uint64_t>(range.vertex_offset));
+  page.indices.Free(range.first_index);
+  range = {};
+}
+
+void GeometryArena::Bind(VkCommandBuffer command_buffer, uint32_t page) const {
+  if (pages_[page]->format.vertex_streams == VertexStreams::kSplitPositions) {
+    const std::array<VkBuffer, 2> vertex_buffers{pages_[page]->position_buffer->GetHandle(),
+                                                 pages_[page]->vertex_buffer->GetHandle()};
+    const std::array<VkDeviceSize, 2> offsets{0, 0};
+    vkCmdBindVertexBuffers(command_buffer, 0, 2, vertex_buffers.data(), offsets.data());
+  } else {
+    VkBuffer vertex_buffer = pages_[page]->vertex_buffer->GetHandle();
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertex_buffer, &offset);
+  }
+  vkCmdBindIndexBuffer(command_buffer, pages_[page]->index_buffer->GetHandle(), 0, pages_[page]->format.index_type);
+}
+
+void GeometryArena::BindPositions(VkCommandBuffer command_buffer, uint32_t page) const {
+  if (pages_[page]->format.vertex_streams != VertexStreams::kSplitPositions) {
+    throw std::runtime_error{"Page has no position stream!"};
+  }
+  VkBuffer position_buffer = pages_[page]->position_buffer->GetHandle();
+  VkDeviceSize offset = 0;
+  vkCmdBindVertexBuffers(command_buffer, 0, 1, &position_buffer, &offset);
+  vkCmdBindIndexBuffer(command_buffer, pages_[page]->index_buffer->GetHandle(), 0, pages_[page]->format.index_type);
+}
+
+GeometryArena::Page& GeometryArena::CreatePage(const GeometryFormat& format, uint32_t vertex_capacity,
+                                               uint32_t index_capacity) {
+  // Write geometry directly where device-local memory is host-visible, but keep it out of a small BAR window
+  const VkMemoryPropertyFlags preferred_memory_property_flags =
+      device_.HasLargeHostVisibleDeviceLocalMemory()
+          ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+          : 0;
+
+  auto page = std::make_unique<Page>(format, vertex_capacity, index_capacity);
+  if (format.vertex_streams == VertexStreams::kSplitPositions) {
+    const uint32_t position_stride = GetVertexStride(format.vertex_format, format.vertex_streams, 0);
+    page->position_buffer = std::make_unique<Buffer>(
+        device_, static_cast<VkDeviceSize>(vertex_capacity) * position_stride,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        MemoryCategory::kGeometry, preferred_memory_property_flags);
+  }
+  const uint32_t vertex_stride = GetVertexStride(format.vertex_format, format.vertex_streams,
+                                                format.vertex_streams == VertexStreams::kSplitPositions ? 1 : 0);
+  page->vertex_buffer = std::make_unique<Buffer>(
+      device_, static_cast<VkDeviceSize>(vertex_capacity) * vertex_stride,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      MemoryCategory::kGeometry, preferred_memory_property_flags);
+  page->index_buffer = std::make_unique<Buffer>(
+      device_, static_cast<VkDeviceSize>(index_capacity) * GetIndexSize(format.index_type),
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      MemoryCategory::kGeometry, preferred_memory_property_flags);
+  return *pages_.emplace_back(std::move(page));
+}
+}  // namespace engine
@@ -7,16 +7,11 @@
 #include "engine/utils.h"
 
 namespace engine {
-GraphicsPipelineConfig GraphicsPipelineConfig::Default() {
+GraphicsPipelineConfig GraphicsPipelineConfig::Default(VertexFormat vertex_format, VertexStreams vertex_streams) {
   GraphicsPipelineConfig config{};
 
   config.vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  config.vertex_input_info.vertexBindingDescriptionCount =
-      static_cast<uint32_t>(config.vertex_binding_descriptions.size());
-  config.vertex_input_info.pVertexBindingDescriptions = config.vertex_binding_descriptions.data();
-  config.vertex_input_info.vertexAttributeDescriptionCount =
-      static_cast<uint32_t>(config.vertex_attribute_descriptions.size());
-  config.vertex_input_info.pVertexAttributeDescriptions = config.vertex_attribute_descriptions.data();
+  config.SetVertexFormat(vertex_format, vertex_streams);
 
   config.input_assembly_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
   config.input_assembly_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -93,6 +88,17 @@ GraphicsPipelineConfig GraphicsPipelineConfig::Default() {
   return config;
 }
 
+void GraphicsPipelineConfig::SetVertexFormat(VertexFormat vertex_format, VertexStreams vertex_streams) {
+  VisitVertexLayout(vertex_format, vertex_streams, [this]<typename Layout>() { SetVertexLayout<Layout>(); });
+}
+
+void GraphicsPipelineConfig::UpdateVertexInputInfo() {
+  vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(vertex_binding_descriptions.size());
+  vertex_input_info.pVertexBindingDescriptions = vertex_binding_descriptions.data();
+  vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertex_attribute_descriptions.size());
+  vertex_input_info.pVertexAttributeDescriptions = vertex_attribute_descriptions.data();
+}
+
 GraphicsPipeline::GraphicsPipeline(Device& device, const GraphicsPipelineConfig& config,
                                    const std::filesystem::path& vertex_shader_path,
                                    const std::filesystem::path& fragment_shader_path)
@@ -0,0 +1,218 @@
+#include "engine/index_codec.h"
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr uint32_t kEdgeFifoSize = 15;  // Ages 0-14 fit the high nibble of a code, 15 marks a triangle without an edge
+constexpr uint8_t kNoEdgeCode = 0xF0;   // Low bits: which of the three vertices are the next unseen index
+
+// Low nibble of a code with an edge, how the third vertex is encoded
+constexpr uint8_t kThirdNext = 0;       // The next unseen index
+constexpr uint8_t kThirdExplicit = 1;   // Delta varint
+constexpr uint8_t kThirdFollowing = 2;  // One past the last explicitly encoded index, e.g. along a grid row
+
+using Edge = std::pair<uint32_t, uint32_t>;
+
+// Directed edges of recent triangles, a neighbour with the same winding walks a shared edge backwards
+class EdgeFifo {
+ public:
+  EdgeFifo() { edges_.fill({~0u, ~0u}); }
+
+  void Push(uint32_t a, uint32_t b) {
+    head_ = (head_ + 1) % kEdgeFifoSize;
+    edges_[head_] = {a, b};
+  }
+  [[nodiscard]] const Edge& Get(uint32_t age) const { return edges_[(head_ + kEdgeFifoSize - age) % kEdgeFifoSize]; }
+
+ private:
+  std::array<Edge, kEdgeFifoSize> edges_{};
+  uint32_t head_ = 0;
+};
+
+// Tracks the next unseen index and the last explicitly encoded one, identically on both sides
+struct VertexPredictor {
+  uint32_t next = 0;
+  uint32_t last = 0;
+
+  void Update(uint32_t vertex) {
+    if (vertex >= next) {
+      next = vertex + 1;
+    }
+  }
+};
+
+void WriteVarint(std::vector<uint8_t>& bytes, uint32_t value) {
+  while (value >= 0x80) {
+    bytes.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<uint8_t>(value));
+}
+
+class Reader {
+ public:
+  Reader(const uint8_t* data, size_t size) : data_{data}, size_{size} {}
+
+  uint8_t ReadByte() {
+    if (position_ >= size_) {
+      throw std::runtime_error{"Truncated index data!"};
+    }
+    return data_[position_++];
+  }
+  uint32_t ReadVarint() {
+    uint32_t value = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7) {
+      const uint8_t byte = ReadByte();
+      value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw std::runtime_error{"Invalid varint in index data!"};
+  }
+  [[nodiscard]] bool IsAtEnd() const { return position_ == size_; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_ = 0;
+};
+
+void EncodeVertex(std::vector<uint8_t>& bytes, VertexPredictor& predictor, uint32_t vertex) {
+  const auto delta = static_cast<int32_t>(vertex - predictor.last);
+  WriteVarint(bytes, static_cast<uint32_t>(delta << 1) ^ static_cast<uint32_t>(delta >> 31));  // Zigzag
+  predictor.last = vertex;
+  predictor.Update(vertex);
+}
+
+uint32_t DecodeVertex(Reader& reader, VertexPredictor& predictor, bool is_next) {
+  uint32_t vertex;
+  if (is_next) {
+    vertex = predictor.next;
+  } else {
+    const uint32_t zigzag = reader.ReadVarint();
+    vertex = predictor.last + ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+    predictor.last = vertex;
+  }
+  predictor.Update(vertex);
+  return vertex;
+}
+}  // namespace
+
+namespace engine {
+std::vector<uint8_t> EncodeIndices(const std::vector<uint32_t>& indices) {
+  assert(indices.size() % 3 == 0);
+  std::vector<uint8_t> bytes;
+  bytes.reserve(indices.size());
+
+  EdgeFifo edge_fifo;
+  VertexPredictor predictor;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const std::array<uint32_t, 3> triangle{indices[i + 0], indices[i + 1], indices[i + 2]};
+
+    // The most recent edge shared with any rotation of the triangle
+    bool found = false;
+    for (uint32_t age = 0; age < kEdgeFifoSize && !found; ++age) {
+      const Edge& edge = edge_fifo.Get(age);
+      for (uint32_t rotation = 0; rotation < 3 && !found; ++rotation) {
+        const uint32_t a = triangle[rotation];
+        const uint32_t b = triangle[(rotation + 1) % 3];
+        const uint32_t c = triangle[(rotation + 2) % 3];
+        if (edge.first != b || edge.second != a) {
+          continue;
+        }
+        found = true;
+        if (c == predictor.next) {
+          bytes.push_back(static_cast<uint8_t>(age << 4 | kThirdNext));
+          predictor.Update(c);
+        } else if (c == predictor.last + 1) {
+          bytes.push_back(static_cast<uint8_t>(age << 4 | kThirdFollowing));
+          predictor.last = c;
+          predictor.Update(c);
+        } else {
+          bytes.push_back(static_cast<uint8_t>(age << 4 | kThirdExplicit));
+          EncodeVertex(bytes, predictor, c);
+        }
+        edge_fifo.Push(b, c);
+        edge_fifo.Push(c, a);
+      }
+    }
+    if (found) {
+      continue;
+    }
+
+    const size_t code_position = bytes.size();
+    bytes.push_back(kNoEdgeCode);
+    for (uint32_t j = 0; j < 3; ++j) {
+      if (triangle[j] == predictor.next) {
+        bytes[code_position] |= static_cast<uint8_t>(1 << j);
+        predictor.Update(triangle[j]);
+      } else {
+        EncodeVertex(bytes, predictor, triangle[j]);
+      }
+    }
+    edge_fifo.Push(triangle[0], triangle[1]);
+    edge_fifo.Push(triangle[1], triangle[2]);
+    edge_fifo.Push(triangle[2], triangle[0]);
+  }
+  return bytes;
+}
+
+std::vector<uint32_t> DecodeIndices(const uint8_t* data, size_t size, uint32_t index_count) {
+  if (index_count % 3 != 0) {
+    throw std::runtime_error{"Index count is not a multiple of three!"};
+  }
+  // Each triangle takes at least its code byte, checked before the indices are allocated
+  if (index_count / 3 > size) {
+    throw std::runtime_error{"Index data is too short!"};
+  }
+  std::vector<uint32_t> indices(index_count);
+
+  Reader reader{data, size};
+  EdgeFifo edge_fifo;
+  VertexPredictor predictor;
+  for (uint32_t i = 0; i < index_count; i += 3) {
+    const uint8_t code = reader.ReadByte();
+    if (code < kNoEdgeCode) {
+      const Edge& edge = edge_fifo.Get(code >> 4);
+      const uint32_t a = edge.second;
+      const uint32_t b = edge.first;
+      uint32_t c;
+      switch (code & 0x0F) {
+        case kThirdNext:
+          c = DecodeVertex(reader, predictor, true);
+          break;
+        case kThirdExplicit:
+          c = DecodeVertex(reader, predictor, false);
+          break;
+        case kThirdFollowing:
+          c = predictor.last + 1;
+          predictor.last = c;
+          predictor.Update(c);
+          break;
+        default:
+          throw std::runtime_error{"Invalid code in index data!"};
+      }
+      indices[i + 0] = a;
+      indices[i + 1] = b;
+      indices[i + 2] = c;
+      edge_fifo.Push(b, c);
+      edge_fifo.Push(c, a);
+    } else {
+      for (uint32_t j = 0; j < 3; ++j) {
+        indices[i + j] = DecodeVertex(reader, predictor, code & (1 << j));
+      }
+      edge_fifo.Push(indices[i + 0], indices[i + 1]);
+      edge_fifo.Push(indices[i + 1], indices[i + 2]);
+      edge_fifo.Push(indices[i + 2], indices[i + 0]);
+    }
+  }
+  if (!reader.IsAtEnd()) {
+    throw std::runtime_error{"Trailing bytes after index data!"};
+  }
+  return indices;
+}
+}  // namespace engine
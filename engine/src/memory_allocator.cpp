@@ -0,0 +1,210 @@
+#include "engine/memory_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <stdexcept>
+
+namespace engine {
+struct MemoryBlock {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  uint32_t memory_type_index = 0;
+  bool dedicated = false;
+  void* mapped = nullptr;
+  FreeListAllocator allocator;
+
+  MemoryBlock(VkDeviceSize size, VkDeviceSize granularity) : allocator{size, granularity} {}
+};
+
+MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physical_device) : device_{device} {
+  vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties_);
+
+  VkPhysicalDeviceProperties physical_device_properties;
+  vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+  buffer_image_granularity_ = std::max<VkDeviceSize>(physical_device_properties.limits.bufferImageGranularity, 1);
+  non_coherent_atom_size_ = std::max<VkDeviceSize>(physical_device_properties.limits.nonCoherentAtomSize, 1);
+  max_memory_allocation_count_ = physical_device_properties.limits.maxMemoryAllocationCount;
+}
+
+MemoryAllocator::~MemoryAllocator() {
+  for (auto& memory_type_blocks : blocks_) {
+    for (auto& block : memory_type_blocks) {
+      assert(block->allocator.IsEmpty());
+      if (block->mapped) {
+        vkUnmapMemory(device_, block->memory);
+      }
+      vkFreeMemory(device_, block->memory, nullptr);
+    }
+  }
+}
+
+MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& memory_requirements,
+                                           uint32_t memory_type_index, FreeListAllocator::ResourceKind kind,
+                                           MemoryCategory category) {
+  assert(memory_type_index < memory_properties_.memoryTypeCount);
+  auto& memory_type_blocks = blocks_[memory_type_index];
+
+  auto allocate_from = [&](MemoryBlock& block) -> std::optional<MemoryAllocation> {
+    auto offset = block.allocator.Allocate(memory_requirements.size, memory_requirements.alignment, kind);
+    if (!offset) {
+      return std::nullopt;
+    }
+    auto& category_stats = category_stats_[static_cast<uint32_t>(category)];
+    category_stats.allocation_count += 1;
+    category_stats.allocation_bytes += memory_requirements.size;
+    return MemoryAllocation{
+        .memory = block.memory,
+        .offset = *offset,
+        .size = memory_requirements.size,
+        .memory_type_index = memory_type_index,
+        .mapped = block.mapped ? static_cast<uint8_t*>(block.mapped) + *offset : nullptr,
+        .category = category,
+        .block = &block,
+    };
+  };
+
+  // Large resources get a block of their own, splitting them into a shared block would only waste its tail
+  const VkDeviceSize block_size = PreferredBlockSize(memory_type_index);
+  if (memory_requirements.size > block_size / 2) {
+    return *allocate_from(CreateBlock(memory_type_index, memory_requirements.size, true));
+  }
+
+  for (auto& block : memory_type_blocks) {
+    if (block->dedicated) {
+      continue;
+    }
+    if (auto allocation = allocate_from(*block)) {
+      return *allocation;
+    }
+  }
+  auto allocation = allocate_from(CreateBlock(memory_type_index, block_size, false));
+  assert(allocation.has_value());
+  return *allocation;
+}
+
+void MemoryAllocator::Free(MemoryAllocation& allocation) {
+  if (!allocation.block) {
+    return;
+  }
+  MemoryBlock& block = *allocation.block;
+  block.allocator.Free(allocation.offset);
+  auto& category_stats = category_stats_[static_cast<uint32_t>(allocation.category)];
+  category_stats.allocation_count -= 1;
+  category_stats.allocation_bytes -= allocation.size;
+  allocation = {};
+
+  if (!block.allocator.IsEmpty()) {
+    return;
+  }
+  // Keep one empty shared block around per memory type to avoid churn when resources are recreated
+  const auto& memory_type_blocks = blocks_[block.memory_type_index];
+  const bool has_other_empty_block =
+      std::any_of(memory_type_blocks.begin(), memory_type_blocks.end(), [&block](const auto& other) {
+        return other.get() != &block && !other->dedicated && other->allocator.IsEmpty();
+      });
+  if (block.dedicated || has_other_empty_block) {
+    DestroyBlock(block);
+  }
+}
+
+void MemoryAllocator::Flush(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const {
+  assert(allocation.block);
+  const VkMemoryPropertyFlags property_flags =
+      memory_properties_.memoryTypes[allocation.memory_type_index].propertyFlags;
+  if (property_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+    return;
+  }
+
+  // Flushed ranges must be aligned to nonCoherentAtomSize (or reach the end of the memory object)
+  const VkDeviceSize block_size = allocation.block->allocator.GetSize();
+  const VkDeviceSize begin = (allocation.offset + offset) / non_coherent_atom_size_ * non_coherent_atom_size_;
+  const VkDeviceSize end =
+      size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : allocation.offset + offset + size;
+  const VkDeviceSize aligned_end =
+      std::min((end + non_coherent_atom_size_ - 1) / non_coherent_atom_size_ * non_coherent_atom_size_, block_size);
+
+  VkMappedMemoryRange mapped_memory_range{};
+  mapped_memory_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  mapped_memory_range.memory = allocation.memory;
+  mapped_memory_range.offset = begin;
+  mapped_memory_range.size = aligned_end == block_size ? VK_WHOLE_SIZE : aligned_end - begin;
+  vkFlushMappedMemoryRanges(device_, 1, &mapped_memory_range);
+}
+
+MemoryStats MemoryAllocator::QueryStats() const {
+  MemoryStats stats{};
+  for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i) {
+    auto& memory_type_stats = stats.memory_types[i];
+    for (const auto& block : blocks_[i]) {
+      memory_type_stats.block_count += 1;
+      memory_type_stats.block_bytes += block->allocator.GetSize();
+      memory_type_stats.allocation_count += block->allocator.GetAllocationCount();
+      memory_type_stats.allocation_bytes += block->allocator.GetUsed();
+    }
+    stats.total.block_count += memory_type_stats.block_count;
+    stats.total.block_bytes += memory_type_stats.block_bytes;
+    stats.total.allocation_count += memory_type_stats.allocation_count;
+    stats.total.allocation_bytes += memory_type_stats.allocation_bytes;
+
+    stats.heaps[memory_properties_.memoryTypes[i].heapIndex].block_bytes += memory_type_stats.block_bytes;
+  }
+  stats.categories = category_stats_;
+
+  stats.heap_count = memory_properties_.memoryHeapCount;
+  for (uint32_t i = 0; i < memory_properties_.memoryHeapCount; ++i) {
+    stats.heaps[i].size = memory_properties_.memoryHeaps[i].size;
+  }
+  return stats;
+}
+
+VkDeviceSize MemoryAllocator::PreferredBlockSize(uint32_t memory_type_index) const {
+  // Small heaps (e.g. the 256 MiB BAR window) would be exhausted by a handful of default-sized blocks
+  const uint32_t heap_index = memory_properties_.memoryTypes[memory_type_index].heapIndex;
+  const VkDeviceSize heap_size = memory_properties_.memoryHeaps[heap_index].size;
+  return std::min(kDefaultBlockSize, std::max<VkDeviceSize>(heap_size / 8, 1));
+}
+
+MemoryBlock& MemoryAllocator::CreateBlock(uint32_t memory_type_index, VkDeviceSize size, bool dedicated) {
+  if (max_memory_allocation_count_ > 0 && memory_allocation_count_ >= max_memory_allocation_count_) {
+    throw std::runtime_error{"Exceeded maxMemoryAllocationCount!"};
+  }
+
+  VkMemoryAllocateInfo memory_allocate_info{};
+  memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  memory_allocate_info.allocationSize = size;
+  memory_allocate_info.memoryTypeIndex = memory_type_index;
+
+  auto block = std::make_unique<MemoryBlock>(size, buffer_image_granularity_);
+  block->memory_type_index = memory_type_index;
+  block->dedicated = dedicated;
+  if (vkAllocateMemory(device_, &memory_allocate_info, nullptr, &block->memory) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to allocate device memory!"};
+  }
+  ++memory_allocation_count_;
+
+  if (memory_properties_.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    if (vkMapMemory(device_, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+      vkFreeMemory(device_, block->memory, nullptr);
+      --memory_allocation_count_;
+      throw std::runtime_error{"Failed to map device memory!"};
+    }
+  }
+
+  return *blocks_[memory_type_index].emplace_back(std::move(block));
+}
+
+void MemoryAllocator::DestroyBlock(MemoryBlock& block) {
+  auto& memory_type_blocks = blocks_[block.memory_type_index];
+  auto it = std::find_if(memory_type_blocks.begin(), memory_type_blocks.end(),
+                         [&block](const auto& other) { return other.get() == &block; });
+  assert(it != memory_type_blocks.end());
+
+  if (block.mapped) {
+    vkUnmapMemory(device_, block.memory);
+  }
+  vkFreeMemory(device_, block.memory, nullptr);
+  --memory_allocation_count_;
+  memory_type_blocks.erase(it);
+}
+
+}  // namespace engine
@@ -0,0 +1,75 @@
+#include "engine/memory_stats.h"
+
+#include <iomanip>
+
+namespace {
+double ToMiB(VkDeviceSize bytes) {
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+}  // namespace
+
+namespace engine {
+const char* ToString(MemoryCategory category) {
+  switch (category) {
+    case MemoryCategory::kGeometry:
+      return "geometry";
+    case MemoryCategory::kTexture:
+      return "texture";
+    case MemoryCategory::kDepthAttachment:
+      return "depth_attachment";
+    case MemoryCategory::kUniform:
+      return "uniform";
+    case MemoryCategory::kStaging:
+      return "staging";
+    case MemoryCategory::kOther:
+      return "other";
+  }
+  return "unknown";
+}
+
+void LogMemoryStats(std::ostream& os, const MemoryStats& stats) {
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << std::fixed << std::setprecision(1);
+
+  os << "Memory: " << ToMiB(stats.total.allocation_bytes) << " MiB in " << stats.total.allocation_count
+     << " allocations, " << ToMiB(stats.total.block_bytes) << " MiB in " << stats.total.block_count << " blocks"
+     << std::endl;
+  for (uint32_t i = 0; i < stats.heap_count; ++i) {
+    const MemoryHeapBudget& heap = stats.heaps[i];
+    os << "\tHeap " << i << ": " << ToMiB(heap.usage) << " / " << ToMiB(heap.budget) << " MiB"
+       << (stats.has_budget ? "" : " (estimated)") << ", engine " << ToMiB(heap.block_bytes) << " MiB, size "
+       << ToMiB(heap.size) << " MiB" << std::endl;
+  }
+  for (uint32_t i = 0; i < kMemoryCategoryCount; ++i) {
+    const MemoryCategoryStatistics& category = stats.categories[i];
+    os << "\t" << ToString(static_cast<MemoryCategory>(i)) << ": " << ToMiB(category.allocation_bytes) << " MiB in "
+       << category.allocation_count << " allocations" << std::endl;
+  }
+
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void WriteMemoryStatsJson(std::ostream& os, const MemoryStats& stats) {
+  os << "{\"total\":{\"block_count\":" << stats.total.block_count << ",\"block_bytes\":" << stats.total.block_bytes
+     << ",\"allocation_count\":" << stats.total.allocation_count
+     << ",\"allocation_bytes\":" << stats.total.allocation_bytes << "}";
+
+  os << ",\"has_budget\":" << (stats.has_budget ? "true" : "false") << ",\"heaps\":[";
+  for (uint32_t i = 0; i < stats.heap_count; ++i) {
+    const MemoryHeapBudget& heap = stats.heaps[i];
+    os << (i > 0 ? "," : "") << "{\"size\":" << heap.size << ",\"block_bytes\":" << heap.block_bytes
+       << ",\"budget\":" << heap.budget << ",\"usage\":" << heap.usage << "}";
+  }
+
+  os << "],\"categories\":{";
+  for (uint32_t i = 0; i < kMemoryCategoryCount; ++i) {
+    const MemoryCategoryStatistics& category = stats.categories[i];
+    os << (i > 0 ? "," : "") << "\"" << ToString(static_cast<MemoryCategory>(i))
+       << "\":{\"allocation_count\":" << category.allocation_count
+       << ",\"allocation_bytes\":" << category.allocation_bytes << "}";
+  }
+  os << "}}" << std::endl;
+}
+}  // namespace engine
@@ -1,7 +1,16 @@
 #include "engine/mesh.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include "engine/mesh_optimizer.h"
+#include "engine/sphere_math.h"
+#include "engine/thread_pool.h"
 
 namespace {
 struct CubeFace {
@@ -12,176 +21,598 @@ struct CubeFace {
   glm::vec3 normal{};
 };
 
-glm::vec3 CubeToSphere(glm::vec3 cube_point) {
-  const glm::vec3 p2 = cube_point * cube_point;
-  const float x = cube_point.x * sqrt(1 - (p2.y + p2.z) / 2 + (p2.y * p2.z) / 3);
-  const float y = cube_point.y * sqrt(1 - (p2.x + p2.z) / 2 + (p2.x * p2.z) / 3);
-  const float z = cube_point.z * sqrt(1 - (p2.x + p2.y) / 2 + (p2.x * p2.y) / 3);
-  return {x, y, z};
-}
+// Minimum corner XYZ -1 and maximum corner XYZ +1, ordered by index
+constexpr std::array<CubeFace, 6> kCubeFaces = {
+    // Back
+    CubeFace{
+        .index = 0,
+        .origin = glm::vec3{-1.0f, -1.0f, -1.0f},
+        .u = 2.0f * glm::vec3{1.0f, 0.0f, 0.0f},
+        .v = 2.0f * glm::vec3{0.0f, 1.0f, 0.0f},
+        .normal = glm::vec3{0.0f, 0.0f, -1.0f},
+    },
+    // Right
+    CubeFace{
+        .index = 1,
+        .origin = glm::vec3{1.0f, -1.0f, -1.0f},
+        .u = 2.0f * glm::vec3{0.0f, 0.0f, 1.0f},
+        .v = 2.0f * glm::vec3{0.0f, 1.0f, 0.0f},
+        .normal = glm::vec3{1.0f, 0.0f, 0.0f},
+    },
+    // Bottom
+    CubeFace{
+        .index = 2,
+        .origin = glm::vec3{-1.0f, -1.0f, -1.0f},
+        .u = 2.0f * glm::vec3{0.0f, 0.0f, 1.0f},
+        .v = 2.0f * glm::vec3{1.0f, 0.0f, 0.0f},
+        .normal = glm::vec3{0.0f, -1.0f, 0.0f},
+    },
+    // Front
+    CubeFace{
+        .index = 3,
+        .origin = glm::vec3{-1.0f, -1.0f, 1.0f},
+        .u = 2.0f * glm::vec3{0.0f, 1.0f, 0.0f},
+        .v = 2.0f * glm::vec3{1.0f, 0.0f, 0.0f},
+        .normal = glm::vec3{0.0f, 0.0f, 1.0f},
+    },
+    // Left
+    CubeFace{
+        .index = 4,
+        .origin = glm::vec3{-1.0f, -1.0f, -1.0f},
+        .u = 2.0f * glm::vec3{0.0f, 1.0f, 0.0f},
+        .v = 2.0f * glm::vec3{0.0f, 0.0f, 1.0f},
+        .normal = glm::vec3{-1.0f, 0.0f, 0.0f},
+    },
+    // Top
+    CubeFace{
+        .index = 5,
+        .origin = glm::vec3{-1.0f, 1.0f, -1.0f},
+        .u = 2.0f * glm::vec3{1.0f, 0.0f, 0.0f},
+        .v = 2.0f * glm::vec3{0.0f, 0.0f, 1.0f},
+        .normal = glm::vec3{0.0f, 1.0f, 0.0f},
+    },
+};
+
+// Maps face-local grid points (u, v) to vertex indices. Separate faces each own a resolution^2 grid of vertices. Welded
+// faces share their edge and corner vertices: the face interiors are numbered first, rows contiguous, followed by the
+// boundary vertices. Either way, a row of a face's own vertices is contiguous.
+class CubeSphereLayout {
+ public:
+  CubeSphereLayout(const std::array<CubeFace, 6>& cube_faces, uint32_t resolution, bool welded)
+      : resolution_{resolution}, welded_{welded} {
+    if (!welded_) {
+      vertex_count_ = 6 * resolution_ * resolution_;
+      return;
+    }
+    interior_row_length_ = resolution_ - 2;
+    vertex_count_ = 6 * interior_row_length_ * interior_row_length_;
+
+    // Number the boundary vertices by their cube lattice point, shared by up to three faces
+    std::unordered_map<uint64_t, uint32_t> lattice_indices;
+    for (const CubeFace& cube_face : cube_faces) {
+      auto& edges = edge_indices_[cube_face.index];
+      for (auto& edge : edges) {
+        edge.resize(resolution_);
+      }
+      for (uint32_t t = 0; t < resolution_; ++t) {
+        const std::array<glm::uvec2, 4> edge_points = {
+            glm::uvec2{t, 0}, glm::uvec2{t, resolution_ - 1}, glm::uvec2{0, t}, glm::uvec2{resolution_ - 1, t}};
+        for (uint32_t edge = 0; edge < 4; ++edge) {
+          const glm::uvec3 lattice_point = ToLatticePoint(cube_face, edge_points[edge].x, edge_points[edge].y);
+          const uint64_t key =
+              lattice_point.x + resolution_ * (lattice_point.y + uint64_t{resolution_} * lattice_point.z);
+          auto [it, inserted] = lattice_indices.try_emplace(key, vertex_count_);
+          if (inserted) {
+            boundary_points_.push_back(lattice_point);
+            ++vertex_count_;
+          }
+          edges[edge][t] = it->second;
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] uint32_t GetVertexCount() const { return vertex_count_; }
+  [[nodiscard]] uint32_t GetBoundaryVertexOffset() const { return vertex_count_ - GetBoundaryVertexCount(); }
+  [[nodiscard]] uint32_t GetBoundaryVertexCount() const { return static_cast<uint32_t>(boundary_points_.size()); }
+  [[nodiscard]] const std::vector<glm::uvec3>& GetBoundaryPoints() const { return boundary_points_; }
+
+  // Range [first_v, last_v) of the row's vertices owned by the face, the rest are boundary vertices
+  void GetOwnedRow(uint32_t u, uint32_t& first_v, uint32_t& last_v) const {
+    const bool boundary_row = welded_ && (u == 0 || u == resolution_ - 1);
+    first_v = welded_ ? 1 : 0;
+    last_v = boundary_row ? first_v : resolution_ - first_v;
+  }
+
+  [[nodiscard]] uint32_t GetVertexIndex(uint32_t face, uint32_t u, uint32_t v) const {
+    if (!welded_) {
+      return (face * resolution_ + u) * resolution_ + v;
+    }
+    const auto& edges = edge_indices_[face];
+    if (v == 0 || v == resolution_ - 1) {
+      return edges[v == 0 ? 0 : 1][u];
+    }
+    if (u == 0 || u == resolution_ - 1) {
+      return edges[u == 0 ? 2 : 3][v];
+    }
+    return (face * interior_row_length_ + u - 1) * interior_row_length_ + v - 1;
+  }
+
+  // Integer coordinates of a grid point on the cube, [0, resolution - 1] along each axis
+  [[nodiscard]] glm::uvec3 ToLatticePoint(const CubeFace& cube_face, uint32_t u, uint32_t v) const {
+    const glm::uvec3 origin = glm::uvec3{(cube_face.origin + 1.0f) * 0.5f} * (resolution_ - 1);
+    return origin + glm::uvec3{cube_face.u * 0.5f} * u + glm::uvec3{cube_face.v * 0.5f} * v;
+  }
+  // Shared lattice points map to bitwise identical cube points, whichever face they are computed for
+  [[nodiscard]] glm::vec3 ToCubePoint(glm::uvec3 lattice_point) const {
+    return glm::vec3{lattice_point} * 2.0f / static_cast<float>(resolution_ - 1) - 1.0f;
+  }
 
-glm::vec2 SphereToUV(glm::vec3 sphere_point) {
-  const float u = 0.5f + atan2(sphere_point.z, sphere_point.x) / (2 * glm::pi<float>());
-  const float v = 0.5f - asin(sphere_point.y) / glm::pi<float>();
-  return {-u, v};
+ private:
+  uint32_t resolution_;
+  bool welded_;
+  uint32_t interior_row_length_ = 0;
+  uint32_t vertex_count_ = 0;
+  std::array<std::array<std::vector<uint32_t>, 4>, 6> edge_indices_;  // Edges v = 0, v = max, u = 0, u = max
+  std::vector<glm::uvec3> boundary_points_;
+};
+
+// Maps cube points onto the sphere as vertices, the points are overwritten
+void WriteSphereVertices(std::vector<float>& x, std::vector<float>& y, std::vector<float>& z, uint32_t count,
+                         engine::Vertex* vertices) {
+  std::vector<float> texture_u(count), texture_v(count);
+  engine::sphere_math::CubeToSphere(x.data(), y.data(), z.data(), x.data(), y.data(), z.data(), count);
+  engine::sphere_math::SphereToUV(x.data(), y.data(), z.data(), texture_u.data(), texture_v.data(), count);
+  for (uint32_t i = 0; i < count; ++i) {
+    engine::Vertex& vertex = vertices[i];
+    vertex.position = {x[i], y[i], z[i]};
+    vertex.normal = glm::normalize(vertex.position);
+    vertex.color = {1.0f, 1.0f, 1.0f};
+    vertex.uv = {texture_u[i], texture_v[i]};
+  }
 }
 
-void GenerateCubeFace(const CubeFace& cube_face, uint32_t cube_face_resolution, std::vector<engine::Vertex>& vertices,
-                      std::vector<uint32_t>& indices) {
-  const uint32_t face_vertices_offset = cube_face.index * cube_face_resolution * cube_face_resolution;
+// Generates the face's own vertices of rows [first_u, last_u), and the indices of the quads starting on those rows.
+// Ranges of different faces and rows don't overlap, so they can be generated concurrently.
+void GenerateCubeFaceRows(const CubeFace& cube_face, const CubeSphereLayout& layout, uint32_t cube_face_resolution,
+                          uint32_t first_u, uint32_t last_u, std::vector<engine::Vertex>& vertices,
+                          std::vector<uint32_t>& indices) {
   const uint32_t face_indices_offset = cube_face.index * (cube_face_resolution - 1) * (cube_face_resolution - 1) * 6;
-  uint32_t indices_index = 0;
-
-  for (uint32_t u = 0; u < cube_face_resolution; ++u) {
-    for (uint32_t v = 0; v < cube_face_resolution; ++v) {
-      const uint32_t vertex_index = face_vertices_offset + (u + v * cube_face_resolution);
-      const glm::vec3 offset = cube_face.u * (static_cast<float>(u) / static_cast<float>(cube_face_resolution - 1)) +
-                               cube_face.v * (static_cast<float>(v) / static_cast<float>(cube_face_resolution - 1));
-      engine::Vertex vertex{};
-      vertex.position = CubeToSphere(cube_face.origin + offset);
-      vertex.normal = glm::normalize(vertex.position);
-      vertex.color = {1.0f, 1.0f, 1.0f};
-      vertex.uv = SphereToUV(vertex.position);
-      vertices[vertex_index] = vertex;
-
-      if (u < cube_face_resolution - 1 && v < cube_face_resolution - 1) {
-        indices[face_indices_offset + indices_index++] = vertex_index;
-        indices[face_indices_offset + indices_index++] = vertex_index + cube_face_resolution;
-        indices[face_indices_offset + indices_index++] = vertex_index + cube_face_resolution + 1;
-        indices[face_indices_offset + indices_index++] = vertex_index;
-        indices[face_indices_offset + indices_index++] = vertex_index + cube_face_resolution + 1;
-        indices[face_indices_offset + indices_index++] = vertex_index + 1;
+
+  // Rows are mapped onto the sphere in batches, as structure-of-arrays
+  std::vector<float> x(cube_face_resolution), y(cube_face_resolution), z(cube_face_resolution);
+
+  for (uint32_t u = first_u; u < last_u; ++u) {
+    uint32_t first_v, last_v;
+    layout.GetOwnedRow(u, first_v, last_v);
+    for (uint32_t v = first_v; v < last_v; ++v) {
+      const glm::vec3 cube_point = layout.ToCubePoint(layout.ToLatticePoint(cube_face, u, v));
+      x[v - first_v] = cube_point.x;
+      y[v - first_v] = cube_point.y;
+      z[v - first_v] = cube_point.z;
+    }
+    if (first_v < last_v) {
+      WriteSphereVertices(x, y, z, last_v - first_v, &vertices[layout.GetVertexIndex(cube_face.index, u, first_v)]);
+    }
+
+    if (u == cube_face_resolution - 1) {
+      continue;
+    }
+    uint32_t indices_index = face_indices_offset + u * (cube_face_resolution - 1) * 6;
+    for (uint32_t v = 0; v < cube_face_resolution - 1; ++v) {
+      const uint32_t i00 = layout.GetVertexIndex(cube_face.index, u, v);
+      const uint32_t i01 = layout.GetVertexIndex(cube_face.index, u, v + 1);
+      const uint32_t i10 = layout.GetVertexIndex(cube_face.index, u + 1, v);
+      const uint32_t i11 = layout.GetVertexIndex(cube_face.index, u + 1, v + 1);
+      indices[indices_index++] = i00;
+      indices[indices_index++] = i01;
+      indices[indices_index++] = i11;
+      indices[indices_index++] = i00;
+      indices[indices_index++] = i11;
+      indices[indices_index++] = i10;
+    }
+  }
+}
+
+// Triangles crossing the wrap-around of the equirectangular U coordinate would interpolate across the whole texture.
+// Their vertices on the U ~ 0 side are duplicated with U shifted by -1, the rest of the vertices stay shared.
+void SplitUVSeam(std::vector<engine::Vertex>& vertices, std::vector<uint32_t>& indices) {
+  std::unordered_map<uint32_t, uint32_t> duplicates;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const float u0 = vertices[indices[i + 0]].uv.x;
+    const float u1 = vertices[indices[i + 1]].uv.x;
+    const float u2 = vertices[indices[i + 2]].uv.x;
+    if (std::max({u0, u1, u2}) - std::min({u0, u1, u2}) <= 0.5f) {
+      continue;
+    }
+    for (size_t j = i; j < i + 3; ++j) {
+      if (vertices[indices[j]].uv.x <= -0.5f) {
+        continue;
       }
+      auto [it, inserted] = duplicates.try_emplace(indices[j], static_cast<uint32_t>(vertices.size()));
+      if (inserted) {
+        engine::Vertex duplicate = vertices[indices[j]];
+        duplicate.uv.x -= 1.0f;
+        vertices.push_back(duplicate);
+      }
+      indices[j] = it->second;
     }
   }
 }
 
+constexpr uint32_t kMaxIndex16VertexCount = 65536;
+
+struct Index16Geometry {
+  std::vector<engine::Vertex> vertices;
+  std::vector<uint16_t> indices;
+  std::vector<engine::DrawRange> draw_ranges;  // Relative to the mesh's range
+};
+
+// Splits the triangles, in order, into chunks of at most kMaxIndex16VertexCount vertices, each drawn with its own base
+// vertex. A chunk's vertices are stored in first-use order, vertices used by several chunks are duplicated. Meshlets,
+// if any, cover the leading triangles and are kept whole so that each is drawn from a single chunk.
+Index16Geometry SplitIndex16Chunks(const std::vector<engine::Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                   const std::vector<engine::Meshlet>& meshlets) {
+  Index16Geometry geometry;
+  geometry.vertices.reserve(vertices.size());
+  geometry.indices.reserve(indices.size());
+
+  // Each meshlet is a group, every triangle after them is a group of its own
+  const auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+  const auto meshlet_count = static_cast<uint32_t>(meshlets.size());
+  const uint32_t meshlet_triangle_count =
+      meshlets.empty() ? 0 : meshlets.back().first_triangle + meshlets.back().triangle_count;
+  const uint32_t group_count = meshlet_count + triangle_count - meshlet_triangle_count;
+
+  std::vector<uint32_t> vertex_chunks(vertices.size(), ~0u);
+  std::vector<uint32_t> vertex_groups(vertices.size(), ~0u);
+  std::vector<uint16_t> local_indices(vertices.size());
+  uint32_t chunk = 0;
+  uint32_t chunk_vertex_count = 0;
+  engine::DrawRange draw_range{};
+  for (uint32_t group = 0; group < group_count; ++group) {
+    const bool meshlet = group < meshlet_count;
+    const uint32_t first_triangle =
+        meshlet ? meshlets[group].first_triangle : meshlet_triangle_count + group - meshlet_count;
+    const uint32_t group_triangle_count = meshlet ? meshlets[group].triangle_count : 1;
+    const size_t first_index = 3 * static_cast<size_t>(first_triangle);
+    const size_t last_index = first_index + 3 * static_cast<size_t>(group_triangle_count);
+    uint32_t new_vertex_count = 0;
+    for (size_t i = first_index; i < last_index; ++i) {
+      new_vertex_count += vertex_chunks[indices[i]] != chunk && vertex_groups[indices[i]] != group;
+      vertex_groups[indices[i]] = group;
+    }
+    if (chunk_vertex_count + new_vertex_count > kMaxIndex16VertexCount) {
+      geometry.draw_ranges.push_back(draw_range);
+      draw_range = {
+          .vertex_offset = static_cast<int32_t>(geometry.vertices.size()),
+          .first_index = static_cast<uint32_t>(first_index),
+      };
+      ++chunk;
+      chunk_vertex_count = 0;
+    }
+    for (size_t i = first_index; i < last_index; ++i) {
+      const uint32_t vertex = indices[i];
+      if (vertex_chunks[vertex] != chunk) {
+        vertex_chunks[vertex] = chunk;
+        local_indices[vertex] = static_cast<uint16_t>(chunk_vertex_count++);
+        geometry.vertices.push_back(vertices[vertex]);
+      }
+      geometry.indices.push_back(local_indices[vertex]);
+    }
+    draw_range.index_count += static_cast<uint32_t>(last_index - first_index);
+  }
+  geometry.draw_ranges.push_back(draw_range);
+  return geometry;
+}
 }  // namespace
 
 namespace engine {
-Mesh::Mesh(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
-  CreateVertexBuffer(device, vertices);
-  CreateIndexBuffer(device, indices);
+Mesh::Mesh(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+           const MeshOptions& options)
+    : device_{&device}, geometry_arena_{&device.GetGeometryArena()}, options_{options} {
+  UploadBatch upload_batch{device};
+  CreateGeometry(upload_batch, vertices, indices);
+  upload_batch.Submit();
 }
 
-Mesh::~Mesh() = default;
+Mesh::Mesh(Device& device, UploadBatch& upload_batch, const std::vector<Vertex>& vertices,
+           const std::vector<uint32_t>& indices, const MeshOptions& options)
+    : device_{&device}, geometry_arena_{&device.GetGeometryArena()}, options_{options} {
+  CreateGeometry(upload_batch, vertices, indices);
+}
 
-std::unique_ptr<Mesh> Mesh::CreateSphereMesh(Device& device, uint32_t cube_face_resolution) {
-  // Minimum corner XYZ -1 and maximum corner XYZ +1
-  constexpr CubeFace back{
-      .index = 0,
-      .origin = glm::vec3{-1.0f, -1.0f, -1.0f},
-      .u = 2.0f * glm::vec3{1.0f, 0.0f, 0.0f},
-      .v = 2.0f * glm::vec3{0.0f, 1.0f, 0.0f},
-      .normal = glm::vec3{0.0f, 0.0f, -1.0f},
-  };
-  constexpr CubeFace right{
-      .index = 1,
-      .origin = glm::vec3{1.0f, -1.0f, -1.0f},
-      .u = 2.0f * glm::vec3{0.0f, 0.0f, 1.0f},
-      .v = 2.0f * glm::vec3{0.0f, 1.0f, 0.0f},
-      .normal = glm::vec3{1.0f, 0.0f, 0.0f},
-  };
-  constexpr CubeFace bottom{
-      .index = 2,
-      .origin = glm::vec3{-1.0f, -1.0f, -1.0f},
-      .u = 2.0f * glm::vec3{0.0f, 0.0f, 1.0f},
-      .v = 2.0f * glm::vec3{1.0f, 0.0f, 0.0f},
-      .normal = glm::vec3{0.0f, -1.0f, 0.0f},
-  };
-  constexpr CubeFace front{
-      .index = 3,
-      .origin = glm::vec3{-1.0f, -1.0f, 1.0f},
-      .u = 2.0f * glm::vec3{0.0f, 1.0f, 0.0f},
-      .v = 2.0f * glm::vec3{1.0f, 0.0f, 0.0f},
-      .normal = glm::vec3{0.0f, 0.0f, 1.0f},
-  };
-  constexpr CubeFace left{
-      .index = 4,
-      .origin = glm::vec3{-1.0f, -1.0f, -1.0f},
-      .u = 2.0f * glm::vec3{0.0f, 1.0f, 0.0f},
-      .v = 2.0f * glm::vec3{0.0f, 0.0f, 1.0f},
-      .normal = glm::vec3{-1.0f, 0.0f, 0.0f},
-  };
-  constexpr CubeFace top{
-      .index = 5,
-      .origin = glm::vec3{-1.0f, 1.0f, -1.0f},
-      .u = 2.0f * glm::vec3{1.0f, 0.0f, 0.0f},
-      .v = 2.0f * glm::vec3{0.0f, 0.0f, 1.0f},
-      .normal = glm::vec3{0.0f, 1.0f, 0.0f},
-  };
+Mesh::~Mesh() {
+  if (geometry_.vertex_count == 0) {
+    return;
+  }
+  // In-flight frames may still draw the range
+  device_->GetDeletionQueue().Enqueue(
+      [geometry_arena = geometry_arena_, geometry = geometry_]() mutable { geometry_arena->Free(geometry); });
+}
 
-  const uint32_t cube_face_vertex_count = cube_face_resolution * cube_face_resolution;
-  const uint32_t cube_face_index_count = (cube_face_resolution - 1) * (cube_face_resolution - 1) * 6;
-  std::vector<Vertex> vertices(cube_face_vertex_count * 6);
-  std::vector<uint32_t> indices(cube_face_index_count * 6);
+Mesh::Mesh(Mesh&& other) noexcept
+    : device_{other.device_},
+      geometry_arena_{other.geometry_arena_},
+      geometry_{std::exchange(other.geometry_, {})},
+      bounds_{other.bounds_},
+      lods_{std::move(other.lods_)},
+      meshlets_{std::move(other.meshlets_)},
+      meshlet_draw_ranges_{std::move(other.meshlet_draw_ranges_)},
+      bvh_{std::move(other.bvh_)},
+      options_{other.options_},
+      dequantization_{other.dequantization_} {}
 
-  GenerateCubeFace(back, cube_face_resolution, vertices, indices);
-  GenerateCubeFace(right, cube_face_resolution, vertices, indices);
-  GenerateCubeFace(bottom, cube_face_resolution, vertices, indices);
-  GenerateCubeFace(front, cube_face_resolution, vertices, indices);
-  GenerateCubeFace(left, cube_face_resolution, vertices, indices);
-  GenerateCubeFace(top, cube_face_resolution, vertices, indices);
+Mesh& Mesh::operator=(Mesh&& other) noexcept {
+  // The previous geometry is released by the moved-from mesh
+  std::swap(device_, other.device_);
+  std::swap(geometry_arena_, other.geometry_arena_);
+  std::swap(geometry_, other.geometry_);
+  std::swap(bounds_, other.bounds_);
+  std::swap(lods_, other.lods_);
+  std::swap(meshlets_, other.meshlets_);
+  std::swap(meshlet_draw_ranges_, other.meshlet_draw_ranges_);
+  std::swap(bvh_, other.bvh_);
+  std::swap(options_, other.options_);
+  std::swap(dequantization_, other.dequantization_);
+  return *this;
+}
 
-  return std::make_unique<Mesh>(device, vertices, indices);
+MeshHandle Mesh::CreateSphereMesh(MeshManager& manager, uint32_t cube_face_resolution, bool welded,
+                                  const MeshOptions& options) {
+  UploadBatch upload_batch{manager.GetDevice()};
+  MeshHandle mesh = CreateSphereMesh(manager, upload_batch, cube_face_resolution, welded, options);
+  upload_batch.Submit();
+  return mesh;
 }
 
-void Mesh::Bind(VkCommandBuffer command_buffer) const {
-  std::array<VkBuffer, 1> vertex_buffers = {vertex_buffer_->GetHandle()};
-  std::array<VkDeviceSize, 1> offsets = {0};
-  vkCmdBindVertexBuffers(command_buffer, 0, static_cast<uint32_t>(vertex_buffers.size()), vertex_buffers.data(),
-                         offsets.data());
+MeshHandle Mesh::CreateSphereMesh(MeshManager& manager, UploadBatch& upload_batch, uint32_t cube_face_resolution,
+                                  bool welded, const MeshOptions& options) {
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  GenerateSphere(cube_face_resolution, welded, vertices, indices);
 
-  if (index_buffer_) {
-    vkCmdBindIndexBuffer(command_buffer, index_buffer_->GetHandle(), 0, VK_INDEX_TYPE_UINT32);
-  }
+  // The rows are generated in order, so the faces can be optimized separately
+  const uint32_t cube_face_index_count = (cube_face_resolution - 1) * (cube_face_resolution - 1) * 6;
+  [[maybe_unused]] const MeshOptimizationStatistics statistics =
+      OptimizeMesh(vertices, indices, cube_face_index_count / 3);
+#ifdef ENABLE_VALIDATION_LAYERS
+  std::cout << "Sphere mesh: ";
+  LogMeshOptimizationStatistics(std::cout, statistics);
+#endif
+
+  return manager.Add(Mesh{manager.GetDevice(), upload_batch, vertices, indices, options});
 }
 
-void Mesh::Draw(VkCommandBuffer command_buffer) const {
-  if (index_buffer_) {
-    vkCmdDrawIndexed(command_buffer, index_count_, 1, 0, 0, 0);
-  } else {
-    vkCmdDraw(command_buffer, vertex_count_, 1, 0, 0);
+void Mesh::GenerateSphere(uint32_t cube_face_resolution, bool welded, std::vector<Vertex>& vertices,
+                          std::vector<uint32_t>& indices, ThreadPool& thread_pool) {
+  assert(cube_face_resolution >= 2);
+  const CubeSphereLayout layout{kCubeFaces, cube_face_resolution, welded};
+  const uint32_t cube_face_index_count = (cube_face_resolution - 1) * (cube_face_resolution - 1) * 6;
+  vertices.assign(layout.GetVertexCount(), Vertex{});
+  indices.assign(cube_face_index_count * 6, 0);
+
+  // Each face is split into bands of rows, generated in parallel into disjoint ranges of the pre-sized vectors
+  constexpr uint32_t kRowsPerBand = 32;
+  const uint32_t bands_per_face = (cube_face_resolution + kRowsPerBand - 1) / kRowsPerBand;
+  thread_pool.ParallelFor(6 * bands_per_face, [&](uint32_t task_index) {
+    const CubeFace& cube_face = kCubeFaces[task_index / bands_per_face];
+    const uint32_t first_u = task_index % bands_per_face * kRowsPerBand;
+    const uint32_t last_u = std::min(first_u + kRowsPerBand, cube_face_resolution);
+    GenerateCubeFaceRows(cube_face, layout, cube_face_resolution, first_u, last_u, vertices, indices);
+  });
+
+  if (welded) {
+    const uint32_t boundary_vertex_count = layout.GetBoundaryVertexCount();
+    std::vector<float> x(boundary_vertex_count), y(boundary_vertex_count), z(boundary_vertex_count);
+    for (uint32_t i = 0; i < boundary_vertex_count; ++i) {
+      const glm::vec3 cube_point = layout.ToCubePoint(layout.GetBoundaryPoints()[i]);
+      x[i] = cube_point.x;
+      y[i] = cube_point.y;
+      z[i] = cube_point.z;
+    }
+    WriteSphereVertices(x, y, z, boundary_vertex_count, &vertices[layout.GetBoundaryVertexOffset()]);
+    SplitUVSeam(vertices, indices);
   }
 }
 
-void Mesh::CreateVertexBuffer(Device& device, const std::vector<Vertex>& vertices) {
-  assert(!vertices.empty());
-  vertex_count_ = static_cast<uint32_t>(vertices.size());
+void Mesh::GenerateSpherePatch(const CubeSpherePatch& patch, uint32_t resolution, float skirt_depth,
+                               std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+  assert(patch.face < 6 && resolution >= 2);
+  const CubeFace& cube_face = kCubeFaces[patch.face];
+  const float patch_size = 1.0f / static_cast<float>(1u << patch.level);
+  const uint32_t grid_vertex_count = resolution * resolution;
 
-  const VkDeviceSize buffer_size = sizeof(Vertex) * vertex_count_;
+  std::vector<float> x(grid_vertex_count), y(grid_vertex_count), z(grid_vertex_count);
+  for (uint32_t u = 0; u < resolution; ++u) {
+    for (uint32_t v = 0; v < resolution; ++v) {
+      const float s = static_cast<float>(patch.x) + static_cast<float>(u) / static_cast<float>(resolution - 1);
+      const float t = static_cast<float>(patch.y) + static_cast<float>(v) / static_cast<float>(resolution - 1);
+      const glm::vec3 cube_point = cube_face.origin + cube_face.u * (s * patch_size) + cube_face.v * (t * patch_size);
+      x[u * resolution + v] = cube_point.x;
+      y[u * resolution + v] = cube_point.y;
+      z[u * resolution + v] = cube_point.z;
+    }
+  }
+  vertices.resize(grid_vertex_count);
+  WriteSphereVertices(x, y, z, grid_vertex_count, vertices.data());
 
-  Buffer staging_buffer{device, buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+  // Same triangulation as the whole sphere's faces
+  indices.clear();
+  indices.reserve(6 * (resolution - 1) * (resolution - 1) + 4 * 6 * (resolution - 1));
+  for (uint32_t u = 0; u + 1 < resolution; ++u) {
+    for (uint32_t v = 0; v + 1 < resolution; ++v) {
+      const uint32_t i00 = u * resolution + v;
+      const uint32_t i01 = i00 + 1;
+      const uint32_t i10 = i00 + resolution;
+      const uint32_t i11 = i10 + 1;
+      indices.insert(indices.end(), {i00, i01, i11, i00, i11, i10});
+    }
+  }
 
-  staging_buffer.Map();
-  staging_buffer.Write(reinterpret_cast<const void*>(vertices.data()));
+  // Each edge, walked against the direction the grid's triangles use it in, continues the surface downwards
+  auto add_skirt = [&](uint32_t first, int32_t step) {
+    const auto skirt_offset = static_cast<uint32_t>(vertices.size());
+    for (uint32_t i = 0; i < resolution; ++i) {
+      Vertex skirt_vertex = vertices[first + static_cast<int32_t>(i) * step];
+      skirt_vertex.position *= 1.0f - skirt_depth;
+      vertices.push_back(skirt_vertex);
+    }
+    for (uint32_t i = 0; i + 1 < resolution; ++i) {
+      const uint32_t current = first + static_cast<int32_t>(i) * step;
+      const uint32_t next = current + step;
+      indices.insert(indices.end(), {current, next, skirt_offset + i + 1, current, skirt_offset + i + 1,
+                                     skirt_offset + i});
+    }
+  };
+  const auto row = static_cast<int32_t>(resolution);
+  add_skirt(0, row);                                                 // v = 0, increasing u
+  add_skirt((resolution - 1) * resolution + resolution - 1, -row);  // v = max, decreasing u
+  add_skirt(resolution - 1, -1);                                     // u = 0, decreasing v
+  add_skirt((resolution - 1) * resolution, 1);                       // u = max, increasing v
+
+  SplitUVSeam(vertices, indices);
+}
 
-  vertex_buffer_ = std::make_unique<Buffer>(device, buffer_size,
-                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+void Mesh::Bind(VkCommandBuffer command_buffer) const {
+  geometry_arena_->Bind(command_buffer, geometry_.page);
+}
 
-  staging_buffer.CopyTo(*vertex_buffer_, buffer_size);
+void Mesh::BindPositions(VkCommandBuffer command_buffer) const {
+  geometry_arena_->BindPositions(command_buffer, geometry_.page);
 }
 
-void Mesh::CreateIndexBuffer(Device& device, const std::vector<uint32_t>& indices) {
-  index_count_ = static_cast<uint32_t>(indices.size());
-  if (index_count_ == 0)
-    return;
+void Mesh::Draw(VkCommandBuffer command_buffer) const {
+  for (const DrawRange& draw_range : GetDrawRanges()) {
+    vkCmdDrawIndexed(command_buffer, draw_range.index_count, 1, draw_range.first_index, draw_range.vertex_offset, 0);
+  }
+}
+
+void Mesh::CreateGeometry(UploadBatch& upload_batch, const std::vector<Vertex>& vertices,
+                          const std::vector<uint32_t>& indices) {
+  assert(!vertices.empty());
+  bounds_ = ComputeBounds(vertices);
+
+  // Everything in the arena is drawn indexed, non-indexed meshes get a trivial index list
+  std::vector<uint32_t> sequential_indices;
+  if (indices.empty()) {
+    sequential_indices.resize(vertices.size());
+    std::iota(sequential_indices.begin(), sequential_indices.end(), 0);
+  }
+  const std::vector<uint32_t>& full_detail_indices = indices.empty() ? sequential_indices : indices;
 
-  const VkDeviceSize buffer_size = sizeof(uint32_t) * index_count_;
+  meshlets_.clear();
+  if (options_.meshlets) {
+    meshlets_ = BuildMeshlets(vertices, full_detail_indices);
+  }
+  bvh_.reset();
+  if (options_.bvh) {
+    bvh_ = std::make_unique<MeshBvh>(vertices, full_detail_indices);
+  }
 
-  Buffer staging_buffer{device, buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+  // Coarser levels of detail follow the full detail mesh in the index buffer, drawing from the same vertices
+  std::vector<uint32_t> lod_chain_indices;
+  std::vector<LodLevel> lod_levels{{.index_count = static_cast<uint32_t>(full_detail_indices.size())}};
+  if (options_.lod_count > 1) {
+    lod_chain_indices = full_detail_indices;
+    lod_levels = BuildLodChain(vertices, lod_chain_indices, options_.lod_count);
+  }
+  const std::vector<uint32_t>& mesh_indices = options_.lod_count > 1 ? lod_chain_indices : full_detail_indices;
+  const auto index_count = static_cast<uint32_t>(mesh_indices.size());
 
-  staging_buffer.Map();
-  staging_buffer.Write(reinterpret_cast<const void*>(indices.data()));
+  // 16-bit indices whenever every vertex fits them. Larger meshes are split into chunks that do, unless the vertices
+  // duplicated along chunk borders would take more memory than the narrower indices save.
+  GeometryFormat format{.vertex_format = options_.vertex_format, .vertex_streams = options_.vertex_streams};
+  const std::vector<Vertex>* mesh_vertices = &vertices;
+  Index16Geometry index16_geometry;
+  if (vertices.size() <= kMaxIndex16VertexCount) {
+    format.index_type = VK_INDEX_TYPE_UINT16;
+    index16_geometry.indices.assign(mesh_indices.begin(), mesh_indices.end());
+    index16_geometry.draw_ranges.push_back({.index_count = index_count});
+  } else {
+    index16_geometry = SplitIndex16Chunks(vertices, mesh_indices, meshlets_);
+    const size_t duplicated_vertex_count = index16_geometry.vertices.size() - vertices.size();
+    if (duplicated_vertex_count * GetVertexStride(options_.vertex_format) <= sizeof(uint16_t) * mesh_indices.size()) {
+      format.index_type = VK_INDEX_TYPE_UINT16;
+      mesh_vertices = &index16_geometry.vertices;
+    }
+  }
+  const auto vertex_count = static_cast<uint32_t>(mesh_vertices->size());
 
-  index_buffer_ =
-      std::make_unique<Buffer>(device, buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  geometry_ = geometry_arena_->Allocate(format, vertex_count, index_count);
+  std::vector<DrawRange> chunk_draw_ranges;
+  if (format.index_type == VK_INDEX_TYPE_UINT16) {
+    for (const DrawRange& draw_range : index16_geometry.draw_ranges) {
+      chunk_draw_ranges.push_back({
+          .vertex_offset = geometry_.vertex_offset + draw_range.vertex_offset,
+          .first_index = geometry_.first_index + draw_range.first_index,
+          .index_count = draw_range.index_count,
+      });
+    }
+  } else {
+    chunk_draw_ranges.push_back({
+        .vertex_offset = geometry_.vertex_offset,
+        .first_index = geometry_.first_index,
+        .index_count = index_count,
+    });
+  }
+  // Chunks may span several levels of detail, each level is drawn with the parts of the chunks it overlaps
+  lods_.clear();
+  for (const LodLevel& lod_level : lod_levels) {
+    MeshLod& lod = lods_.emplace_back(MeshLod{.error = lod_level.error});
+    const uint32_t first_index = geometry_.first_index + lod_level.first_index;
+    const uint32_t last_index = first_index + lod_level.index_count;
+    for (const DrawRange& chunk_draw_range : chunk_draw_ranges) {
+      const uint32_t begin = std::max(first_index, chunk_draw_range.first_index);
+      const uint32_t end = std::min(last_index, chunk_draw_range.first_index + chunk_draw_range.index_count);
+      if (begin < end) {
+        lod.draw_ranges.push_back(
+            {.vertex_offset = chunk_draw_range.vertex_offset, .first_index = begin, .index_count = end - begin});
+      }
+    }
+  }
+  // Each meshlet lies within one draw range and shares its base vertex
+  meshlet_draw_ranges_.clear();
+  auto draw_range = chunk_draw_ranges.begin();
+  for (const Meshlet& meshlet : meshlets_) {
+    const uint32_t first_index = geometry_.first_index + 3 * meshlet.first_triangle;
+    while (first_index >= draw_range->first_index + draw_range->index_count) {
+      ++draw_range;
+    }
+    meshlet_draw_ranges_.push_back({
+        .vertex_offset = draw_range->vertex_offset,
+        .first_index = first_index,
+        .index_count = 3 * meshlet.triangle_count,
+    });
+  }
+
+  // Interleaved float vertices are uploaded as is
+  std::vector<uint8_t> encoded_vertices;
+  const void* vertex_data = mesh_vertices->data();
+  if (options_.vertex_format != VertexFormat::kFloat32 || options_.vertex_streams == VertexStreams::kSplitPositions) {
+    encoded_vertices = EncodeVertices(*mesh_vertices, options_.vertex_format, dequantization_);
+    vertex_data = encoded_vertices.data();
+  }
+
+  auto upload_vertex_stream = [&](const Buffer& buffer, const void* data, uint32_t binding) {
+    const VkDeviceSize vertex_stride = GetVertexStride(options_.vertex_format, options_.vertex_streams, binding);
+    const VkDeviceSize vertex_byte_offset = vertex_stride * static_cast<VkDeviceSize>(geometry_.vertex_offset);
+    upload_batch.Upload(buffer, data, vertex_stride * vertex_count, vertex_byte_offset);
+  };
+  if (options_.vertex_streams == VertexStreams::kSplitPositions) {
+    const auto streams = SplitVertexStreams(encoded_vertices, options_.vertex_format);
+    upload_vertex_stream(geometry_arena_->GetPositionBuffer(geometry_.page), streams[0].data(), 0);
+    upload_vertex_stream(geometry_arena_->GetVertexBuffer(geometry_.page), streams[1].data(), 1);
+  } else {
+    upload_vertex_stream(geometry_arena_->GetVertexBuffer(geometry_.page), vertex_data, 0);
+  }
 
-  staging_buffer.CopyTo(*index_buffer_, buffer_size);
+  const VkDeviceSize index_size = GetIndexSize(format.index_type);
+  const void* index_data = format.index_type == VK_INDEX_TYPE_UINT16
+                               ? static_cast<const void*>(index16_geometry.indices.data())
+                               : static_cast<const void*>(mesh_indices.data());
+  upload_batch.Upload(geometry_arena_->GetIndexBuffer(geometry_.page), index_data, index_size * index_count,
+                      index_size * geometry_.first_index);
 }
 
 }  // namespace engine
@@ -0,0 +1,482 @@
+#include "engine/mesh_bvh.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <numeric>
+
+#include "engine/bounds.h"
+#include "engine/thread_pool.h"
+#include "simd.h"
+
+namespace {
+constexpr uint32_t kBinCount = 16;
+// Leaves of more triangles are always split, smaller ranges only when the surface area heuristic finds it cheaper
+constexpr uint32_t kMaxLeafTriangles = 16;
+// Deeper ranges become leaves whatever their size, which bounds the traversal stack
+constexpr uint32_t kMaxDepth = 64;
+// Cost of testing a node's boxes relative to that of testing a block of four triangles
+constexpr float kNodeCost = 1.0f;
+// Ranges at least this large are split on the calling thread before the subtrees are built in parallel
+constexpr uint32_t kMinParallelTriangles = 4096;
+// Each node visited pops one entry and pushes at most four
+constexpr uint32_t kTraversalStackSize = 3 * kMaxDepth + 1;
+// Stands in for zero direction components, whose infinite inverse would make NaNs of the slab test
+constexpr float kMinDirection = 1e-30f;
+
+// Nodes and triangle blocks are laid out in fours, which the kernels below test at once on every target
+using Floats = engine::simd::Floats4;
+
+struct Floats3 {
+  Floats x;
+  Floats y;
+  Floats z;
+
+  static Floats3 Broadcast(const glm::vec3& v) {
+    return {Floats::Broadcast(v.x), Floats::Broadcast(v.y), Floats::Broadcast(v.z)};
+  }
+  static Floats3 Load(const std::array<float, 4>& x, const std::array<float, 4>& y, const std::array<float, 4>& z) {
+    return {Floats::Load(x.data()), Floats::Load(y.data()), Floats::Load(z.data())};
+  }
+
+  friend Floats3 operator-(const Floats3& a, const Floats3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+  friend Floats Dot(const Floats3& a, const Floats3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+  friend Floats3 Cross(const Floats3& a, const Floats3& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+  }
+};
+
+struct BuildTriangle {
+  engine::BoundingBox box;
+  glm::vec3 centroid{0.0f};
+};
+
+// Inner node if count is zero, otherwise a leaf over order[first, first + count)
+struct BinaryNode {
+  engine::BoundingBox box;
+  uint32_t left = 0;
+  uint32_t right = 0;
+  uint32_t first = 0;
+  uint32_t count = 0;
+};
+
+constexpr engine::BoundingBox kEmptyBox{.min = glm::vec3{std::numeric_limits<float>::max()},
+                                        .max = glm::vec3{std::numeric_limits<float>::lowest()}};
+
+void Grow(engine::BoundingBox& box, const engine::BoundingBox& other) {
+  box.min = glm::min(box.min, other.min);
+  box.max = glm::max(box.max, other.max);
+}
+
+float GetSurfaceArea(const engine::BoundingBox& box) {
+  const glm::vec3 extent = box.GetExtent();
+  return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+// Triangles are tested in blocks of four, so a leaf costs as much as its blocks
+float GetLeafCost(uint32_t triangle_count) {
+  return static_cast<float>((triangle_count + 3) / 4);
+}
+
+// Builds the binary tree with binned SAH splits, partitioning the triangle order in place
+class BinaryTreeBuilder {
+ public:
+  BinaryTreeBuilder(const std::vector<BuildTriangle>& triangles, std::vector<uint32_t>& order)
+      : triangles_{triangles}, order_{order} {}
+
+  // Splits the range into a node of its own and its children's ranges, or makes it a leaf. Returns the size of the
+  // left child's range, zero for leaves.
+  uint32_t SplitNode(std::vector<BinaryNode>& nodes, uint32_t node_index, uint32_t first, uint32_t count,
+                     uint32_t depth) const {
+    engine::BoundingBox box = kEmptyBox;
+    engine::BoundingBox centroid_box = kEmptyBox;
+    for (uint32_t i = first; i < first + count; ++i) {
+      const BuildTriangle& triangle = triangles_[order_[i]];
+      Grow(box, triangle.box);
+      Grow(centroid_box, {.min = triangle.centroid, .max = triangle.centroid});
+    }
+    const uint32_t left_count = depth < kMaxDepth ? Partition(box, centroid_box, first, count) : 0;
+    if (left_count == 0) {
+      nodes[node_index] = {.box = box, .first = first, .count = count};
+      return 0;
+    }
+    const auto left = static_cast<uint32_t>(nodes.size());
+    nodes.resize(nodes.size() + 2);
+    nodes[node_index] = {.box = box, .left = left, .right = left + 1};
+    return left_count;
+  }
+
+  void BuildSubtree(std::vector<BinaryNode>& nodes, uint32_t node_index, uint32_t first, uint32_t count,
+                    uint32_t depth) const {
+    const uint32_t left_count = SplitNode(nodes, node_index, first, count, depth);
+    if (left_count == 0) {
+      return;
+    }
+    const uint32_t left = nodes[node_index].left;
+    const uint32_t right = nodes[node_index].right;
+    BuildSubtree(nodes, left, first, left_count, depth + 1);
+    BuildSubtree(nodes, right, first + left_count, count - left_count, depth + 1);
+  }
+
+ private:
+  const std::vector<BuildTriangle>& triangles_;
+  std::vector<uint32_t>& order_;
+
+  // Partitions the range by the cheapest split along the centroids' bins, returns the size of the first part or zero
+  // if a leaf is cheaper
+  [[nodiscard]] uint32_t Partition(const engine::BoundingBox& box, const engine::BoundingBox& centroid_box,
+                                   uint32_t first, uint32_t count) const {
+    if (count <= 4) {
+      return 0;
+    }
+
+    float best_cost = std::numeric_limits<float>::max();
+    uint32_t best_axis = 0;
+    uint32_t best_bin = 0;  // First bin of the second part
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+      const float extent = centroid_box.max[axis] - centroid_box.min[axis];
+      if (extent <= 0.0f) {
+        continue;
+      }
+      std::array<engine::BoundingBox, kBinCount> bin_boxes;
+      bin_boxes.fill(kEmptyBox);
+      std::array<uint32_t, kBinCount> bin_counts{};
+      for (uint32_t i = first; i < first + count; ++i) {
+        const BuildTriangle& triangle = triangles_[order_[i]];
+        const uint32_t bin = GetBin(triangle.centroid[axis], centroid_box.min[axis], extent);
+        Grow(bin_boxes[bin], triangle.box);
+        ++bin_counts[bin];
+      }
+      // Right to left sweep for the second parts, then left to right for the first parts
+      std::array<float, kBinCount> right_costs{};
+      engine::BoundingBox right_box = kEmptyBox;
+      uint32_t right_count = 0;
+      for (uint32_t bin = kBinCount - 1; bin > 0; --bin) {
+        Grow(right_box, bin_boxes[bin]);
+        right_count += bin_counts[bin];
+        right_costs[bin] = right_count > 0 ? GetSurfaceArea(right_box) * GetLeafCost(right_count) : 0.0f;
+      }
+      engine::BoundingBox left_box = kEmptyBox;
+      uint32_t left_count = 0;
+      for (uint32_t bin = 1; bin < kBinCount; ++bin) {
+        Grow(left_box, bin_boxes[bin - 1]);
+        left_count += bin_counts[bin - 1];
+        if (left_count == 0 || left_count == count) {
+          continue;
+        }
+        const float cost = GetSurfaceArea(left_box) * GetLeafCost(left_count) + right_costs[bin];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_bin = bin;
+        }
+      }
+    }
+
+    if (best_bin == 0) {
+      // Every centroid is the same, any split is as good as another
+      return count > kMaxLeafTriangles ? count / 2 : 0;
+    }
+    const float area = GetSurfaceArea(box);
+    best_cost = kNodeCost + (area > 0.0f ? best_cost / area : 0.0f);
+    if (count <= kMaxLeafTriangles && best_cost >= GetLeafCost(count)) {
+      return 0;
+    }
+    const float extent = centroid_box.max[best_axis] - centroid_box.min[best_axis];
+    const auto middle = std::partition(order_.begin() + first, order_.begin() + first + count, [&](uint32_t triangle) {
+      return GetBin(triangles_[triangle].centroid[best_axis], centroid_box.min[best_axis], extent) < best_bin;
+    });
+    return static_cast<uint32_t>(middle - (order_.begin() + first));
+  }
+
+  static uint32_t GetBin(float centroid, float min, float extent) {
+    const auto bin = static_cast<uint32_t>((centroid - min) / extent * static_cast<float>(kBinCount));
+    return std::min(bin, kBinCount - 1);
+  }
+};
+}  // namespace
+
+namespace engine {
+MeshBvh::MeshBvh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+  assert(indices.size() % 3 == 0);
+  const auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+  if (triangle_count == 0) {
+    return;
+  }
+  auto get_position = [&](uint32_t triangle, uint32_t corner) -> const glm::vec3& {
+    return vertices[indices[3 * triangle + corner]].position;
+  };
+
+  std::vector<BuildTriangle> triangles(triangle_count);
+  for (uint32_t i = 0; i < triangle_count; ++i) {
+    BuildTriangle& triangle = triangles[i];
+    triangle.box = {.min = get_position(i, 0), .max = get_position(i, 0)};
+    Grow(triangle.box, {.min = get_position(i, 1), .max = get_position(i, 1)});
+    Grow(triangle.box, {.min = get_position(i, 2), .max = get_position(i, 2)});
+    triangle.centroid = triangle.box.GetCenter();
+  }
+  std::vector<uint32_t> order(triangle_count);
+  std::iota(order.begin(), order.end(), 0);
+  const BinaryTreeBuilder builder{triangles, order};
+
+  // The top of the tree is split on the calling thread until there are enough subtrees to keep the workers busy,
+  // each subtree's range of the order is then partitioned by one task alone
+  struct Subtree {
+    uint32_t node = 0;
+    uint32_t first = 0;
+    uint32_t count = 0;
+    uint32_t depth = 0;
+  };
+  std::vector<BinaryNode> binary_nodes(1);
+  std::vector<Subtree> subtrees{{.count = triangle_count}};
+  const uint32_t target_subtree_count = 4 * (ThreadPool::Get().GetWorkerCount() + 1);
+  while (subtrees.size() < target_subtree_count) {
+    const auto largest = std::max_element(subtrees.begin(), subtrees.end(),
+                                          [](const Subtree& lhs, const Subtree& rhs) { return lhs.count < rhs.count; });
+    if (largest->count < kMinParallelTriangles) {
+      break;
+    }
+    const Subtree subtree = *largest;
+    const uint32_t left_count =
+        builder.SplitNode(binary_nodes, subtree.node, subtree.first, subtree.count, subtree.depth);
+    assert(left_count > 0);  // Ranges this large are always split
+    const BinaryNode& node = binary_nodes[subtree.node];
+    *largest = {.node = node.left, .first = subtree.first, .count = left_count, .depth = subtree.depth + 1};
+    subtrees.push_back({
+        .node = node.right,
+        .first = subtree.first + left_count,
+        .count = subtree.count - left_count,
+        .depth = subtree.depth + 1,
+    });
+  }
+  std::vector<std::vector<BinaryNode>> subtree_nodes(subtrees.size());
+  ThreadPool::Get().ParallelFor(static_cast<uint32_t>(subtrees.size()), [&](uint32_t i) {
+    subtree_nodes[i].resize(1);
+    builder.BuildSubtree(subtree_nodes[i], 0, subtrees[i].first, subtrees[i].count, subtrees[i].depth);
+  });
+  // Each subtree's root takes the place of its top node, the rest of its nodes are appended
+  for (size_t i = 0; i < subtrees.size(); ++i) {
+    const auto base = static_cast<uint32_t>(binary_nodes.size()) - 1;
+    for (size_t j = 0; j < subtree_nodes[i].size(); ++j) {
+      BinaryNode node = subtree_nodes[i][j];
+      if (node.count == 0) {
+        node.left += base;
+        node.right += base;
+      }
+      if (j == 0) {
+        binary_nodes[subtrees[i].node] = node;
+      } else {
+        binary_nodes.push_back(node);
+      }
+    }
+  }
+
+  auto add_leaf = [&](const BinaryNode& leaf) {
+    const auto first_block = static_cast<uint32_t>(triangle_blocks_.size());
+    for (uint32_t i = 0; i < leaf.count; i += 4) {
+      TriangleBlock& block = triangle_blocks_.emplace_back();
+      for (uint32_t lane = 0; lane < 4 && i + lane < leaf.count; ++lane) {
+        const uint32_t triangle = order[leaf.first + i + lane];
+        const glm::vec3& v0 = get_position(triangle, 0);
+        const glm::vec3 e1 = get_position(triangle, 1) - v0;
+        const glm::vec3 e2 = get_position(triangle, 2) - v0;
+        block.v0_x[lane] = v0.x;
+        block.v0_y[lane] = v0.y;
+        block.v0_z[lane] = v0.z;
+        block.e1_x[lane] = e1.x;
+        block.e1_y[lane] = e1.y;
+        block.e1_z[lane] = e1.z;
+        block.e2_x[lane] = e2.x;
+        block.e2_y[lane] = e2.y;
+        block.e2_z[lane] = e2.z;
+        block.triangles[lane] = triangle;
+      }
+    }
+    return first_block;
+  };
+  // Unused children are skipped by their null child index, the root being no node's child. Their boxes at infinity
+  // are missed anyway by rays of finite extent.
+  auto add_node = [&]() {
+    const auto node_index = static_cast<uint32_t>(nodes_.size());
+    Node& node = nodes_.emplace_back();
+    for (std::array<float, 4>* bound : {&node.min_x, &node.min_y, &node.min_z, &node.max_x, &node.max_y, &node.max_z}) {
+      bound->fill(std::numeric_limits<float>::infinity());
+    }
+    return node_index;
+  };
+  auto set_child = [&](uint32_t node_index, uint32_t lane, const BinaryNode& child) {
+    Node& node = nodes_[node_index];
+    node.min_x[lane] = child.box.min.x;
+    node.min_y[lane] = child.box.min.y;
+    node.min_z[lane] = child.box.min.z;
+    node.max_x[lane] = child.box.max.x;
+    node.max_y[lane] = child.box.max.y;
+    node.max_z[lane] = child.box.max.z;
+  };
+  // Nodes take the place of binary inner nodes, opening up their largest inner children until there are four
+  auto collapse = [&](auto& self, uint32_t binary_index) -> uint32_t {
+    std::array<uint32_t, 4> children{binary_nodes[binary_index].left, binary_nodes[binary_index].right};
+    uint32_t child_count = 2;
+    while (child_count < 4) {
+      uint32_t largest = child_count;
+      for (uint32_t i = 0; i < child_count; ++i) {
+        const BinaryNode& child = binary_nodes[children[i]];
+        if (child.count == 0 && (largest == child_count || GetSurfaceArea(child.box) >
+                                                               GetSurfaceArea(binary_nodes[children[largest]].box))) {
+          largest = i;
+        }
+      }
+      if (largest == child_count) {
+        break;
+      }
+      const BinaryNode& opened = binary_nodes[children[largest]];
+      children[largest] = opened.left;
+      children[child_count++] = opened.right;
+    }
+
+    const uint32_t node_index = add_node();
+    for (uint32_t lane = 0; lane < child_count; ++lane) {
+      const BinaryNode& child = binary_nodes[children[lane]];
+      set_child(node_index, lane, child);
+      // Indices rather than references, the vectors grow as the children are added
+      if (child.count > 0) {
+        const uint32_t first_block = add_leaf(child);
+        nodes_[node_index].children[lane] = first_block;
+        nodes_[node_index].block_counts[lane] = (child.count + 3) / 4;
+      } else {
+        const uint32_t child_index = self(self, children[lane]);
+        nodes_[node_index].children[lane] = child_index;
+      }
+    }
+    return node_index;
+  };
+  if (binary_nodes[0].count > 0) {
+    // Too few triangles to split, the root has the only leaf
+    add_node();
+    set_child(0, 0, binary_nodes[0]);
+    nodes_[0].block_counts[0] = (binary_nodes[0].count + 3) / 4;
+    nodes_[0].children[0] = add_leaf(binary_nodes[0]);
+  } else {
+    collapse(collapse, 0);
+  }
+}
+
+std::optional<RayHit> MeshBvh::Intersect(const Ray& ray) const {
+  RayHit hit;
+  if (!Traverse<false>(ray, hit)) {
+    return std::nullopt;
+  }
+  return hit;
+}
+
+bool MeshBvh::IntersectsAny(const Ray& ray) const {
+  RayHit hit;
+  return Traverse<true>(ray, hit);
+}
+
+template <bool kAnyHit>
+bool MeshBvh::Traverse(const Ray& ray, RayHit& hit) const {
+  if (nodes_.empty()) {
+    return false;
+  }
+  glm::vec3 inverse_direction;
+  for (int axis = 0; axis < 3; ++axis) {
+    inverse_direction[axis] = 1.0f / (ray.direction[axis] != 0.0f ? ray.direction[axis] : kMinDirection);
+  }
+  const Floats3 origin = Floats3::Broadcast(ray.origin);
+  const Floats3 direction = Floats3::Broadcast(ray.direction);
+  const Floats3 inverse = Floats3::Broadcast(inverse_direction);
+  const Floats zero = Floats::Broadcast(0.0f);
+  const Floats one = Floats::Broadcast(1.0f);
+
+  // Rays of infinite extent would find the boxes of unused children at infinity too
+  float max_t = std::min(ray.max_t, std::numeric_limits<float>::max());
+  bool found = false;
+  // Moller-Trumbore against four triangles, degenerate ones give NaNs that fail every comparison
+  auto intersect_block = [&](const TriangleBlock& block) {
+    const Floats3 v0 = Floats3::Load(block.v0_x, block.v0_y, block.v0_z);
+    const Floats3 e1 = Floats3::Load(block.e1_x, block.e1_y, block.e1_z);
+    const Floats3 e2 = Floats3::Load(block.e2_x, block.e2_y, block.e2_z);
+    const Floats3 p = Cross(direction, e2);
+    const Floats inverse_determinant = one / Dot(e1, p);
+    const Floats3 s = origin - v0;
+    const Floats u = Dot(s, p) * inverse_determinant;
+    const Floats3 q = Cross(s, e1);
+    const Floats v = Dot(direction, q) * inverse_determinant;
+    const Floats t = Dot(e2, q) * inverse_determinant;
+    uint32_t mask = MoveMask(GreaterEqual(u, zero) & GreaterEqual(v, zero) & LessEqual(u + v, one) &
+                             GreaterEqual(t, zero) & LessEqual(t, Floats::Broadcast(max_t)));
+    if (mask == 0) {
+      return;
+    }
+    alignas(16) std::array<float, 4> lane_t{};
+    alignas(16) std::array<float, 4> lane_u{};
+    alignas(16) std::array<float, 4> lane_v{};
+    t.Store(lane_t.data());
+    u.Store(lane_u.data());
+    v.Store(lane_v.data());
+    for (; mask != 0; mask &= mask - 1) {
+      const auto lane = static_cast<uint32_t>(std::countr_zero(mask));
+      if (lane_t[lane] <= max_t) {
+        max_t = lane_t[lane];
+        hit = {.t = lane_t[lane], .triangle = block.triangles[lane], .barycentrics = {lane_u[lane], lane_v[lane]}};
+        found = true;
+      }
+    }
+  };
+
+  std::array<uint32_t, kTraversalStackSize> stack;
+  uint32_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    const Node& node = nodes_[stack[--stack_size]];
+    // Slab test against the four child boxes
+    const Floats3 t0 = Floats3::Load(node.min_x, node.min_y, node.min_z) - origin;
+    const Floats3 t1 = Floats3::Load(node.max_x, node.max_y, node.max_z) - origin;
+    const Floats3 near{Min(t0.x * inverse.x, t1.x * inverse.x), Min(t0.y * inverse.y, t1.y * inverse.y),
+                       Min(t0.z * inverse.z, t1.z * inverse.z)};
+    const Floats3 far{Max(t0.x * inverse.x, t1.x * inverse.x), Max(t0.y * inverse.y, t1.y * inverse.y),
+                      Max(t0.z * inverse.z, t1.z * inverse.z)};
+    const Floats t_near = Max(Max(near.x, near.y), Max(near.z, zero));
+    const Floats t_far = Min(Min(far.x, far.y), Min(far.z, Floats::Broadcast(max_t)));
+    uint32_t mask = MoveMask(LessEqual(t_near, t_far));
+    if (mask == 0) {
+      continue;
+    }
+
+    // Leaves are tested right away, inner children are pushed far to near so that the nearest is visited first
+    alignas(16) std::array<float, 4> lane_near{};
+    t_near.Store(lane_near.data());
+    std::array<uint32_t, 4> inner_lanes{};
+    uint32_t inner_count = 0;
+    for (; mask != 0; mask &= mask - 1) {
+      const auto lane = static_cast<uint32_t>(std::countr_zero(mask));
+      if (node.block_counts[lane] == 0) {
+        if (node.children[lane] != 0) {
+          inner_lanes[inner_count++] = lane;
+        }
+        continue;
+      }
+      const uint32_t first_block = node.children[lane];
+      for (uint32_t block = first_block; block < first_block + node.block_counts[lane]; ++block) {
+        intersect_block(triangle_blocks_[block]);
+        if (kAnyHit && found) {
+          return true;
+        }
+      }
+    }
+    // Insertion sort, there are at most four
+    for (uint32_t i = 1; i < inner_count; ++i) {
+      for (uint32_t j = i; j > 0 && lane_near[inner_lanes[j - 1]] < lane_near[inner_lanes[j]]; --j) {
+        std::swap(inner_lanes[j - 1], inner_lanes[j]);
+      }
+    }
+    for (uint32_t i = 0; i < inner_count; ++i) {
+      assert(stack_size < stack.size());
+      stack[stack_size++] = node.children[inner_lanes[i]];
+    }
+  }
+  return found;
+}
+}  // namespace engine
@@ -0,0 +1,314 @@
+#include "engine/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <numeric>
+
+#include "engine/thread_pool.h"
+
+namespace {
+constexpr uint32_t kNoVertex = ~0u;
+
+// FIFO cache simulated with insertion timestamps, a vertex is cached while fewer than cache_size vertices have been
+// inserted after it
+class VertexCache {
+ public:
+  VertexCache(uint32_t vertex_count, uint32_t cache_size)
+      : timestamps_(vertex_count, 0), cache_size_{cache_size}, time_{cache_size + 1} {}
+
+  // Returns whether the vertex had to be transformed
+  bool Access(uint32_t vertex) {
+    if (time_ - timestamps_[vertex] <= cache_size_) {
+      return false;
+    }
+    timestamps_[vertex] = time_++;
+    return true;
+  }
+  void Flush() { time_ += cache_size_ + 1; }
+
+ private:
+  std::vector<uint32_t> timestamps_;
+  uint32_t cache_size_;
+  uint32_t time_;
+};
+
+uint32_t CountMisses(VertexCache& cache, const std::vector<uint32_t>& indices, uint32_t triangle) {
+  return cache.Access(indices[3 * triangle + 0]) + cache.Access(indices[3 * triangle + 1]) +
+         cache.Access(indices[3 * triangle + 2]);
+}
+}  // namespace
+
+namespace engine {
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertex_count,
+                                         uint32_t cache_size) {
+  assert(indices.size() % 3 == 0);
+  const auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+  if (triangle_count == 0 || vertex_count == 0) {
+    return {};
+  }
+  VertexCache cache{vertex_count, cache_size};
+  uint64_t transformed_vertex_count = 0;
+  for (uint32_t i = 0; i < triangle_count; ++i) {
+    transformed_vertex_count += CountMisses(cache, indices, i);
+  }
+  return {
+      .acmr = static_cast<float>(transformed_vertex_count) / static_cast<float>(triangle_count),
+      .atvr = static_cast<float>(transformed_vertex_count) / static_cast<float>(vertex_count),
+  };
+}
+
+std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertex_count,
+                                          uint32_t cache_size) {
+  assert(indices.size() % 3 == 0);
+  const auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+  // Triangles around each vertex
+  std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+  for (uint32_t index : indices) {
+    ++adjacency_offsets[index + 1];
+  }
+  std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+  std::vector<uint32_t> adjacency(indices.size());
+  std::vector<uint32_t> adjacency_fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+  for (uint32_t i = 0; i < indices.size(); ++i) {
+    adjacency[adjacency_fill[indices[i]]++] = i / 3;
+  }
+
+  std::vector<uint32_t> live_triangle_counts(vertex_count);
+  for (uint32_t i = 0; i < vertex_count; ++i) {
+    live_triangle_counts[i] = adjacency_offsets[i + 1] - adjacency_offsets[i];
+  }
+  std::vector<uint32_t> timestamps(vertex_count, 0);
+  uint32_t time = cache_size + 1;
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<uint32_t> dead_ends;  // Recently used vertices, to resume from when fanning runs out of candidates
+  dead_ends.reserve(indices.size());
+  uint32_t scan_cursor = 0;  // Last resort, the next vertex in input order
+
+  auto skip_dead_end = [&]() -> uint32_t {
+    while (!dead_ends.empty()) {
+      const uint32_t vertex = dead_ends.back();
+      dead_ends.pop_back();
+      if (live_triangle_counts[vertex] > 0) {
+        return vertex;
+      }
+    }
+    for (; scan_cursor < vertex_count; ++scan_cursor) {
+      if (live_triangle_counts[scan_cursor] > 0) {
+        return scan_cursor;
+      }
+    }
+    return kNoVertex;
+  };
+
+  std::vector<uint32_t> optimized_indices;
+  optimized_indices.reserve(indices.size());
+  std::vector<uint32_t> clusters;
+  std::vector<uint32_t> candidates;
+  uint32_t fanning_vertex = skip_dead_end();
+  bool dead_end = true;
+  while (fanning_vertex != kNoVertex) {
+    if (dead_end) {
+      clusters.push_back(static_cast<uint32_t>(optimized_indices.size() / 3));
+    }
+
+    // Emit every remaining triangle around the fanning vertex
+    candidates.clear();
+    for (uint32_t i = adjacency_offsets[fanning_vertex]; i < adjacency_offsets[fanning_vertex + 1]; ++i) {
+      const uint32_t triangle = adjacency[i];
+      if (emitted[triangle]) {
+        continue;
+      }
+      emitted[triangle] = true;
+      for (uint32_t j = 0; j < 3; ++j) {
+        const uint32_t vertex = indices[3 * triangle + j];
+        optimized_indices.push_back(vertex);
+        dead_ends.push_back(vertex);
+        candidates.push_back(vertex);
+        --live_triangle_counts[vertex];
+        if (time - timestamps[vertex] > cache_size) {
+          timestamps[vertex] = time++;
+        }
+      }
+    }
+
+    // Next, the oldest candidate that stays in the cache while its remaining triangles are emitted
+    uint32_t next_vertex = kNoVertex;
+    int64_t best_priority = -1;
+    for (uint32_t vertex : candidates) {
+      if (live_triangle_counts[vertex] == 0) {
+        continue;
+      }
+      int64_t priority = 0;
+      if (time - timestamps[vertex] + 2 * live_triangle_counts[vertex] <= cache_size) {
+        priority = time - timestamps[vertex];
+      }
+      if (priority > best_priority) {
+        best_priority = priority;
+        next_vertex = vertex;
+      }
+    }
+    dead_end = next_vertex == kNoVertex;
+    fanning_vertex = dead_end ? skip_dead_end() : next_vertex;
+  }
+  assert(optimized_indices.size() == indices.size());
+
+  indices = std::move(optimized_indices);
+  return clusters;
+}
+
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                      const std::vector<uint32_t>& clusters, float threshold) {
+  assert(indices.size() % 3 == 0);
+  const auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+  if (clusters.empty()) {
+    return;
+  }
+
+  // Split the clusters wherever the part so far, starting from a cold cache, is nearly as efficient as the whole
+  VertexCache cache{static_cast<uint32_t>(vertices.size()), kVertexCacheSize};
+  std::vector<uint32_t> parts;
+  for (size_t i = 0; i < clusters.size(); ++i) {
+    const uint32_t first = clusters[i];
+    const uint32_t last = i + 1 < clusters.size() ? clusters[i + 1] : triangle_count;
+    cache.Flush();
+    uint32_t cluster_misses = 0;
+    for (uint32_t triangle = first; triangle < last; ++triangle) {
+      cluster_misses += CountMisses(cache, indices, triangle);
+    }
+    const float acmr_threshold = threshold * static_cast<float>(cluster_misses) / static_cast<float>(last - first);
+
+    cache.Flush();
+    parts.push_back(first);
+    uint32_t part_misses = 0;
+    for (uint32_t triangle = first; triangle + 1 < last; ++triangle) {
+      part_misses += CountMisses(cache, indices, triangle);
+      if (static_cast<float>(part_misses) <= acmr_threshold * static_cast<float>(triangle + 1 - parts.back())) {
+        parts.push_back(triangle + 1);
+        part_misses = 0;
+        cache.Flush();
+      }
+    }
+  }
+  parts.push_back(triangle_count);
+
+  // Area-weighted centroids and normals
+  auto triangle_position = [&](uint32_t triangle, uint32_t corner) {
+    return vertices[indices[3 * triangle + corner]].position;
+  };
+  glm::vec3 mesh_centroid{0.0f};
+  float mesh_area = 0.0f;
+  for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+    const glm::vec3 p0 = triangle_position(triangle, 0);
+    const glm::vec3 p1 = triangle_position(triangle, 1);
+    const glm::vec3 p2 = triangle_position(triangle, 2);
+    const float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+    mesh_centroid += (p0 + p1 + p2) * (area / 3.0f);
+    mesh_area += area;
+  }
+  mesh_centroid = mesh_area > 0.0f ? mesh_centroid / mesh_area : glm::vec3{0.0f};
+
+  const auto part_count = static_cast<uint32_t>(parts.size() - 1);
+  std::vector<float> sort_keys(part_count);
+  for (uint32_t i = 0; i < part_count; ++i) {
+    glm::vec3 centroid{0.0f};
+    glm::vec3 normal{0.0f};
+    float area = 0.0f;
+    for (uint32_t triangle = parts[i]; triangle < parts[i + 1]; ++triangle) {
+      const glm::vec3 p0 = triangle_position(triangle, 0);
+      const glm::vec3 p1 = triangle_position(triangle, 1);
+      const glm::vec3 p2 = triangle_position(triangle, 2);
+      const glm::vec3 weighted_normal = glm::cross(p1 - p0, p2 - p0);
+      const float triangle_area = glm::length(weighted_normal);
+      centroid += (p0 + p1 + p2) * (triangle_area / 3.0f);
+      normal += weighted_normal;
+      area += triangle_area;
+    }
+    const float normal_length = glm::length(normal);
+    if (area > 0.0f && normal_length > 0.0f) {
+      sort_keys[i] = glm::dot(centroid / area - mesh_centroid, normal / normal_length);
+    }
+  }
+
+  std::vector<uint32_t> order(part_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+    return sort_keys[lhs] > sort_keys[rhs];
+  });
+
+  std::vector<uint32_t> sorted_indices;
+  sorted_indices.reserve(indices.size());
+  for (uint32_t part : order) {
+    sorted_indices.insert(sorted_indices.end(), indices.begin() + 3 * parts[part],
+                          indices.begin() + 3 * parts[part + 1]);
+  }
+  indices = std::move(sorted_indices);
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+  std::vector<uint32_t> remap(vertices.size(), kNoVertex);
+  std::vector<Vertex> fetched_vertices;
+  fetched_vertices.reserve(vertices.size());
+  for (uint32_t& index : indices) {
+    if (remap[index] == kNoVertex) {
+      remap[index] = static_cast<uint32_t>(fetched_vertices.size());
+      fetched_vertices.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+  vertices = std::move(fetched_vertices);
+}
+
+MeshOptimizationStatistics OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                        uint32_t segment_triangle_count) {
+  assert(indices.size() % 3 == 0);
+  MeshOptimizationStatistics statistics;
+  statistics.before = AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+
+  const auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+  if (segment_triangle_count == 0 || triangle_count <= segment_triangle_count) {
+    const std::vector<uint32_t> clusters = OptimizeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+    OptimizeOverdraw(indices, vertices, clusters);
+  } else {
+    // Each segment gets a compact copy of its vertices. Those shared with other segments are transformed once per
+    // segment, a small cost next to the cache misses within the segments.
+    const uint32_t segment_count = (triangle_count + segment_triangle_count - 1) / segment_triangle_count;
+    ThreadPool::Get().ParallelFor(segment_count, [&](uint32_t segment) {
+      const size_t first = 3 * static_cast<size_t>(segment) * segment_triangle_count;
+      const size_t last = std::min(first + 3 * static_cast<size_t>(segment_triangle_count), indices.size());
+
+      std::vector<uint32_t> segment_indices(indices.begin() + first, indices.begin() + last);
+      std::vector<Vertex> segment_vertices;
+      std::vector<uint32_t> mesh_vertices;  // Segment vertex to mesh vertex
+      std::vector<uint32_t> remap(vertices.size(), kNoVertex);
+      for (uint32_t& index : segment_indices) {
+        if (remap[index] == kNoVertex) {
+          remap[index] = static_cast<uint32_t>(segment_vertices.size());
+          segment_vertices.push_back(vertices[index]);
+          mesh_vertices.push_back(index);
+        }
+        index = remap[index];
+      }
+
+      const std::vector<uint32_t> clusters =
+          OptimizeVertexCache(segment_indices, static_cast<uint32_t>(segment_vertices.size()));
+      OptimizeOverdraw(segment_indices, segment_vertices, clusters);
+      std::transform(segment_indices.begin(), segment_indices.end(), indices.begin() + first,
+                     [&mesh_vertices](uint32_t index) { return mesh_vertices[index]; });
+    });
+  }
+  OptimizeVertexFetch(vertices, indices);
+  statistics.after = AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+  return statistics;
+}
+
+void LogMeshOptimizationStatistics(std::ostream& os, const MeshOptimizationStatistics& statistics) {
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << std::fixed << std::setprecision(3) << "ACMR " << statistics.before.acmr << " -> " << statistics.after.acmr
+     << ", ATVR " << statistics.before.atvr << " -> " << statistics.after.atvr << std::endl;
+  os.flags(flags);
+  os.precision(precision);
+}
+}  // namespace engine
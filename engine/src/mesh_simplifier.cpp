@@ -0,0 +1,449 @@
+#include "engine/mesh_simplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+
+#include "engine/mesh_optimizer.h"
+
+namespace {
+// Border and seam planes outweigh the surface's so that outlines survive simplification
+constexpr double kBoundaryWeight = 10.0;
+
+// Sum of squared distances to planes, weighted by area, as a symmetric 4x4 matrix
+struct Quadric {
+  double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+  double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+  double c = 0.0;
+  double weight = 0.0;
+
+  // Plane dot(normal, p) + distance = 0 with a unit normal
+  static Quadric FromPlane(const glm::dvec3& normal, double distance, double weight) {
+    return {
+        .a00 = weight * normal.x * normal.x,
+        .a01 = weight * normal.x * normal.y,
+        .a02 = weight * normal.x * normal.z,
+        .a11 = weight * normal.y * normal.y,
+        .a12 = weight * normal.y * normal.z,
+        .a22 = weight * normal.z * normal.z,
+        .b0 = weight * distance * normal.x,
+        .b1 = weight * distance * normal.y,
+        .b2 = weight * distance * normal.z,
+        .c = weight * distance * distance,
+        .weight = weight,
+    };
+  }
+
+  Quadric& operator+=(const Quadric& other) {
+    a00 += other.a00, a01 += other.a01, a02 += other.a02, a11 += other.a11, a12 += other.a12, a22 += other.a22;
+    b0 += other.b0, b1 += other.b1, b2 += other.b2;
+    c += other.c;
+    weight += other.weight;
+    return *this;
+  }
+  Quadric operator+(const Quadric& other) const { return Quadric{*this} += other; }
+
+  // Weighted mean of the squared distances
+  [[nodiscard]] double Error(const glm::dvec3& p) const {
+    if (weight == 0.0) {
+      return 0.0;
+    }
+    const double error = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+                         2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+                         2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+    return std::max(error, 0.0) / weight;
+  }
+};
+
+struct Collapse {
+  uint32_t from = 0;
+  uint32_t to = 0;
+  double error = 0.0;
+};
+
+// Edge collapses on the vertices' positions. Vertices sharing a position, e.g. either side of a UV seam, are wedges
+// of the same root vertex; a collapse moves every wedge of one root onto the matching wedge of another.
+class Simplifier {
+ public:
+  Simplifier(const std::vector<engine::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+  // Returns the largest root mean square plane distance of the collapses made
+  double Run(size_t target_index_count, double max_error);
+
+ private:
+  const std::vector<engine::Vertex>& vertices_;
+  std::vector<uint32_t>& indices_;
+  std::vector<uint32_t> roots_;  // First vertex with the same position
+  std::vector<Quadric> quadrics_;  // By root
+  // Triangles around each root, rebuilt every pass
+  std::vector<uint32_t> adjacency_offsets_;
+  std::vector<uint32_t> adjacency_;
+  std::vector<bool> touched_;  // Roots whose neighbourhood changed during the pass
+  std::vector<bool> removed_;  // Triangles collapsed during the pass
+  // Scratch of FindCollapse()
+  std::vector<std::pair<uint32_t, uint32_t>> wedges_;
+  std::vector<std::pair<uint32_t, uint32_t>> neighbours_;
+
+  [[nodiscard]] glm::dvec3 GetPosition(uint32_t root) const { return glm::dvec3{vertices_[root].position}; }
+  [[nodiscard]] uint32_t GetRoot(uint32_t triangle, uint32_t corner) const {
+    return roots_[indices_[3 * triangle + corner]];
+  }
+  [[nodiscard]] std::pair<const uint32_t*, const uint32_t*> GetTriangles(uint32_t root) const {
+    return {adjacency_.data() + adjacency_offsets_[root], adjacency_.data() + adjacency_offsets_[root + 1]};
+  }
+
+  void WeldPositions();
+  void RemoveDegenerateTriangles();
+  void BuildAdjacency();
+  void AccumulateQuadrics();
+  // Fills wedges_ with the replacement of each wedge of from, or returns false if the collapse would tear a seam, pull
+  // in a border, make the surface non-manifold or flip a triangle
+  bool FindCollapse(uint32_t from, uint32_t to);
+  // Returns the number of triangles removed
+  uint32_t ApplyCollapse(uint32_t from, uint32_t to);
+};
+
+Simplifier::Simplifier(const std::vector<engine::Vertex>& vertices, std::vector<uint32_t>& indices)
+    : vertices_{vertices}, indices_{indices} {
+  WeldPositions();
+  RemoveDegenerateTriangles();
+  BuildAdjacency();
+  AccumulateQuadrics();
+}
+
+void Simplifier::WeldPositions() {
+  roots_.resize(vertices_.size());
+  std::unordered_map<glm::vec3, uint32_t> position_roots;
+  position_roots.reserve(vertices_.size());
+  for (uint32_t i = 0; i < vertices_.size(); ++i) {
+    roots_[i] = position_roots.try_emplace(vertices_[i].position, i).first->second;
+  }
+}
+
+void Simplifier::RemoveDegenerateTriangles() {
+  size_t kept_index_count = 0;
+  for (size_t i = 0; i < indices_.size(); i += 3) {
+    const uint32_t a = roots_[indices_[i + 0]];
+    const uint32_t b = roots_[indices_[i + 1]];
+    const uint32_t c = roots_[indices_[i + 2]];
+    if (a != b && b != c && c != a) {
+      std::copy_n(indices_.begin() + static_cast<std::ptrdiff_t>(i), 3,
+                  indices_.begin() + static_cast<std::ptrdiff_t>(kept_index_count));
+      kept_index_count += 3;
+    }
+  }
+  indices_.resize(kept_index_count);
+}
+
+void Simplifier::BuildAdjacency() {
+  const auto triangle_count = static_cast<uint32_t>(indices_.size() / 3);
+  adjacency_offsets_.assign(vertices_.size() + 1, 0);
+  for (const uint32_t index : indices_) {
+    ++adjacency_offsets_[roots_[index] + 1];
+  }
+  for (size_t i = 1; i < adjacency_offsets_.size(); ++i) {
+    adjacency_offsets_[i] += adjacency_offsets_[i - 1];
+  }
+  adjacency_.resize(indices_.size());
+  std::vector<uint32_t> fill = adjacency_offsets_;
+  for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+    for (uint32_t corner = 0; corner < 3; ++corner) {
+      adjacency_[fill[GetRoot(triangle, corner)]++] = triangle;
+    }
+  }
+}
+
+void Simplifier::AccumulateQuadrics() {
+  quadrics_.assign(vertices_.size(), {});
+  const auto triangle_count = static_cast<uint32_t>(indices_.size() / 3);
+  for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+    const glm::dvec3 p0 = GetPosition(GetRoot(triangle, 0));
+    const glm::dvec3 p1 = GetPosition(GetRoot(triangle, 1));
+    const glm::dvec3 p2 = GetPosition(GetRoot(triangle, 2));
+    const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+    const double length = glm::length(normal);
+    if (length == 0.0) {
+      continue;
+    }
+    const glm::dvec3 unit_normal = normal / length;
+    const Quadric quadric = Quadric::FromPlane(unit_normal, -glm::dot(unit_normal, p0), 0.5 * length);
+    for (uint32_t corner = 0; corner < 3; ++corner) {
+      quadrics_[GetRoot(triangle, corner)] += quadric;
+    }
+
+    // Edges of one triangle are open borders, edges whose wedges differ on either side are seams. Either gets a plane
+    // perpendicular to the triangle through it.
+    for (uint32_t corner = 0; corner < 3; ++corner) {
+      const uint32_t a = GetRoot(triangle, corner);
+      const uint32_t b = GetRoot(triangle, (corner + 1) % 3);
+      const uint32_t wedge_a = indices_[3 * triangle + corner];
+      const uint32_t wedge_b = indices_[3 * triangle + (corner + 1) % 3];
+      uint32_t edge_count = 0;
+      uint32_t wedge_edge_count = 0;
+      const auto [begin, end] = GetTriangles(a);
+      for (const uint32_t* other = begin; other != end; ++other) {
+        bool has_b = false, has_wedge_a = false, has_wedge_b = false;
+        for (uint32_t other_corner = 0; other_corner < 3; ++other_corner) {
+          has_b |= GetRoot(*other, other_corner) == b;
+          has_wedge_a |= indices_[3 * *other + other_corner] == wedge_a;
+          has_wedge_b |= indices_[3 * *other + other_corner] == wedge_b;
+        }
+        edge_count += has_b;
+        wedge_edge_count += has_wedge_a && has_wedge_b;
+      }
+      if (edge_count == 1 || wedge_edge_count < edge_count) {
+        const glm::dvec3 pa = GetPosition(a);
+        const glm::dvec3 edge = GetPosition(b) - pa;
+        const glm::dvec3 edge_normal = glm::cross(edge, unit_normal);
+        const double edge_normal_length = glm::length(edge_normal);
+        if (edge_normal_length > 0.0) {
+          const glm::dvec3 plane_normal = edge_normal / edge_normal_length;
+          const Quadric boundary = Quadric::FromPlane(plane_normal, -glm::dot(plane_normal, pa),
+                                                      kBoundaryWeight * glm::dot(edge, edge));
+          quadrics_[a] += boundary;
+          quadrics_[b] += boundary;
+        }
+      }
+    }
+  }
+}
+
+bool Simplifier::FindCollapse(uint32_t from, uint32_t to) {
+  wedges_.clear();
+  neighbours_.clear();
+  auto count_neighbour = [&](uint32_t root) {
+    auto it = std::find_if(neighbours_.begin(), neighbours_.end(), [&](const auto& n) { return n.first == root; });
+    if (it == neighbours_.end()) {
+      neighbours_.emplace_back(root, 1);
+    } else {
+      ++it->second;
+    }
+  };
+
+  // Wedges of the triangles on the collapsed edge map onto each other
+  const auto [begin, end] = GetTriangles(from);
+  for (const uint32_t* triangle = begin; triangle != end; ++triangle) {
+    uint32_t from_wedge = 0;
+    uint32_t to_wedge = ~0u;
+    for (uint32_t corner = 0; corner < 3; ++corner) {
+      const uint32_t root = GetRoot(*triangle, corner);
+      if (root == from) {
+        from_wedge = indices_[3 * *triangle + corner];
+      } else {
+        count_neighbour(root);
+        if (root == to) {
+          to_wedge = indices_[3 * *triangle + corner];
+        }
+      }
+    }
+    if (to_wedge == ~0u) {
+      continue;
+    }
+    auto it = std::find_if(wedges_.begin(), wedges_.end(), [&](const auto& w) { return w.first == from_wedge; });
+    if (it == wedges_.end()) {
+      wedges_.emplace_back(from_wedge, to_wedge);
+    } else if (it->second != to_wedge) {
+      return false;
+    }
+  }
+
+  // Every edge has one or two triangles; a vertex on a border only moves along it
+  bool border = false;
+  uint32_t edge_count = 0;
+  for (const auto& [root, count] : neighbours_) {
+    if (count > 2) {
+      return false;
+    }
+    border |= count == 1;
+    if (root == to) {
+      edge_count = count;
+    }
+  }
+  if (edge_count == 0 || (border && edge_count != 1)) {
+    return false;
+  }
+
+  // Link condition: the only neighbours shared with the target are the corners opposite the collapsed edge, otherwise
+  // the collapse would fold the surface onto itself
+  uint32_t shared_count = 0;
+  const auto [to_begin, to_end] = GetTriangles(to);
+  for (const auto& [root, count] : neighbours_) {
+    if (root == to) {
+      continue;
+    }
+    for (const uint32_t* triangle = to_begin; triangle != to_end; ++triangle) {
+      if (GetRoot(*triangle, 0) == root || GetRoot(*triangle, 1) == root || GetRoot(*triangle, 2) == root) {
+        ++shared_count;
+        break;
+      }
+    }
+  }
+  if (shared_count != edge_count) {
+    return false;
+  }
+
+  // The remaining triangles must keep their wedges and orientation
+  const glm::dvec3 to_position = GetPosition(to);
+  for (const uint32_t* triangle = begin; triangle != end; ++triangle) {
+    std::array<glm::dvec3, 3> positions;
+    bool has_to = false;
+    uint32_t from_corner = 0;
+    for (uint32_t corner = 0; corner < 3; ++corner) {
+      const uint32_t root = GetRoot(*triangle, corner);
+      positions[corner] = GetPosition(root);
+      has_to |= root == to;
+      if (root == from) {
+        from_corner = corner;
+      }
+    }
+    if (has_to) {
+      continue;
+    }
+    const uint32_t from_wedge = indices_[3 * *triangle + from_corner];
+    if (std::none_of(wedges_.begin(), wedges_.end(), [&](const auto& w) { return w.first == from_wedge; })) {
+      return false;
+    }
+    const glm::dvec3 normal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+    positions[from_corner] = to_position;
+    const glm::dvec3 collapsed_normal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+    if (glm::dot(normal, collapsed_normal) <= 1e-3 * glm::length(normal) * glm::length(collapsed_normal)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t Simplifier::ApplyCollapse(uint32_t from, uint32_t to) {
+  uint32_t removed_count = 0;
+  const auto [begin, end] = GetTriangles(from);
+  for (const uint32_t* triangle = begin; triangle != end; ++triangle) {
+    for (uint32_t corner = 0; corner < 3; ++corner) {
+      touched_[GetRoot(*triangle, corner)] = true;
+    }
+    if (GetRoot(*triangle, 0) == to || GetRoot(*triangle, 1) == to || GetRoot(*triangle, 2) == to) {
+      removed_[*triangle] = true;
+      ++removed_count;
+      continue;
+    }
+    for (uint32_t corner = 0; corner < 3; ++corner) {
+      uint32_t& index = indices_[3 * *triangle + corner];
+      if (roots_[index] == from) {
+        index = std::find_if(wedges_.begin(), wedges_.end(), [&](const auto& w) { return w.first == index; })->second;
+      }
+    }
+  }
+  quadrics_[to] += quadrics_[from];
+  return removed_count;
+}
+
+double Simplifier::Run(size_t target_index_count, double max_error) {
+  const double max_squared_error = max_error * max_error;
+  double largest_squared_error = 0.0;
+  std::vector<Collapse> collapses;
+  std::vector<Collapse> candidates;
+  while (indices_.size() > target_index_count) {
+    // The cheapest valid collapse of each vertex
+    touched_.assign(vertices_.size(), false);
+    collapses.clear();
+    for (uint32_t root = 0; root < vertices_.size(); ++root) {
+      const auto [begin, end] = GetTriangles(root);
+      candidates.clear();
+      for (const uint32_t* triangle = begin; triangle != end; ++triangle) {
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+          const uint32_t to = GetRoot(*triangle, corner);
+          if (to != root && std::none_of(candidates.begin(), candidates.end(),
+                                         [&](const Collapse& candidate) { return candidate.to == to; })) {
+            candidates.push_back({root, to, (quadrics_[root] + quadrics_[to]).Error(GetPosition(to))});
+          }
+        }
+      }
+      std::sort(candidates.begin(), candidates.end(),
+                [](const Collapse& lhs, const Collapse& rhs) { return lhs.error < rhs.error; });
+      for (const Collapse& candidate : candidates) {
+        if (candidate.error > max_squared_error) {
+          break;
+        }
+        if (FindCollapse(candidate.from, candidate.to)) {
+          collapses.push_back(candidate);
+          break;
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse& lhs, const Collapse& rhs) { return lhs.error < rhs.error; });
+
+    // Collapses whose neighbourhoods don't overlap are independent. Only the cheaper half is made per pass so that the
+    // ones blocked by a neighbour get another chance before the expensive ones go ahead.
+    removed_.assign(indices_.size() / 3, false);
+    size_t index_count = indices_.size();
+    const size_t collapse_count = collapses.size() <= 1 ? collapses.size() : collapses.size() / 2;
+    uint32_t collapsed_count = 0;
+    for (size_t i = 0; i < collapse_count && index_count > target_index_count; ++i) {
+      const Collapse& collapse = collapses[i];
+      if (touched_[collapse.from] || touched_[collapse.to] || !FindCollapse(collapse.from, collapse.to)) {
+        continue;
+      }
+      index_count -= 3 * ApplyCollapse(collapse.from, collapse.to);
+      largest_squared_error = std::max(largest_squared_error, collapse.error);
+      ++collapsed_count;
+    }
+    if (collapsed_count == 0) {
+      break;
+    }
+
+    size_t kept_index_count = 0;
+    for (size_t triangle = 0; triangle < removed_.size(); ++triangle) {
+      if (!removed_[triangle]) {
+        std::copy_n(indices_.begin() + static_cast<std::ptrdiff_t>(3 * triangle), 3,
+                    indices_.begin() + static_cast<std::ptrdiff_t>(kept_index_count));
+        kept_index_count += 3;
+      }
+    }
+    indices_.resize(kept_index_count);
+    BuildAdjacency();
+  }
+  return std::sqrt(largest_squared_error);
+}
+}  // namespace
+
+namespace engine {
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                   size_t target_index_count, float max_error, float* error) {
+  assert(indices.size() % 3 == 0);
+  std::vector<uint32_t> simplified_indices = indices;
+  Simplifier simplifier{vertices, simplified_indices};
+  const double largest_error = simplifier.Run(target_index_count, max_error);
+  if (error) {
+    *error = static_cast<float>(largest_error);
+  }
+  return simplified_indices;
+}
+
+std::vector<LodLevel> BuildLodChain(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                    uint32_t max_lod_count) {
+  std::vector<LodLevel> levels{{.index_count = static_cast<uint32_t>(indices.size())}};
+  while (levels.size() < max_lod_count) {
+    const LodLevel previous = levels.back();
+    const std::vector<uint32_t> previous_indices(indices.begin() + previous.first_index,
+                                                 indices.begin() + previous.first_index + previous.index_count);
+    float error = 0.0f;
+    std::vector<uint32_t> lod_indices = SimplifyMesh(vertices, previous_indices, previous.index_count / 6 * 3,
+                                                     std::numeric_limits<float>::max(), &error);
+    // A level that keeps most of the triangles isn't worth its memory
+    if (lod_indices.empty() || 4 * lod_indices.size() > 3 * static_cast<size_t>(previous.index_count)) {
+      break;
+    }
+    OptimizeVertexCache(lod_indices, static_cast<uint32_t>(vertices.size()));
+    levels.push_back({
+        .first_index = static_cast<uint32_t>(indices.size()),
+        .index_count = static_cast<uint32_t>(lod_indices.size()),
+        .error = previous.error + error,
+    });
+    indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
+  }
+  return levels;
+}
+}  // namespace engine
@@ -0,0 +1,100 @@
+#include "engine/meshlet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace engine {
+std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                   uint32_t max_vertices, uint32_t max_triangles) {
+  assert(indices.size() % 3 == 0);
+  assert(max_vertices >= 3 && max_triangles >= 1);
+  const auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+  std::vector<Meshlet> meshlets;
+  // The meshlet that last used each vertex, +1 so that zero is none
+  std::vector<uint32_t> vertex_meshlets(vertices.size(), 0);
+  Meshlet meshlet{};
+  auto count_new_vertices = [&](uint32_t triangle) {
+    const uint32_t a = indices[3 * triangle + 0];
+    const uint32_t b = indices[3 * triangle + 1];
+    const uint32_t c = indices[3 * triangle + 2];
+    const auto stamp = static_cast<uint32_t>(meshlets.size() + 1);
+    return static_cast<uint32_t>(vertex_meshlets[a] != stamp) + (vertex_meshlets[b] != stamp && b != a) +
+           (vertex_meshlets[c] != stamp && c != a && c != b);
+  };
+
+  for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+    uint32_t new_vertex_count = count_new_vertices(triangle);
+    const bool full = meshlet.vertex_count + new_vertex_count > max_vertices || meshlet.triangle_count == max_triangles;
+    const bool disconnected = new_vertex_count == 3 && meshlet.triangle_count >= max_triangles / 4;
+    if (meshlet.triangle_count > 0 && (full || disconnected)) {
+      meshlets.push_back(meshlet);
+      meshlet = {.first_triangle = triangle};
+      new_vertex_count = count_new_vertices(triangle);
+    }
+
+    const auto stamp = static_cast<uint32_t>(meshlets.size() + 1);
+    for (uint32_t i = 0; i < 3; ++i) {
+      vertex_meshlets[indices[3 * triangle + i]] = stamp;
+    }
+    meshlet.vertex_count += new_vertex_count;
+    ++meshlet.triangle_count;
+  }
+  if (meshlet.triangle_count > 0) {
+    meshlets.push_back(meshlet);
+  }
+
+  for (Meshlet& built_meshlet : meshlets) {
+    built_meshlet.bounds =
+        ComputeMeshletBounds(vertices, indices, built_meshlet.first_triangle, built_meshlet.triangle_count);
+  }
+  return meshlets;
+}
+
+MeshletBounds ComputeMeshletBounds(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                   uint32_t first_triangle, uint32_t triangle_count) {
+  MeshletBounds bounds{};
+
+  // Sphere around the center of the bounding box, close to minimal for compact meshlets
+  glm::vec3 min{std::numeric_limits<float>::max()};
+  glm::vec3 max{std::numeric_limits<float>::lowest()};
+  for (uint32_t i = 3 * first_triangle; i < 3 * (first_triangle + triangle_count); ++i) {
+    min = glm::min(min, vertices[indices[i]].position);
+    max = glm::max(max, vertices[indices[i]].position);
+  }
+  bounds.center = (min + max) * 0.5f;
+  for (uint32_t i = 3 * first_triangle; i < 3 * (first_triangle + triangle_count); ++i) {
+    bounds.radius = std::max(bounds.radius, glm::length(vertices[indices[i]].position - bounds.center));
+  }
+
+  // Normal cone around the mean face normal
+  std::vector<glm::vec3> normals;
+  normals.reserve(triangle_count);
+  glm::vec3 normal_sum{0.0f};
+  for (uint32_t triangle = first_triangle; triangle < first_triangle + triangle_count; ++triangle) {
+    const glm::vec3 p0 = vertices[indices[3 * triangle + 0]].position;
+    const glm::vec3 p1 = vertices[indices[3 * triangle + 1]].position;
+    const glm::vec3 p2 = vertices[indices[3 * triangle + 2]].position;
+    const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+    const float length = glm::length(normal);
+    if (length > 0.0f) {
+      normals.push_back(normal / length);
+      normal_sum += normals.back();
+    }
+  }
+  const float normal_sum_length = glm::length(normal_sum);
+  if (normals.empty() || normal_sum_length == 0.0f) {
+    return bounds;
+  }
+  bounds.cone_axis = normal_sum / normal_sum_length;
+  float min_cosine = 1.0f;
+  for (const glm::vec3& normal : normals) {
+    min_cosine = std::min(min_cosine, glm::dot(normal, bounds.cone_axis));
+  }
+  // Cones wider than a hemisphere are never entirely backfacing
+  bounds.cone_cutoff = min_cosine <= 0.0f ? 1.0f : std::sqrt(1.0f - min_cosine * min_cosine);
+  return bounds;
+}
+}  // namespace engine
@@ -1,20 +1,131 @@
 #include "engine/model.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
+#include <system_error>
 #include <unordered_map>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
+#include "engine/index_codec.h"
+#include "engine/mesh_optimizer.h"
+
+namespace {
+// Parsed and optimized OBJ geometry stored next to the source file: the header, the vertices as is and the compressed
+// indices
+struct MeshCacheHeader {
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  uint32_t vertex_count = 0;
+  uint32_t index_count = 0;
+  uint64_t encoded_index_size = 0;
+};
+constexpr uint32_t kMeshCacheMagic = 0x434D5056;  // "VPMC"
+constexpr uint32_t kMeshCacheVersion = 2;
+
+struct MeshData {
+  std::vector<engine::Vertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+std::filesystem::path GetMeshCachePath(const std::filesystem::path& file_path) {
+  std::filesystem::path cache_path = file_path;
+  cache_path += ".meshcache";
+  return cache_path;
+}
+
+// Reads what follows the header, throws if the sizes or the indices are inconsistent with the file or each other
+MeshData ReadMeshData(std::ifstream& file, const MeshCacheHeader& header, uint64_t file_size) {
+  if (header.vertex_count == 0 || header.index_count == 0) {
+    throw std::runtime_error{"Empty mesh!"};
+  }
+  // Checked before anything is allocated by the sizes
+  const uint64_t vertex_size = sizeof(engine::Vertex) * static_cast<uint64_t>(header.vertex_count);
+  if (file_size < sizeof(header) + vertex_size ||
+      file_size - sizeof(header) - vertex_size != header.encoded_index_size) {
+    throw std::runtime_error{"Sizes do not match the file size!"};
+  }
+
+  MeshData mesh_data;
+  mesh_data.vertices.resize(header.vertex_count);
+  std::vector<uint8_t> encoded_indices(header.encoded_index_size);
+  if (!file.read(reinterpret_cast<char*>(mesh_data.vertices.data()), static_cast<std::streamsize>(vertex_size)) ||
+      !file.read(reinterpret_cast<char*>(encoded_indices.data()),
+                 static_cast<std::streamsize>(encoded_indices.size()))) {
+    throw std::runtime_error{"Failed to read the file!"};
+  }
+  mesh_data.indices = engine::DecodeIndices(encoded_indices.data(), encoded_indices.size(), header.index_count);
+  // Well-formed index data may still refer to vertices that don't exist, e.g. through edges never pushed
+  if (std::any_of(mesh_data.indices.begin(), mesh_data.indices.end(),
+                  [&](uint32_t index) { return index >= header.vertex_count; })) {
+    throw std::runtime_error{"Index out of range!"};
+  }
+  return mesh_data;
+}
+
+// Null if there is no cache, it is older than the source file or it is invalid, in which case the OBJ is parsed again
+std::optional<MeshData> ReadMeshCache(const std::filesystem::path& file_path) {
+  const std::filesystem::path cache_path = GetMeshCachePath(file_path);
+  std::error_code cache_error_code, file_error_code, size_error_code;
+  const auto cache_time = std::filesystem::last_write_time(cache_path, cache_error_code);
+  const auto file_time = std::filesystem::last_write_time(file_path, file_error_code);
+  const auto cache_size = std::filesystem::file_size(cache_path, size_error_code);
+  if (cache_error_code || file_error_code || size_error_code || cache_time < file_time) {
+    return std::nullopt;
+  }
+
+  std::ifstream file{cache_path, std::ios::binary};
+  MeshCacheHeader header{};
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != kMeshCacheMagic ||
+      header.version != kMeshCacheVersion) {
+    return std::nullopt;
+  }
+  try {
+    return ReadMeshData(file, header, cache_size);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Ignoring mesh cache " << cache_path << ": " << e.what() << std::endl;
+    return std::nullopt;
+  }
+}
+
+// Best effort, e.g. the asset directory may be read-only
+void WriteMeshCache(const std::filesystem::path& file_path, const MeshData& mesh_data) {
+  const std::vector<uint8_t> encoded_indices = engine::EncodeIndices(mesh_data.indices);
+  const MeshCacheHeader header{
+      .magic = kMeshCacheMagic,
+      .version = kMeshCacheVersion,
+      .vertex_count = static_cast<uint32_t>(mesh_data.vertices.size()),
+      .index_count = static_cast<uint32_t>(mesh_data.indices.size()),
+      .encoded_index_size = encoded_indices.size(),
+  };
+  std::ofstream file{GetMeshCachePath(file_path), std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(mesh_data.vertices.data()),
+             static_cast<std::streamsize>(sizeof(engine::Vertex) * mesh_data.vertices.size()));
+  file.write(reinterpret_cast<const char*>(encoded_indices.data()),
+             static_cast<std::streamsize>(encoded_indices.size()));
+}
+}  // namespace
+
 namespace engine {
-void ModelLoader::Load(Device& device, const std::filesystem::path& file_path) {
+void ModelLoader::Load(MeshManager& mesh_manager, UploadBatch& upload_batch, const std::filesystem::path& file_path,
+                       const MeshOptions& options) {
   assert(file_path.has_filename());
   assert(file_path.has_extension());
   assert(file_path.extension() == ".obj");
 
+  if (std::optional<MeshData> mesh_data = ReadMeshCache(file_path)) {
+    mesh = mesh_manager.Add(
+        Mesh{mesh_manager.GetDevice(), upload_batch, mesh_data->vertices, mesh_data->indices, options});
+    return;
+  }
+
   tinyobj::ObjReaderConfig reader_config;
   reader_config.mtl_search_path = file_path.parent_path().string();  // Path to material files
 
@@ -34,8 +145,9 @@ void ModelLoader::Load(Device& device, const std::filesystem::path& file_path) {
   const auto& shapes = reader.GetShapes();
   const auto& materials = reader.GetMaterials();
 
-  std::vector<Vertex> vertices;
-  std::vector<uint32_t> indices;
+  MeshData mesh_data;
+  std::vector<Vertex>& vertices = mesh_data.vertices;
+  std::vector<uint32_t>& indices = mesh_data.indices;
   std::unordered_map<Vertex, uint32_t> unique_vertices{};
   for (const auto& shape : shapes) {
     for (const auto& index : shape.mesh.indices) {
@@ -74,28 +186,52 @@ void ModelLoader::Load(Device& device, const std::filesystem::path& file_path) {
     }
   }
 
-  mesh = std::make_unique<Mesh>(device, vertices, indices);
+  [[maybe_unused]] const MeshOptimizationStatistics statistics = OptimizeMesh(vertices, indices);
+#ifdef ENABLE_VALIDATION_LAYERS
+  std::cout << file_path.filename().string() << ": ";
+  LogMeshOptimizationStatistics(std::cout, statistics);
+#endif
+  WriteMeshCache(file_path, mesh_data);
+  mesh = mesh_manager.Add(Mesh{mesh_manager.GetDevice(), upload_batch, vertices, indices, options});
 }
 
-std::unique_ptr<Model> Model::CreateFromFile(Device& device, const std::filesystem::path& file_path) {
+Model Model::CreateFromFile(MeshManager& mesh_manager, const std::filesystem::path& file_path,
+                            const MeshOptions& options) {
+  UploadBatch upload_batch{mesh_manager.GetDevice()};
+  Model model = CreateFromFile(mesh_manager, upload_batch, file_path, options);
+  upload_batch.Submit();
+  return model;
+}
+
+Model Model::CreateFromFile(MeshManager& mesh_manager, UploadBatch& upload_batch,
+                            const std::filesystem::path& file_path, const MeshOptions& options) {
   ModelLoader model_loader{};
-  model_loader.Load(device, file_path);
-  auto model = std::make_unique<Model>();
-  model->AttachMesh(std::move(model_loader.mesh));
+  model_loader.Load(mesh_manager, upload_batch, file_path, options);
+  Model model;
+  model.AttachMesh(model_loader.mesh);
   return model;
 }
 
-void Model::Bind(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) const {
-  assert(mesh_);
-  mesh_->Bind(command_buffer);
-  if (texture_) {
-    texture_->Bind(command_buffer, pipeline_layout);
+std::optional<Bounds> Model::GetWorldBounds(const MeshManager& mesh_manager) const {
+  const Mesh* mesh = mesh_manager.Get(mesh_);
+  if (!mesh) {
+    return std::nullopt;
   }
+  return mesh->GetBounds().Transformed(transform_);
 }
 
-void Model::Draw(VkCommandBuffer command_buffer) const {
-  assert(mesh_);
-  mesh_->Draw(command_buffer);
+std::optional<RayHit> Model::Intersect(const MeshManager& mesh_manager, const Ray& ray) const {
+  const Mesh* mesh = mesh_manager.Get(mesh_);
+  if (!mesh || !mesh->GetBvh()) {
+    return std::nullopt;
+  }
+  // Into the mesh's space, scaling the direction too keeps t the same in both spaces
+  const Ray mesh_ray{
+      .origin = (ray.origin - transform_.translation) / transform_.scale,
+      .direction = ray.direction / transform_.scale,
+      .max_t = ray.max_t,
+  };
+  return mesh->GetBvh()->Intersect(mesh_ray);
 }
 
 }  // namespace engine
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "engine/planet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "engine/thread_pool.h"
+#include "engine/upload_batch.h"
+
+namespace {
+// Split patches merge only once the camera is this much further than the split distance
+constexpr float kMergeHysteresis = 1.25f;
+// Skirt depth relative to the patch size, enough to cover the cracks between neighbouring levels
+constexpr float kSkirtDepth = 0.02f;
+
+// Edge length of the patch on the [-1, 1] cube
+float GetPatchSize(const engine::CubeSpherePatch& patch) {
+  return 2.0f / static_cast<float>(1u << patch.level);
+}
+}  // namespace
+
+namespace engine {
+Planet::Planet(MeshManager& mesh_manager, SlotMap<Model>& models, TextureHandle texture, const Transform& transform,
+               const PlanetInfo& info)
+    : mesh_manager_{mesh_manager}, models_{models}, texture_{texture}, transform_{transform}, info_{info} {
+  assert(info_.patch_resolution >= 2 && info_.max_patch_updates > 0);
+  for (uint32_t face = 0; face < 6; ++face) {
+    roots_[face] = std::make_unique<Node>(Node{.patch = {.face = face}});
+  }
+}
+
+Planet::~Planet() {
+  for (std::unique_ptr<Node>& root : roots_) {
+    DestroyChildren(*root);
+    Hide(*root);
+    mesh_manager_.Remove(root->mesh);
+  }
+}
+
+void Planet::Update(const glm::vec3& camera_position) {
+  // The patches are generated on the unit sphere
+  const glm::vec3 local_camera_position = (camera_position - transform_.translation) / transform_.scale;
+
+  pending_nodes_.clear();
+  drawn_patch_count_ = 0;
+  drawn_triangle_count_ = 0;
+  for (std::unique_ptr<Node>& root : roots_) {
+    UpdateNode(*root, local_camera_position);
+  }
+  if (!pending_nodes_.empty()) {
+    GeneratePendingNodes(local_camera_position);
+  }
+}
+
+void Planet::UpdateNode(Node& node, const glm::vec3& camera_position) {
+  if (node.mesh.IsNull()) {
+    pending_nodes_.push_back(&node);
+    return;
+  }
+  if (!ShouldSplit(node.patch, node.center, node.radius, node.children[0] != nullptr, camera_position, info_)) {
+    DestroyChildren(node);
+    Show(node);
+    return;
+  }
+
+  if (!node.children[0]) {
+    for (uint32_t i = 0; i < 4; ++i) {
+      const CubeSpherePatch child_patch{
+          .face = node.patch.face,
+          .level = node.patch.level + 1,
+          .x = 2 * node.patch.x + i % 2,
+          .y = 2 * node.patch.y + i / 2,
+      };
+      // The parent's bounds stand in until the child is generated
+      node.children[i] =
+          std::make_unique<Node>(Node{.patch = child_patch, .center = node.center, .radius = node.radius});
+    }
+  }
+  // The node stands in for its children until all of them can be drawn
+  if (std::any_of(node.children.begin(), node.children.end(),
+                  [](const std::unique_ptr<Node>& child) { return child->mesh.IsNull(); })) {
+    for (std::unique_ptr<Node>& child : node.children) {
+      if (child->mesh.IsNull()) {
+        pending_nodes_.push_back(child.get());
+      }
+    }
+    Show(node);
+    return;
+  }
+  Hide(node);
+  for (std::unique_ptr<Node>& child : node.children) {
+    UpdateNode(*child, camera_position);
+  }
+}
+
+bool Planet::IsBehindHorizon(const glm::vec3& center, float radius, const glm::vec3& camera_position) {
+  // A point p of the unit sphere is behind the horizon if dot(p, camera) < 1, tested conservatively for the bounds
+  const float camera_distance = glm::length(camera_position);
+  return camera_distance > 1.0f && glm::dot(center, camera_position) + radius * camera_distance < 1.0f;
+}
+
+bool Planet::ShouldSplit(const CubeSpherePatch& patch, const glm::vec3& center, float radius, bool split,
+                         const glm::vec3& camera_position, const PlanetInfo& info) {
+  if (patch.level >= info.max_level || IsBehindHorizon(center, radius, camera_position)) {
+    return false;
+  }
+  const float distance = std::max(glm::length(camera_position - center) - radius, 0.0f);
+  const float hysteresis = split ? kMergeHysteresis : 1.0f;
+  return distance < info.split_distance * GetPatchSize(patch) * hysteresis;
+}
+
+void Planet::GeneratePendingNodes(const glm::vec3& camera_position) {
+  // Coarse patches first as they unblock the most, then the closest
+  std::sort(pending_nodes_.begin(), pending_nodes_.end(), [&](const Node* lhs, const Node* rhs) {
+    if (lhs->patch.level != rhs->patch.level) {
+      return lhs->patch.level < rhs->patch.level;
+    }
+    return glm::length(lhs->center - camera_position) < glm::length(rhs->center - camera_position);
+  });
+
+  // Uploads what was generated since the last frame, within the budget
+  UploadBatch upload_batch{mesh_manager_.GetDevice()};
+  uint32_t upload_count = 0;
+  uint32_t generating_count = 0;
+  for (Node* node : pending_nodes_) {
+    if (!node->geometry) {
+      continue;
+    }
+    if (!node->geometry->ready.load(std::memory_order_acquire)) {
+      ++generating_count;
+      continue;
+    }
+    if (upload_count == info_.max_patch_updates) {
+      continue;
+    }
+    const PatchGeometry& geometry = *node->geometry;
+    node->triangle_count = static_cast<uint32_t>(geometry.indices.size() / 3);
+    node->mesh = mesh_manager_.Add(
+        Mesh{mesh_manager_.GetDevice(), upload_batch, geometry.vertices, geometry.indices, info_.mesh_options});
+    const BoundingSphere& sphere = mesh_manager_.Get(node->mesh)->GetBounds().sphere;
+    node->center = sphere.center;
+    node->radius = sphere.radius;
+    node->geometry.reset();
+    ++upload_count;
+  }
+  if (upload_count > 0) {
+    upload_batch.Submit();
+  }
+
+  // Nodes destroyed while generating leave their jobs running, those aren't counted against the budget
+  for (Node* node : pending_nodes_) {
+    if (generating_count == info_.max_patch_updates) {
+      break;
+    }
+    if (node->geometry) {
+      continue;
+    }
+    node->geometry = std::make_shared<PatchGeometry>();
+    ThreadPool::Get().Submit([patch = node->patch, resolution = info_.patch_resolution, geometry = node->geometry] {
+      Mesh::GenerateSpherePatch(patch, resolution, kSkirtDepth * GetPatchSize(patch), geometry->vertices,
+                                geometry->indices);
+      geometry->ready.store(true, std::memory_order_release);
+    });
+    ++generating_count;
+  }
+}
+
+void Planet::Show(Node& node) {
+  ++drawn_patch_count_;
+  drawn_triangle_count_ += node.triangle_count;
+  if (!node.model.IsNull()) {
+    return;
+  }
+  Model model;
+  model.AttachMesh(node.mesh);
+  model.AttachTexture(texture_);
+  model.GetTransform() = transform_;
+  node.model = models_.Insert(std::move(model));
+}
+
+void Planet::Hide(Node& node) {
+  if (!node.model.IsNull()) {
+    models_.Remove(node.model);
+    node.model = {};
+  }
+}
+
+void Planet::DestroyChildren(Node& node) {
+  for (std::unique_ptr<Node>& child : node.children) {
+    if (!child) {
+      continue;
+    }
+    DestroyChildren(*child);
+    Hide(*child);
+    // Removed meshes are released once in-flight frames are done with them
+    mesh_manager_.Remove(child->mesh);
+    child.reset();
+  }
+}
+}  // namespace engine
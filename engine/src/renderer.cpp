@@ -7,14 +7,18 @@ namespace engine {
 Renderer::Renderer(Window& window, Device& device) : window_{window}, device_{device} {
   swap_chain_ = std::make_unique<Swapchain>(device_, window_.GetExtent());
   AllocateCommandBuffers();
+  CreateSynchronizationObjects();
 }
 
 Renderer::~Renderer() {
+  DestroySynchronizationObjects();
   FreeCommandBuffers();
 }
 
 VkCommandBuffer Renderer::BeginFrame() {
-  auto image_acquire_result = swap_chain_->AcquireNextImage(&image_index_);
+  vkWaitForFences(device_.GetHandle(), 1, &in_flight_fences_[frame_index_], VK_TRUE, UINT64_MAX);
+
+  auto image_acquire_result = swap_chain_->AcquireNextImage(image_available_semaphores_[frame_index_], &image_index_);
   if (image_acquire_result == VK_ERROR_OUT_OF_DATE_KHR) {
     // Should we recreate swapchain if VK_SUBOPTIMAL_KHR is returned? For now, ignore.
     RecreateSwapchain();
@@ -22,6 +26,16 @@ VkCommandBuffer Renderer::BeginFrame() {
   } else if (image_acquire_result != VK_SUCCESS && image_acquire_result != VK_SUBOPTIMAL_KHR) {
     throw std::runtime_error{"Failed to acquire swap chain image!"};
   }
+  // Only reset once work is certain to be submitted, the fence is waited on again otherwise
+  vkResetFences(device_.GetHandle(), 1, &in_flight_fences_[frame_index_]);
+
+  // The fence guarantees that the frame that last used this slot has completed
+  ++frame_number_;
+  DeletionQueue& deletion_queue = device_.GetDeletionQueue();
+  if (frame_number_ > Swapchain::kMaxFramesInFlight) {
+    deletion_queue.Retire(frame_number_ - Swapchain::kMaxFramesInFlight);
+  }
+  deletion_queue.BeginFrame(frame_number_);
 
   auto command_buffer = GetCurrentCommandBuffer();
   VkCommandBufferBeginInfo command_buffer_begin_info{};
@@ -75,13 +89,35 @@ void Renderer::EndFrame() {
   if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to record command buffer!"};
   }
-  auto submit_and_present_result = swap_chain_->SubmitAndPresent(command_buffer, image_index_);
-  if (submit_and_present_result == VK_ERROR_OUT_OF_DATE_KHR || submit_and_present_result == VK_SUBOPTIMAL_KHR ||
-      window_.HasResized()) {
+
+  VkSubmitInfo submit_info{};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+  // Wait until the image is available...
+  submit_info.waitSemaphoreCount = 1;
+  submit_info.pWaitSemaphores = &image_available_semaphores_[frame_index_];
+
+  // ...at the end of the pipeline.
+  std::array<VkPipelineStageFlags, 1> wait_stages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+  submit_info.pWaitDstStageMask = wait_stages.data();
+
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer;
+
+  // Signal that the image is ready to be presented.
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &render_finished_semaphores_[frame_index_];
+
+  if (vkQueueSubmit(device_.GetGraphicsQueue(), 1, &submit_info, in_flight_fences_[frame_index_]) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to submit command buffer!"};
+  }
+
+  auto present_result = swap_chain_->Present(render_finished_semaphores_[frame_index_], image_index_);
+  if (present_result == VK_ERROR_OUT_OF_DATE_KHR || present_result == VK_SUBOPTIMAL_KHR || window_.HasResized()) {
     window_.ResetResizedFlag();
     RecreateSwapchain();
-  } else if (submit_and_present_result != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to submit command buffer and present swap chain image!"};
+  } else if (present_result != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to present swap chain image!"};
   }
 
   frame_index_ = (frame_index_ + 1) % Swapchain::kMaxFramesInFlight;
@@ -105,6 +141,33 @@ void Renderer::FreeCommandBuffers() {
                        command_buffers_.data());
 }
 
+void Renderer::CreateSynchronizationObjects() {
+  VkSemaphoreCreateInfo semaphore_info{};
+  semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+  VkFenceCreateInfo fence_info{};
+  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+  for (uint32_t i = 0; i < Swapchain::kMaxFramesInFlight; ++i) {
+    if (vkCreateSemaphore(device_.GetHandle(), &semaphore_info, nullptr, &image_available_semaphores_[i]) !=
+            VK_SUCCESS ||
+        vkCreateSemaphore(device_.GetHandle(), &semaphore_info, nullptr, &render_finished_semaphores_[i]) !=
+            VK_SUCCESS ||
+        vkCreateFence(device_.GetHandle(), &fence_info, nullptr, &in_flight_fences_[i]) != VK_SUCCESS) {
+      throw std::runtime_error{"Failed to create synchronization objects!"};
+    }
+  }
+}
+
+void Renderer::DestroySynchronizationObjects() {
+  for (uint32_t i = 0; i < Swapchain::kMaxFramesInFlight; ++i) {
+    vkDestroySemaphore(device_.GetHandle(), image_available_semaphores_[i], nullptr);
+    vkDestroySemaphore(device_.GetHandle(), render_finished_semaphores_[i], nullptr);
+    vkDestroyFence(device_.GetHandle(), in_flight_fences_[i], nullptr);
+  }
+}
+
 void Renderer::RecreateSwapchain() {
   assert(swap_chain_);
   auto extent = window_.GetExtent();
@@ -112,12 +175,11 @@ void Renderer::RecreateSwapchain() {
     extent = window_.GetExtent();
     glfwWaitEvents();
   }
-  vkDeviceWaitIdle(device_.GetHandle());
 
-  if (swap_chain_) {
-    auto old_swap_chain = std::move(swap_chain_);
-    swap_chain_ = std::make_unique<Swapchain>(device_, extent, std::move(old_swap_chain));
-  }
+  // Frames in flight may still render to the old swapchain, retire it instead of waiting for the device to idle
+  std::unique_ptr<Swapchain> old_swap_chain = std::move(swap_chain_);
+  swap_chain_ = std::make_unique<Swapchain>(device_, extent, old_swap_chain.get());
+  device_.GetDeletionQueue().Enqueue([retired_swap_chain = old_swap_chain.release()] { delete retired_swap_chain; });
 }
 
 }  // namespace engine
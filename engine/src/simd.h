@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+// Defining ENGINE_SIMD_SCALAR selects the portable fallback whatever the target, e.g. to test it on x86
+#if defined(ENGINE_SIMD_SCALAR)
+#elif defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Thin wrappers over the target's float vectors, for kernels written once against them. Floats4 has four lanes on
+// every target, e.g. for structures of arrays laid out in fours. Floats is the widest vector of the target. Comparisons
+// give masks with all bits set in the lanes where they hold. Min and Max return the second operand if either is NaN,
+// like SSE, except on NEON where they return NaN.
+namespace engine::simd {
+#if defined(ENGINE_SIMD_SCALAR) || !(defined(__SSE2__) || defined(__ARM_NEON))
+struct Floats4 {
+  static constexpr uint32_t kWidth = 4;
+  std::array<float, 4> v;
+
+  static Floats4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+  static Floats4 Broadcast(float f) { return {{f, f, f, f}}; }
+  void Store(float* p) const { std::copy(v.begin(), v.end(), p); }
+
+  friend Floats4 operator+(Floats4 a, Floats4 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+  friend Floats4 operator-(Floats4 a, Floats4 b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+  friend Floats4 operator*(Floats4 a, Floats4 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+  friend Floats4 operator/(Floats4 a, Floats4 b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+  friend Floats4 operator&(Floats4 a, Floats4 b) {
+    return Map(a, b, [](float x, float y) { return FromBits(ToBits(x) & ToBits(y)); });
+  }
+  friend Floats4 operator^(Floats4 a, Floats4 b) {
+    return Map(a, b, [](float x, float y) { return FromBits(ToBits(x) ^ ToBits(y)); });
+  }
+  friend Floats4 Sqrt(Floats4 a) { return Map(a, a, [](float x, float) { return std::sqrt(x); }); }
+  friend Floats4 Min(Floats4 a, Floats4 b) { return Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+  friend Floats4 Max(Floats4 a, Floats4 b) { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+  friend Floats4 Greater(Floats4 a, Floats4 b) { return Map(a, b, [](float x, float y) { return ToMask(x > y); }); }
+  friend Floats4 LessEqual(Floats4 a, Floats4 b) { return Map(a, b, [](float x, float y) { return ToMask(x <= y); }); }
+  friend Floats4 GreaterEqual(Floats4 a, Floats4 b) {
+    return Map(a, b, [](float x, float y) { return ToMask(x >= y); });
+  }
+  // All bits set in the lanes whose sign bit is set, e.g. -0
+  friend Floats4 Negative(Floats4 a) { return Map(a, a, [](float x, float) { return ToMask(std::signbit(x)); }); }
+  // Lanes of a where the mask is set, b elsewhere
+  friend Floats4 Select(Floats4 mask, Floats4 a, Floats4 b) {
+    Floats4 result;
+    for (uint32_t i = 0; i < 4; ++i) {
+      const uint32_t m = ToBits(mask.v[i]);
+      result.v[i] = FromBits((m & ToBits(a.v[i])) | (~m & ToBits(b.v[i])));
+    }
+    return result;
+  }
+  // Bit i is set if lane i of the mask is
+  friend uint32_t MoveMask(Floats4 mask) {
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+      bits |= (ToBits(mask.v[i]) >> 31) << i;
+    }
+    return bits;
+  }
+
+  template <typename Operation>
+  static Floats4 Map(Floats4 a, Floats4 b, Operation operation) {
+    return {{operation(a.v[0], b.v[0]), operation(a.v[1], b.v[1]), operation(a.v[2], b.v[2]),
+             operation(a.v[3], b.v[3])}};
+  }
+  static uint32_t ToBits(float f) { return std::bit_cast<uint32_t>(f); }
+  static float FromBits(uint32_t bits) { return std::bit_cast<float>(bits); }
+  static float ToMask(bool b) { return FromBits(b ? ~0u : 0u); }
+};
+#elif defined(__SSE2__)
+struct Floats4 {
+  static constexpr uint32_t kWidth = 4;
+  __m128 v;
+
+  static Floats4 Load(const float* p) { return {_mm_loadu_ps(p)}; }
+  static Floats4 Broadcast(float f) { return {_mm_set1_ps(f)}; }
+  void Store(float* p) const { _mm_storeu_ps(p, v); }
+
+  friend Floats4 operator+(Floats4 a, Floats4 b) { return {_mm_add_ps(a.v, b.v)}; }
+  friend Floats4 operator-(Floats4 a, Floats4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+  friend Floats4 operator*(Floats4 a, Floats4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+  friend Floats4 operator/(Floats4 a, Floats4 b) { return {_mm_div_ps(a.v, b.v)}; }
+  friend Floats4 operator&(Floats4 a, Floats4 b) { return {_mm_and_ps(a.v, b.v)}; }
+  friend Floats4 operator^(Floats4 a, Floats4 b) { return {_mm_xor_ps(a.v, b.v)}; }
+  friend Floats4 Sqrt(Floats4 a) { return {_mm_sqrt_ps(a.v)}; }
+  friend Floats4 Min(Floats4 a, Floats4 b) { return {_mm_min_ps(a.v, b.v)}; }
+  friend Floats4 Max(Floats4 a, Floats4 b) { return {_mm_max_ps(a.v, b.v)}; }
+  friend Floats4 Greater(Floats4 a, Floats4 b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+  friend Floats4 LessEqual(Floats4 a, Floats4 b) { return {_mm_cmple_ps(a.v, b.v)}; }
+  friend Floats4 GreaterEqual(Floats4 a, Floats4 b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+  friend Floats4 Negative(Floats4 a) { return {_mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(a.v), 31))}; }
+  friend Floats4 Select(Floats4 mask, Floats4 a, Floats4 b) {
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+  }
+  friend uint32_t MoveMask(Floats4 mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask.v)); }
+};
+#elif defined(__ARM_NEON)
+struct Floats4 {
+  static constexpr uint32_t kWidth = 4;
+  float32x4_t v;
+
+  static Floats4 Load(const float* p) { return {vld1q_f32(p)}; }
+  static Floats4 Broadcast(float f) { return {vdupq_n_f32(f)}; }
+  void Store(float* p) const { vst1q_f32(p, v); }
+
+  friend Floats4 operator+(Floats4 a, Floats4 b) { return {vaddq_f32(a.v, b.v)}; }
+  friend Floats4 operator-(Floats4 a, Floats4 b) { return {vsubq_f32(a.v, b.v)}; }
+  friend Floats4 operator*(Floats4 a, Floats4 b) { return {vmulq_f32(a.v, b.v)}; }
+  friend Floats4 operator/(Floats4 a, Floats4 b) { return {vdivq_f32(a.v, b.v)}; }
+  friend Floats4 operator&(Floats4 a, Floats4 b) {
+    return {vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};
+  }
+  friend Floats4 operator^(Floats4 a, Floats4 b) {
+    return {vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};
+  }
+  friend Floats4 Sqrt(Floats4 a) { return {vsqrtq_f32(a.v)}; }
+  friend Floats4 Min(Floats4 a, Floats4 b) { return {vminq_f32(a.v, b.v)}; }
+  friend Floats4 Max(Floats4 a, Floats4 b) { return {vmaxq_f32(a.v, b.v)}; }
+  friend Floats4 Greater(Floats4 a, Floats4 b) { return {vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))}; }
+  friend Floats4 LessEqual(Floats4 a, Floats4 b) { return {vreinterpretq_f32_u32(vcleq_f32(a.v, b.v))}; }
+  friend Floats4 GreaterEqual(Floats4 a, Floats4 b) { return {vreinterpretq_f32_u32(vcgeq_f32(a.v, b.v))}; }
+  friend Floats4 Negative(Floats4 a) {
+    return {vreinterpretq_f32_s32(vshrq_n_s32(vreinterpretq_s32_f32(a.v), 31))};
+  }
+  friend Floats4 Select(Floats4 mask, Floats4 a, Floats4 b) {
+    return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)};
+  }
+  friend uint32_t MoveMask(Floats4 mask) {
+    const int32x4_t shifts{0, 1, 2, 3};
+    return vaddvq_u32(vshlq_u32(vshrq_n_u32(vreinterpretq_u32_f32(mask.v), 31), shifts));
+  }
+};
+#endif
+
+#if defined(__AVX2__) && !defined(ENGINE_SIMD_SCALAR)
+struct Floats8 {
+  static constexpr uint32_t kWidth = 8;
+  __m256 v;
+
+  static Floats8 Load(const float* p) { return {_mm256_loadu_ps(p)}; }
+  static Floats8 Broadcast(float f) { return {_mm256_set1_ps(f)}; }
+  void Store(float* p) const { _mm256_storeu_ps(p, v); }
+
+  friend Floats8 operator+(Floats8 a, Floats8 b) { return {_mm256_add_ps(a.v, b.v)}; }
+  friend Floats8 operator-(Floats8 a, Floats8 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+  friend Floats8 operator*(Floats8 a, Floats8 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+  friend Floats8 operator/(Floats8 a, Floats8 b) { return {_mm256_div_ps(a.v, b.v)}; }
+  friend Floats8 operator&(Floats8 a, Floats8 b) { return {_mm256_and_ps(a.v, b.v)}; }
+  friend Floats8 operator^(Floats8 a, Floats8 b) { return {_mm256_xor_ps(a.v, b.v)}; }
+  friend Floats8 Sqrt(Floats8 a) { return {_mm256_sqrt_ps(a.v)}; }
+  friend Floats8 Min(Floats8 a, Floats8 b) { return {_mm256_min_ps(a.v, b.v)}; }
+  friend Floats8 Max(Floats8 a, Floats8 b) { return {_mm256_max_ps(a.v, b.v)}; }
+  friend Floats8 Greater(Floats8 a, Floats8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+  friend Floats8 LessEqual(Floats8 a, Floats8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+  friend Floats8 GreaterEqual(Floats8 a, Floats8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+  friend Floats8 Negative(Floats8 a) {
+    return {_mm256_castsi256_ps(_mm256_srai_epi32(_mm256_castps_si256(a.v), 31))};
+  }
+  friend Floats8 Select(Floats8 mask, Floats8 a, Floats8 b) { return {_mm256_blendv_ps(b.v, a.v, mask.v)}; }
+  friend uint32_t MoveMask(Floats8 mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask.v)); }
+};
+
+using Floats = Floats8;
+#else
+using Floats = Floats4;
+#endif
+}  // namespace engine::simd
@@ -0,0 +1,127 @@
+#include "engine/sphere_math.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "simd.h"
+
+namespace engine::sphere_math {
+namespace {
+using simd::Floats;
+
+// atan(a) for a in [0, 1], Abramowitz & Stegun 4.4.49 (error below 2e-8 before float rounding)
+Floats AtanUnit(Floats a) {
+  const Floats a2 = a * a;
+  Floats p = Floats::Broadcast(0.0028662257f);
+  p = p * a2 + Floats::Broadcast(-0.0161657367f);
+  p = p * a2 + Floats::Broadcast(0.0429096138f);
+  p = p * a2 + Floats::Broadcast(-0.0752896400f);
+  p = p * a2 + Floats::Broadcast(0.1065626393f);
+  p = p * a2 + Floats::Broadcast(-0.1420889944f);
+  p = p * a2 + Floats::Broadcast(0.1999355085f);
+  p = p * a2 + Floats::Broadcast(-0.3333314528f);
+  p = p * a2 + Floats::Broadcast(1.0f);
+  return p * a;
+}
+
+// Matches std::atan2, including signed zeros, apart from non-finite inputs
+Floats Atan2(Floats y, Floats x) {
+  const Floats sign_bit = Floats::Broadcast(-0.0f);
+  const Floats y_sign = y & sign_bit;
+  const Floats abs_y = y ^ y_sign;
+  const Floats abs_x = x ^ (x & sign_bit);
+
+  // Reduce to [0, 1], atan(0 / 0) is taken as zero
+  const Floats numerator = Min(abs_x, abs_y);
+  const Floats denominator = Max(Max(abs_x, abs_y), Floats::Broadcast(std::numeric_limits<float>::min()));
+  Floats angle = AtanUnit(numerator / denominator);
+
+  angle = Select(Greater(abs_y, abs_x), Floats::Broadcast(glm::half_pi<float>()) - angle, angle);
+  angle = Select(Negative(x), Floats::Broadcast(glm::pi<float>()) - angle, angle);
+  return angle ^ y_sign;
+}
+
+// Runs a kernel over whole batches, the tail is padded with zeros to a full batch
+template <size_t kInputCount, size_t kOutputCount, typename Kernel>
+void RunBatches(const std::array<const float*, kInputCount>& inputs, const std::array<float*, kOutputCount>& outputs,
+                uint32_t count, Kernel kernel) {
+  std::array<Floats, kInputCount> in;
+  uint32_t i = 0;
+  for (; i + Floats::kWidth <= count; i += Floats::kWidth) {
+    for (size_t j = 0; j < kInputCount; ++j) {
+      in[j] = Floats::Load(inputs[j] + i);
+    }
+    const std::array<Floats, kOutputCount> out = kernel(in);
+    for (size_t j = 0; j < kOutputCount; ++j) {
+      out[j].Store(outputs[j] + i);
+    }
+  }
+  if (i == count) {
+    return;
+  }
+
+  const uint32_t tail_count = count - i;
+  std::array<float, Floats::kWidth> tail{};
+  for (size_t j = 0; j < kInputCount; ++j) {
+    std::copy_n(inputs[j] + i, tail_count, tail.begin());
+    in[j] = Floats::Load(tail.data());
+  }
+  const std::array<Floats, kOutputCount> out = kernel(in);
+  for (size_t j = 0; j < kOutputCount; ++j) {
+    out[j].Store(tail.data());
+    std::copy_n(tail.begin(), tail_count, outputs[j] + i);
+  }
+}
+}  // namespace
+
+glm::vec3 CubeToSphere(glm::vec3 cube_point) {
+  const glm::vec3 p2 = cube_point * cube_point;
+  const float x = cube_point.x * sqrt(1 - (p2.y + p2.z) / 2 + (p2.y * p2.z) / 3);
+  const float y = cube_point.y * sqrt(1 - (p2.x + p2.z) / 2 + (p2.x * p2.z) / 3);
+  const float z = cube_point.z * sqrt(1 - (p2.x + p2.y) / 2 + (p2.x * p2.y) / 3);
+  return {x, y, z};
+}
+
+glm::vec2 SphereToUV(glm::vec3 sphere_point) {
+  const float u = 0.5f + atan2(sphere_point.z, sphere_point.x) / (2 * glm::pi<float>());
+  const float v = 0.5f - asin(sphere_point.y) / glm::pi<float>();
+  return {-u, v};
+}
+
+void CubeToSphere(const float* x, const float* y, const float* z, float* out_x, float* out_y, float* out_z,
+                  uint32_t count) {
+  RunBatches<3, 3>({x, y, z}, {out_x, out_y, out_z}, count, [](const std::array<Floats, 3>& p) {
+    const Floats one = Floats::Broadcast(1.0f);
+    const Floats half = Floats::Broadcast(0.5f);
+    const Floats third = Floats::Broadcast(1.0f / 3.0f);
+    const Floats x2 = p[0] * p[0];
+    const Floats y2 = p[1] * p[1];
+    const Floats z2 = p[2] * p[2];
+    return std::array<Floats, 3>{
+        p[0] * Sqrt(one - (y2 + z2) * half + y2 * z2 * third),
+        p[1] * Sqrt(one - (x2 + z2) * half + x2 * z2 * third),
+        p[2] * Sqrt(one - (x2 + y2) * half + x2 * y2 * third),
+    };
+  });
+}
+
+void SphereToUV(const float* x, const float* y, const float* z, float* out_u, float* out_v, uint32_t count) {
+  RunBatches<3, 2>({x, y, z}, {out_u, out_v}, count, [](const std::array<Floats, 3>& p) {
+    const Floats half = Floats::Broadcast(0.5f);
+    // asin(y) = atan2(y, sqrt(1 - y^2))
+    const Floats cos_latitude = Sqrt(Max(Floats::Broadcast(1.0f) - p[1] * p[1], Floats::Broadcast(0.0f)));
+    const Floats longitude = Atan2(p[2], p[0]);
+    const Floats latitude = Atan2(p[1], cos_latitude);
+    return std::array<Floats, 2>{
+        Floats::Broadcast(-0.5f) - longitude * Floats::Broadcast(0.5f / glm::pi<float>()),
+        half - latitude * Floats::Broadcast(1.0f / glm::pi<float>()),
+    };
+  });
+}
+
+uint32_t GetBatchWidth() {
+  return Floats::kWidth;
+}
+}  // namespace engine::sphere_math
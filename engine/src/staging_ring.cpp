@@ -0,0 +1,241 @@
+#include "engine/staging_ring.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "engine/buffer.h"
+#include "engine/device.h"
+
+namespace {
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+namespace engine {
+StagingRing::StagingRing(Device& device, VkDeviceSize size) : device_{device}, size_{size} {
+  buffer_ = std::make_unique<Buffer>(device_, size_, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                     MemoryCategory::kStaging);
+  if (buffer_->Map() != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to map staging ring!"};
+  }
+  mapped_ = static_cast<uint8_t*>(buffer_->GetMappedMemory());
+}
+
+StagingRing::~StagingRing() {
+  WaitIdle();
+  for (VkFence fence : free_fences_) {
+    vkDestroyFence(device_.GetHandle(), fence, nullptr);
+  }
+  for (VkSemaphore semaphore : free_semaphores_) {
+    vkDestroySemaphore(device_.GetHandle(), semaphore, nullptr);
+  }
+  if (!free_command_buffers_.empty()) {
+    vkFreeCommandBuffers(device_.GetHandle(), device_.GetTransferCommandPool(),
+                         static_cast<uint32_t>(free_command_buffers_.size()), free_command_buffers_.data());
+  }
+  if (!free_acquire_command_buffers_.empty()) {
+    vkFreeCommandBuffers(device_.GetHandle(), device_.GetGraphicsCommandPool(),
+                         static_cast<uint32_t>(free_acquire_command_buffers_.size()),
+                         free_acquire_command_buffers_.data());
+  }
+}
+
+std::optional<StagingRing::Region> StagingRing::TryAcquire(VkDeviceSize size, VkDeviceSize alignment) {
+  Reclaim();
+
+  uint64_t begin = AlignUp(head_, alignment);
+  if (begin % size_ + size > size_) {
+    // Regions never wrap around, skip the tail of the ring
+    begin = AlignUp(begin, size_);
+  }
+  if (begin + size - tail_ > size_) {
+    return std::nullopt;
+  }
+  head_ = begin + size;
+
+  const VkDeviceSize offset = begin % size_;
+  return Region{.buffer = buffer_->GetHandle(), .offset = offset, .size = size, .mapped = mapped_ + offset};
+}
+
+StagingRing::Region StagingRing::Acquire(VkDeviceSize size, VkDeviceSize alignment) {
+  if (size > size_) {
+    throw std::invalid_argument{"Staging region larger than the staging ring!"};
+  }
+  while (true) {
+    if (auto region = TryAcquire(size, alignment)) {
+      return *region;
+    }
+    if (submissions_.empty()) {
+      throw std::runtime_error{"Staging ring is full of unsubmitted regions!"};
+    }
+    Wait(submissions_.front().token);
+  }
+}
+
+void StagingRing::Flush(const Region& region) {
+  buffer_->Flush(region.size, region.offset);
+}
+
+VkCommandBuffer StagingRing::BeginCommands() {
+  VkCommandBuffer command_buffer = BeginCommandBuffer(device_.GetTransferCommandPool(), free_command_buffers_);
+  recording_.emplace_back(command_buffer, head_);
+  return command_buffer;
+}
+
+VkCommandBuffer StagingRing::BeginAcquireCommands() {
+  return BeginCommandBuffer(device_.GetGraphicsCommandPool(), free_acquire_command_buffers_);
+}
+
+uint64_t StagingRing::Submit(VkCommandBuffer command_buffer, VkCommandBuffer acquire_command_buffer) {
+  std::erase_if(recording_, [command_buffer](const auto& recording) { return recording.first == command_buffer; });
+  if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to record command buffer!"};
+  }
+  if (acquire_command_buffer != VK_NULL_HANDLE && vkEndCommandBuffer(acquire_command_buffer) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to record command buffer!"};
+  }
+
+  VkFence fence;
+  if (!free_fences_.empty()) {
+    fence = free_fences_.back();
+    free_fences_.pop_back();
+  } else {
+    VkFenceCreateInfo fence_create_info{};
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(device_.GetHandle(), &fence_create_info, nullptr, &fence) != VK_SUCCESS) {
+      throw std::runtime_error{"Failed to create fence!"};
+    }
+  }
+
+  VkSemaphore semaphore = VK_NULL_HANDLE;
+  if (acquire_command_buffer != VK_NULL_HANDLE) {
+    if (!free_semaphores_.empty()) {
+      semaphore = free_semaphores_.back();
+      free_semaphores_.pop_back();
+    } else {
+      VkSemaphoreCreateInfo semaphore_create_info{};
+      semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      if (vkCreateSemaphore(device_.GetHandle(), &semaphore_create_info, nullptr, &semaphore) != VK_SUCCESS) {
+        throw std::runtime_error{"Failed to create semaphore!"};
+      }
+    }
+  }
+
+  VkSubmitInfo submit_info{};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer;
+  if (semaphore != VK_NULL_HANDLE) {
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &semaphore;
+  }
+  VkFence transfer_fence = semaphore != VK_NULL_HANDLE ? VK_NULL_HANDLE : fence;
+  if (vkQueueSubmit(device_.GetTransferQueue(), 1, &submit_info, transfer_fence) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to submit command buffer!"};
+  }
+
+  if (acquire_command_buffer != VK_NULL_HANDLE) {
+    // The acquire waits for the transfer, so its fence covers both submissions
+    const VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkSubmitInfo acquire_submit_info{};
+    acquire_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    acquire_submit_info.waitSemaphoreCount = 1;
+    acquire_submit_info.pWaitSemaphores = &semaphore;
+    acquire_submit_info.pWaitDstStageMask = &wait_stage;
+    acquire_submit_info.commandBufferCount = 1;
+    acquire_submit_info.pCommandBuffers = &acquire_command_buffer;
+    if (vkQueueSubmit(device_.GetGraphicsQueue(), 1, &acquire_submit_info, fence) != VK_SUCCESS) {
+      throw std::runtime_error{"Failed to submit command buffer!"};
+    }
+  }
+
+  // Everything acquired so far is consumed by this submission or by a command buffer still being recorded
+  const uint64_t token = next_token_++;
+  submissions_.push_back({
+      .token = token,
+      .fence = fence,
+      .semaphore = semaphore,
+      .command_buffer = command_buffer,
+      .acquire_command_buffer = acquire_command_buffer,
+      .ring_end = head_,
+  });
+  return token;
+}
+
+bool StagingRing::IsComplete(uint64_t token) {
+  Reclaim();
+  return token <= completed_token_;
+}
+
+void StagingRing::Wait(uint64_t token) {
+  while (!submissions_.empty() && submissions_.front().token <= token) {
+    if (vkWaitForFences(device_.GetHandle(), 1, &submissions_.front().fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+      throw std::runtime_error{"Failed to wait for staging fence!"};
+    }
+    Reclaim();
+  }
+}
+
+void StagingRing::WaitIdle() {
+  if (!submissions_.empty()) {
+    Wait(submissions_.back().token);
+  }
+}
+
+VkCommandBuffer StagingRing::BeginCommandBuffer(VkCommandPool command_pool,
+                                                std::vector<VkCommandBuffer>& free_command_buffers) {
+  VkCommandBuffer command_buffer;
+  if (!free_command_buffers.empty()) {
+    command_buffer = free_command_buffers.back();
+    free_command_buffers.pop_back();
+  } else {
+    VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+    command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocate_info.commandPool = command_pool;
+    command_buffer_allocate_info.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(device_.GetHandle(), &command_buffer_allocate_info, &command_buffer) != VK_SUCCESS) {
+      throw std::runtime_error{"Failed to allocate command buffer!"};
+    }
+  }
+
+  VkCommandBufferBeginInfo command_buffer_begin_info{};
+  command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to begin recording command buffer!"};
+  }
+  return command_buffer;
+}
+
+void StagingRing::Reclaim() {
+  while (!submissions_.empty()) {
+    Submission& submission = submissions_.front();
+    if (vkGetFenceStatus(device_.GetHandle(), submission.fence) != VK_SUCCESS) {
+      break;
+    }
+    vkResetFences(device_.GetHandle(), 1, &submission.fence);
+    vkResetCommandBuffer(submission.command_buffer, 0);
+    free_fences_.push_back(submission.fence);
+    free_command_buffers_.push_back(submission.command_buffer);
+    if (submission.acquire_command_buffer != VK_NULL_HANDLE) {
+      vkResetCommandBuffer(submission.acquire_command_buffer, 0);
+      free_acquire_command_buffers_.push_back(submission.acquire_command_buffer);
+      free_semaphores_.push_back(submission.semaphore);
+    }
+
+    completed_end_ = submission.ring_end;
+    completed_token_ = submission.token;
+    submissions_.pop_front();
+  }
+
+  // Regions of command buffers that are still being recorded must survive
+  tail_ = completed_end_;
+  for (const auto& [command_buffer, begin] : recording_) {
+    tail_ = std::min(tail_, begin);
+  }
+}
+
+}  // namespace engine
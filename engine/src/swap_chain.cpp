@@ -7,23 +7,16 @@
 #include <utility>
 
 namespace engine {
-Swapchain::Swapchain(Device& device, VkExtent2D window_extent, std::unique_ptr<Swapchain> old_swapchain)
+Swapchain::Swapchain(Device& device, VkExtent2D window_extent, const Swapchain* old_swapchain)
     : device_{device}, window_extent_{window_extent} {
-  CreateSwapChain(std::move(old_swapchain));
+  CreateSwapChain(old_swapchain);
   CreateImageViews();
   CreateDepthResources();
   CreateRenderPass();
   CreateFrameBuffers();
-  CreateSynchronizationObjects();
 }
 
 Swapchain::~Swapchain() {
-  for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
-    vkDestroySemaphore(device_.GetHandle(), image_available_semaphores_[i], nullptr);
-    vkDestroySemaphore(device_.GetHandle(), render_finished_semaphores_[i], nullptr);
-    vkDestroyFence(device_.GetHandle(), in_flight_fences_[i], nullptr);
-  }
-
   for (auto framebuffer : framebuffers_) {
     vkDestroyFramebuffer(device_.GetHandle(), framebuffer, nullptr);
   }
@@ -33,7 +26,7 @@ Swapchain::~Swapchain() {
   for (size_t i = 0; i < depth_images_.size(); ++i) {
     vkDestroyImageView(device_.GetHandle(), depth_image_views_[i], nullptr);
     vkDestroyImage(device_.GetHandle(), depth_images_[i], nullptr);
-    vkFreeMemory(device_.GetHandle(), depth_images_memory_[i], nullptr);
+    device_.FreeMemory(depth_image_allocations_[i]);
   }
 
   for (auto image_view : image_views_) {
@@ -43,53 +36,27 @@ Swapchain::~Swapchain() {
   vkDestroySwapchainKHR(device_.GetHandle(), swapchain_, nullptr);
 }
 
-VkResult Swapchain::AcquireNextImage(uint32_t* image_index) {
-  vkWaitForFences(device_.GetHandle(), 1, GetInFlightFence(), VK_TRUE, UINT64_MAX);
-  vkResetFences(device_.GetHandle(), 1, GetInFlightFence());
-  return vkAcquireNextImageKHR(device_.GetHandle(), swapchain_, UINT64_MAX, *GetImageAvailableSemaphore(),
+VkResult Swapchain::AcquireNextImage(VkSemaphore image_available_semaphore, uint32_t* image_index) {
+  return vkAcquireNextImageKHR(device_.GetHandle(), swapchain_, UINT64_MAX, image_available_semaphore,
                                VK_NULL_HANDLE, image_index);
 }
 
-VkResult Swapchain::SubmitAndPresent(const VkCommandBuffer& command_buffer, uint32_t image_index) {
-  VkSubmitInfo submit_info{};
-  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-  // Wait until the image is available...
-  submit_info.waitSemaphoreCount = 1;
-  submit_info.pWaitSemaphores = GetImageAvailableSemaphore();
-
-  // ...at the end of the pipeline.
-  std::array<VkPipelineStageFlags, 1> wait_stages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submit_info.pWaitDstStageMask = wait_stages.data();
-
-  submit_info.commandBufferCount = 1;
-  submit_info.pCommandBuffers = &command_buffer;
-
-  // Signal that the image is ready to be presented.
-  submit_info.signalSemaphoreCount = 1;
-  submit_info.pSignalSemaphores = GetRenderFinishedSemaphore();
-
-  if (vkQueueSubmit(device_.GetGraphicsQueue(), 1, &submit_info, *GetInFlightFence()) != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to submit command buffer!"};
-  }
-
+VkResult Swapchain::Present(VkSemaphore render_finished_semaphore, uint32_t image_index) {
   VkPresentInfoKHR present_info{};
   present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
   // Wait until the image is ready to be presented.
   present_info.waitSemaphoreCount = 1;
-  present_info.pWaitSemaphores = GetRenderFinishedSemaphore();
+  present_info.pWaitSemaphores = &render_finished_semaphore;
 
   present_info.swapchainCount = 1;
   present_info.pSwapchains = &swapchain_;
   present_info.pImageIndices = &image_index;
 
-  auto present_result = vkQueuePresentKHR(device_.GetPresentQueue(), &present_info);
-  frame_index_ = (frame_index_ + 1) % kMaxFramesInFlight;
-  return present_result;
+  return vkQueuePresentKHR(device_.GetPresentQueue(), &present_info);
 }
 
-void Swapchain::CreateSwapChain(std::unique_ptr<Swapchain> old_swapchain) {
+void Swapchain::CreateSwapChain(const Swapchain* old_swapchain) {
   SwapchainSupportDetails swapchain_support_details = device_.QuerySwapchainSupportDetails();
 
   VkSurfaceFormatKHR surface_format = PickSwapchainSurfaceFormat(swapchain_support_details.formats);
@@ -228,7 +195,7 @@ void Swapchain::CreateDepthResources() {
                                    VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
 
   depth_images_.resize(images_.size());
-  depth_images_memory_.resize(images_.size());
+  depth_image_allocations_.resize(images_.size());
   depth_image_views_.resize(images_.size());
 
   for (size_t i = 0; i < images_.size(); ++i) {
@@ -253,15 +220,11 @@ void Swapchain::CreateDepthResources() {
     VkMemoryRequirements memory_requirements{};
     vkGetImageMemoryRequirements(device_.GetHandle(), depth_images_[i], &memory_requirements);
 
-    VkMemoryAllocateInfo memory_allocate_info{};
-    memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memory_allocate_info.allocationSize = memory_requirements.size;
-    memory_allocate_info.memoryTypeIndex =
-        device_.QueryMemoryType(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (vkAllocateMemory(device_.GetHandle(), &memory_allocate_info, nullptr, &depth_images_memory_[i]) != VK_SUCCESS) {
-      throw std::runtime_error{"Failed to allocate image memory!"};
-    }
-    if (vkBindImageMemory(device_.GetHandle(), depth_images_[i], depth_images_memory_[i], 0) != VK_SUCCESS) {
+    depth_image_allocations_[i] =
+        device_.AllocateMemory(memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                               FreeListAllocator::ResourceKind::kOptimal, MemoryCategory::kDepthAttachment);
+    if (vkBindImageMemory(device_.GetHandle(), depth_images_[i], depth_image_allocations_[i].memory,
+                          depth_image_allocations_[i].offset) != VK_SUCCESS) {
       throw std::runtime_error{"Failed to bind image memory!"};
     }
 
@@ -302,25 +265,6 @@ void Swapchain::CreateFrameBuffers() {
   }
 }
 
-void Swapchain::CreateSynchronizationObjects() {
-  VkSemaphoreCreateInfo semaphore_info{};
-  semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-  VkFenceCreateInfo fence_info{};
-  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-  for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
-    if (vkCreateSemaphore(device_.GetHandle(), &semaphore_info, nullptr, &image_available_semaphores_[i]) !=
-            VK_SUCCESS ||
-        vkCreateSemaphore(device_.GetHandle(), &semaphore_info, nullptr, &render_finished_semaphores_[i]) !=
-            VK_SUCCESS ||
-        vkCreateFence(device_.GetHandle(), &fence_info, nullptr, &in_flight_fences_[i]) != VK_SUCCESS) {
-      throw std::runtime_error{"Failed to create synchronization objects!"};
-    }
-  }
-}
-
 VkSurfaceFormatKHR Swapchain::PickSwapchainSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& available_formats) {
   auto it =
       std::find_if(available_formats.begin(), available_formats.end(), [](const VkSurfaceFormatKHR& available_format) {
@@ -1,53 +1,269 @@
 #include "engine/systems/model_render_system.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <optional>
 #include <stdexcept>
+#include <tuple>
+
+#include "engine/frustum.h"
+#include "engine/geometry_arena.h"
+#include "engine/uniforms.h"
 
 namespace {
-struct PushConstants {
-  glm::mat4 model;
-};
+// Largest screen-space error of a level of detail, in viewport heights: about half a pixel at 1080p, as the error is
+// an RMS estimate, single vertices and the silhouette may deviate further
+constexpr float kMaxLodError = 0.5f / 1080.0f;
+// A coarser level is only switched to once its error is well below the limit, so that a model near the limit doesn't
+// keep popping between two levels
+constexpr float kLodHysteresis = 0.75f;
+// Closer than this, e.g. inside a model's bounding sphere, the full detail is used
+constexpr float kMinLodDistance = 0.01f;
+
+uint32_t GetPipelineIndex(engine::VertexFormat vertex_format, engine::VertexStreams vertex_streams) {
+  return static_cast<uint32_t>(vertex_format) * engine::kVertexStreamsCount + static_cast<uint32_t>(vertex_streams);
+}
+
+uint32_t GetPipelineIndex(const engine::Mesh& mesh) {
+  return GetPipelineIndex(mesh.GetVertexFormat(), mesh.GetVertexStreams());
+}
+
+// error_scale projects an error in the mesh's units to viewport heights
+uint32_t SelectLod(const engine::Mesh& mesh, float error_scale, uint32_t lod) {
+  lod = std::min(lod, mesh.GetLodCount() - 1);
+  while (lod > 0 && mesh.GetLodError(lod) * error_scale > kMaxLodError) {
+    --lod;
+  }
+  while (lod + 1 < mesh.GetLodCount() && mesh.GetLodError(lod + 1) * error_scale <= kMaxLodError * kLodHysteresis) {
+    ++lod;
+  }
+  return lod;
+}
 }  // namespace
 
 namespace engine::systems {
-ModelRenderSystem::ModelRenderSystem(Device& device, VkRenderPass render_pass,
+ModelRenderSystem::ModelRenderSystem(Device& device, const MeshManager& mesh_manager,
+                                     TextureManager& texture_manager, VkRenderPass render_pass,
                                      VkDescriptorSetLayout global_descriptor_set_layout)
-    : device_{device} {
+    : device_{device}, mesh_manager_{mesh_manager}, texture_manager_{texture_manager} {
+  CreateDescriptorSetLayout();
   CreatePipelineLayout(global_descriptor_set_layout);
   CreatePipeline(render_pass);
 }
 
 ModelRenderSystem::~ModelRenderSystem() {
   vkDestroyPipelineLayout(device_.GetHandle(), pipeline_layout_, nullptr);
+  vkDestroyDescriptorSetLayout(device_.GetHandle(), texture_descriptor_set_layout_, nullptr);
 }
 
-void ModelRenderSystem::Render(VkCommandBuffer command_buffer, const std::vector<std::unique_ptr<Model>>& models,
+void ModelRenderSystem::Render(VkCommandBuffer command_buffer, FrameArena& frame_arena, const SlotMap<Model>& models,
+                               const SlotMap<DynamicModel>& dynamic_models, const Camera& camera,
                                VkDescriptorSet global_descriptor_set) {
-  assert(pipeline_);
-  pipeline_->Bind(command_buffer);
+  assert(pipelines_[0]);
 
+  // The global set stays bound across pipelines, the layout is shared
   vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout_, 0, 1,
                           &global_descriptor_set, 0, nullptr);
+  RenderModels(command_buffer, frame_arena, models, camera);
+  RenderDynamicModels(command_buffer, frame_arena, dynamic_models);
+}
+
+void ModelRenderSystem::RenderModels(VkCommandBuffer command_buffer, FrameArena& frame_arena,
+                                     const SlotMap<Model>& models, const Camera& camera) {
+  // Resolve the mesh handles once, models whose mesh has been removed or that are outside the view are skipped
+  draws_.clear();
+  const glm::mat4 view_projection = camera.GetProjection() * camera.GetView();
+  const Frustum view_frustum{view_projection};
+  const float projection_scale = std::abs(camera.GetProjection()[1][1]) * 0.5f;
+  for (uint32_t i = 0; i < models.GetSize(); ++i) {
+    const Mesh* mesh = mesh_manager_.Get(models[i].GetMesh());
+    if (!mesh) {
+      continue;
+    }
+    const Transform& transform = models[i].GetTransform();
+    const BoundingSphere sphere = mesh->GetBounds().Transformed(transform).sphere;
+    if (!view_frustum.IntersectsSphere(sphere.center, sphere.radius)) {
+      continue;
+    }
+    // The error is projected at the point of the bounding sphere nearest to the camera
+    const ModelHandle model_handle = models.GetHandle(i);
+    if (model_handle.GetIndex() >= model_lods_.size()) {
+      model_lods_.resize(model_handle.GetIndex() + 1);
+    }
+    ModelLod& model_lod = model_lods_[model_handle.GetIndex()];
+    if (model_lod.model != model_handle) {
+      model_lod = {.model = model_handle};
+    }
+    const float distance =
+        std::max(glm::length(sphere.center - camera.GetPosition()) - sphere.radius, kMinLodDistance);
+    model_lod.lod = SelectLod(*mesh, transform.scale * projection_scale / distance, model_lod.lod);
+    draws_.push_back({.mesh = mesh, .texture = models[i].GetTexture(), .model_index = i, .lod = model_lod.lod});
+  }
+  // Sort so that draws sharing a pipeline, a geometry page and a texture are consecutive
+  std::sort(draws_.begin(), draws_.end(), [](const Draw& lhs, const Draw& rhs) {
+    return std::tuple{GetPipelineIndex(*lhs.mesh), lhs.mesh->GetGeometry().page, lhs.texture.GetValue()} <
+           std::tuple{GetPipelineIndex(*rhs.mesh), rhs.mesh->GetGeometry().page, rhs.texture.GetValue()};
+  });
+  auto draw_count = static_cast<uint32_t>(draws_.size());
+  if (draw_count == 0) {
+    return;
+  }
+
+  // A command per draw range, meshes split for 16-bit indices have several sharing the model's object data. Meshes
+  // with meshlets need at most one per meshlet.
+  auto get_max_command_count = [](const Draw& draw) {
+    const Mesh& mesh = *draw.mesh;
+    return static_cast<uint32_t>(draw.lod == 0 && !mesh.GetMeshlets().empty() ? mesh.GetMeshletDrawRanges().size()
+                                                                              : mesh.GetDrawRanges(draw.lod).size());
+  };
+  uint32_t max_command_count = 0;
+  for (const Draw& draw : draws_) {
+    max_command_count += get_max_command_count(draw);
+  }
 
-  for (const auto& model : models) {
-    PushConstants push_constants{
-        .model = model->GetTransform().Mat4(),
+  // The object data is followed by the commands in a single allocation
+  auto get_allocation_size = [](uint32_t object_count, uint32_t command_count) {
+    return sizeof(ObjectData) * object_count + sizeof(VkDrawIndexedIndirectCommand) * command_count;
+  };
+  std::optional<FrameArena::Allocation> allocation =
+      frame_arena.Allocate(get_allocation_size(draw_count, max_command_count), sizeof(ObjectData));
+  if (!allocation) {
+    // The arena grows to fit them all by its next frame, this one drops the draws that don't fit
+    const VkDeviceSize available_size = frame_arena.GetAvailableSize(sizeof(ObjectData));
+    while (draw_count > 0 && get_allocation_size(draw_count, max_command_count) > available_size) {
+      max_command_count -= get_max_command_count(draws_[--draw_count]);
+    }
+    if (draw_count == 0) {
+      return;
+    }
+    allocation = frame_arena.Allocate(get_allocation_size(draw_count, max_command_count), sizeof(ObjectData));
+    assert(allocation);
+  }
+  auto* objects = static_cast<ObjectData*>(allocation->mapped);
+  const auto first_object = static_cast<uint32_t>(allocation->offset / sizeof(ObjectData));
+  const FrameArena::Allocation commands_allocation{
+      .buffer = allocation->buffer,
+      .offset = allocation->offset + sizeof(ObjectData) * draw_count,
+      .size = sizeof(VkDrawIndexedIndirectCommand) * max_command_count,
+      .mapped = objects + draw_count,
+  };
+  auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(commands_allocation.mapped);
+  uint32_t command_index = 0;
+  for (uint32_t i = 0; i < draw_count; ++i) {
+    const VertexDequantization& dequantization = draws_[i].mesh->GetDequantization();
+    const glm::mat4 model = models[draws_[i].model_index].GetTransform().Mat4();
+    objects[i] = {
+        .model = model * dequantization.PositionMat4(),
+        .normal = glm::transpose(glm::inverse(model)),
+        .uv_transform = dequantization.uv_transform,
     };
-    vkCmdPushConstants(command_buffer, pipeline_layout_, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants),
-                       &push_constants);
+    draws_[i].first_command = command_index;
+    const std::vector<Meshlet>& meshlets = draws_[i].mesh->GetMeshlets();
+    if (draws_[i].lod > 0 || meshlets.empty()) {
+      for (const DrawRange& draw_range : draws_[i].mesh->GetDrawRanges(draws_[i].lod)) {
+        commands[command_index++] = {
+            .indexCount = draw_range.index_count,
+            .instanceCount = 1,
+            .firstIndex = draw_range.first_index,
+            .vertexOffset = draw_range.vertex_offset,
+            .firstInstance = first_object + i,
+        };
+      }
+    } else {
+      // Culled in the mesh's space, the transform only translates and scales uniformly so the cones stay valid
+      const Frustum frustum{view_projection * model};
+      const glm::vec3 view_position{glm::inverse(model) * glm::vec4{camera.GetPosition(), 1.0f}};
+      const std::vector<DrawRange>& draw_ranges = draws_[i].mesh->GetMeshletDrawRanges();
+      for (size_t j = 0; j < meshlets.size(); ++j) {
+        const MeshletBounds& bounds = meshlets[j].bounds;
+        if (!frustum.IntersectsSphere(bounds.center, bounds.radius) || bounds.IsBackfacing(view_position)) {
+          continue;
+        }
+        // Consecutive visible meshlets sharing a base vertex merge into one command
+        const DrawRange& draw_range = draw_ranges[j];
+        VkDrawIndexedIndirectCommand* previous =
+            command_index > draws_[i].first_command ? &commands[command_index - 1] : nullptr;
+        if (previous && previous->vertexOffset == draw_range.vertex_offset &&
+            previous->firstIndex + previous->indexCount == draw_range.first_index) {
+          previous->indexCount += draw_range.index_count;
+          continue;
+        }
+        commands[command_index++] = {
+            .indexCount = draw_range.index_count,
+            .instanceCount = 1,
+            .firstIndex = draw_range.first_index,
+            .vertexOffset = draw_range.vertex_offset,
+            .firstInstance = first_object + i,
+        };
+      }
+    }
+    draws_[i].command_count = command_index - draws_[i].first_command;
+  }
+
+  const GeometryArena& geometry_arena = device_.GetGeometryArena();
+  for (uint32_t first = 0; first < draw_count;) {
+    const uint32_t pipeline_index = GetPipelineIndex(*draws_[first].mesh);
+    const uint32_t page = draws_[first].mesh->GetGeometry().page;
+    const TextureHandle texture_handle = draws_[first].texture;
+    uint32_t last = first;
+    uint32_t group_command_count = 0;
+    do {
+      group_command_count += draws_[last].command_count;
+      ++last;
+    } while (last < draw_count && draws_[last].mesh->GetGeometry().page == page &&
+             draws_[last].texture == texture_handle);
 
-    model->Bind(command_buffer, pipeline_layout_);
-    model->Draw(command_buffer);
+    if (first == 0 || GetPipelineIndex(*draws_[first - 1].mesh) != pipeline_index) {
+      pipelines_[pipeline_index]->Bind(command_buffer);
+    }
+    if (first == 0 || draws_[first - 1].mesh->GetGeometry().page != page) {
+      geometry_arena.Bind(command_buffer, page);
+    }
+    // Null for untextured models and removed textures
+    if (Texture* texture = texture_manager_.Get(texture_handle)) {
+      texture->Bind(command_buffer, pipeline_layout_);
+    }
+    if (group_command_count > 0) {
+      DrawIndirect(command_buffer, commands_allocation, draws_[first].first_command, group_command_count);
+    }
+
+    first = last;
   }
 }
 
-void ModelRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout global_descriptor_set_layout) {
-  VkPushConstantRange push_constant_range{};
-  push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-  push_constant_range.offset = 0;
-  push_constant_range.size = sizeof(PushConstants);
+void ModelRenderSystem::RenderDynamicModels(VkCommandBuffer command_buffer, FrameArena& frame_arena,
+                                            const SlotMap<DynamicModel>& dynamic_models) {
+  if (dynamic_models.IsEmpty()) {
+    return;
+  }
+  // Dynamic meshes have their own buffers, so each is a direct draw of interleaved float vertices
+  auto [objects, first_object] = frame_arena.AllocateElements<ObjectData>(dynamic_models.GetSize());
+  // Dropped for the frame if the arena is full, it grows to fit them by its next one
+  if (!objects) {
+    return;
+  }
+  pipelines_[GetPipelineIndex(VertexFormat::kFloat32, VertexStreams::kInterleaved)]->Bind(command_buffer);
+  for (uint32_t i = 0; i < dynamic_models.GetSize(); ++i) {
+    const DynamicModel& dynamic_model = dynamic_models[i];
+    const glm::mat4 model = dynamic_model.transform.Mat4();
+    objects[i] = {
+        .model = model,
+        .normal = glm::transpose(glm::inverse(model)),
+        .uv_transform = VertexDequantization{}.uv_transform,
+    };
+    // Null for untextured models and removed textures
+    if (Texture* texture = texture_manager_.Get(dynamic_model.texture)) {
+      texture->Bind(command_buffer, pipeline_layout_);
+    }
+    dynamic_model.mesh.Bind(command_buffer);
+    dynamic_model.mesh.Draw(command_buffer, first_object + i);
+  }
+}
 
+void ModelRenderSystem::CreateDescriptorSetLayout() {
   // TODO Temporary, where should this be stored?
   VkDescriptorSetLayoutBinding texture_descriptor_set_layout_binding{};
   texture_descriptor_set_layout_binding.binding = 0;
@@ -60,21 +276,22 @@ void ModelRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout global_descri
   texture_descriptor_set_layout_info.bindingCount = 1;
   texture_descriptor_set_layout_info.pBindings = &texture_descriptor_set_layout_binding;
 
-  VkDescriptorSetLayout texture_descriptor_set_layout = VK_NULL_HANDLE;
   if (vkCreateDescriptorSetLayout(device_.GetHandle(), &texture_descriptor_set_layout_info, nullptr,
-                                  &texture_descriptor_set_layout) != VK_SUCCESS) {
+                                  &texture_descriptor_set_layout_) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to create descriptor set layout"};
   }
+}
 
+void ModelRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout global_descriptor_set_layout) {
   std::array<VkDescriptorSetLayout, 2> descriptor_set_layouts = {global_descriptor_set_layout,
-                                                                 texture_descriptor_set_layout};
+                                                                 texture_descriptor_set_layout_};
 
   VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
   pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
   pipeline_layout_create_info.setLayoutCount = static_cast<uint32_t>(descriptor_set_layouts.size());
   pipeline_layout_create_info.pSetLayouts = descriptor_set_layouts.data();
-  pipeline_layout_create_info.pushConstantRangeCount = 1;
-  pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+  pipeline_layout_create_info.pushConstantRangeCount = 0;
+  pipeline_layout_create_info.pPushConstantRanges = nullptr;
 
   if (vkCreatePipelineLayout(device_.GetHandle(), &pipeline_layout_create_info, nullptr, &pipeline_layout_) !=
       VK_SUCCESS) {
@@ -85,11 +302,42 @@ void ModelRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout global_descri
 void ModelRenderSystem::CreatePipeline(VkRenderPass render_pass) {
   assert(pipeline_layout_);
 
-  GraphicsPipelineConfig pipeline_config = GraphicsPipelineConfig::Default();
-  pipeline_config.pipeline_layout = pipeline_layout_;
-  pipeline_config.render_pass = render_pass;
-  pipeline_ =
-      std::make_unique<GraphicsPipeline>(device_, pipeline_config, "shaders/model.vert.spv", "shaders/model.frag.spv");
+  // Quantized formats decode octahedral normals and have no vertex color. Split streams only differ in the vertex
+  // input state, the shaders are the same.
+  for (uint32_t i = 0; i < kVertexFormatCount * kVertexStreamsCount; ++i) {
+    const auto vertex_format = static_cast<VertexFormat>(i / kVertexStreamsCount);
+    const auto vertex_streams = static_cast<VertexStreams>(i % kVertexStreamsCount);
+    GraphicsPipelineConfig pipeline_config = GraphicsPipelineConfig::Default(vertex_format, vertex_streams);
+    pipeline_config.pipeline_layout = pipeline_layout_;
+    pipeline_config.render_pass = render_pass;
+    pipelines_[i] = std::make_unique<GraphicsPipeline>(
+        device_, pipeline_config,
+        vertex_format == VertexFormat::kFloat32 ? "shaders/model.vert.spv" : "shaders/model_quantized.vert.spv",
+        "shaders/model.frag.spv");
+  }
 }
 
+void ModelRenderSystem::DrawIndirect(VkCommandBuffer command_buffer, const FrameArena::Allocation& commands,
+                                     uint32_t first_draw, uint32_t draw_count) const {
+  const VkPhysicalDeviceFeatures& features = device_.GetEnabledFeatures();
+  if (!features.drawIndirectFirstInstance) {
+    // Indirect commands must have a zero firstInstance, issue them as direct draws instead
+    const auto* mapped_commands = static_cast<const VkDrawIndexedIndirectCommand*>(commands.mapped);
+    for (uint32_t i = first_draw; i < first_draw + draw_count; ++i) {
+      const VkDrawIndexedIndirectCommand& command = mapped_commands[i];
+      vkCmdDrawIndexed(command_buffer, command.indexCount, command.instanceCount, command.firstIndex,
+                       command.vertexOffset, command.firstInstance);
+    }
+    return;
+  }
+
+  const uint32_t max_draw_count = features.multiDrawIndirect ? device_.GetProperties().limits.maxDrawIndirectCount : 1;
+  for (uint32_t drawn = 0; drawn < draw_count;) {
+    const uint32_t count = std::min(draw_count - drawn, max_draw_count);
+    vkCmdDrawIndexedIndirect(command_buffer, commands.buffer,
+                             commands.offset + sizeof(VkDrawIndexedIndirectCommand) * (first_draw + drawn), count,
+                             sizeof(VkDrawIndexedIndirectCommand));
+    drawn += count;
+  }
+}
 }  // namespace engine::systems
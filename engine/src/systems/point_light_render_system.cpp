@@ -44,10 +44,7 @@ void PointLightRenderSystem::CreatePipeline(VkRenderPass render_pass) {
   assert(pipeline_layout_);
 
   GraphicsPipelineConfig pipeline_config = GraphicsPipelineConfig::Default();
-  pipeline_config.vertex_input_info.vertexAttributeDescriptionCount = 0;
-  pipeline_config.vertex_input_info.pVertexAttributeDescriptions = nullptr;
-  pipeline_config.vertex_input_info.vertexBindingDescriptionCount = 0;
-  pipeline_config.vertex_input_info.pVertexBindingDescriptions = nullptr;
+  pipeline_config.SetVertexLayout<VertexLayout<>>();  // Billboard corners come from gl_VertexIndex
   pipeline_config.pipeline_layout = pipeline_layout_;
   pipeline_config.render_pass = render_pass;
   pipeline_ = std::make_unique<GraphicsPipeline>(device_, pipeline_config, "shaders/point_light.vert.spv",
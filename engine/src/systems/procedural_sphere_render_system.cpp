@@ -0,0 +1,104 @@
+#include "engine/systems/procedural_sphere_render_system.h"
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+#include "engine/uniforms.h"
+
+namespace engine::systems {
+ProceduralSphereRenderSystem::ProceduralSphereRenderSystem(Device& device, TextureManager& texture_manager,
+                                                           VkRenderPass render_pass,
+                                                           VkDescriptorSetLayout global_descriptor_set_layout)
+    : device_{device}, texture_manager_{texture_manager} {
+  CreateDescriptorSetLayout();
+  CreatePipelineLayout(global_descriptor_set_layout);
+  CreatePipeline(render_pass);
+}
+
+ProceduralSphereRenderSystem::~ProceduralSphereRenderSystem() {
+  vkDestroyPipelineLayout(device_.GetHandle(), pipeline_layout_, nullptr);
+  vkDestroyDescriptorSetLayout(device_.GetHandle(), texture_descriptor_set_layout_, nullptr);
+}
+
+void ProceduralSphereRenderSystem::Render(VkCommandBuffer command_buffer, const SlotMap<ProceduralSphere>& spheres,
+                                          VkDescriptorSet global_descriptor_set) {
+  assert(pipeline_);
+  if (spheres.IsEmpty()) {
+    return;
+  }
+  pipeline_->Bind(command_buffer);
+
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout_, 0, 1,
+                          &global_descriptor_set, 0, nullptr);
+
+  for (const ProceduralSphere& sphere : spheres) {
+    assert(sphere.cube_face_resolution >= 2);
+    // Null for untextured spheres and removed textures
+    if (Texture* texture = texture_manager_.Get(sphere.texture)) {
+      texture->Bind(command_buffer, pipeline_layout_);
+    }
+    const ProceduralSpherePushConstants push_constants{
+        .model = sphere.transform.Mat4(),
+        .cube_face_resolution = sphere.cube_face_resolution,
+    };
+    vkCmdPushConstants(command_buffer, pipeline_layout_, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push_constants),
+                       &push_constants);
+    // Two triangles per grid quad
+    const uint32_t quads_per_row = sphere.cube_face_resolution - 1;
+    vkCmdDraw(command_buffer, 6 * 6 * quads_per_row * quads_per_row, 1, 0, 0);
+  }
+}
+
+void ProceduralSphereRenderSystem::CreateDescriptorSetLayout() {
+  // Same as ModelRenderSystem's, so that the textures' descriptor sets are compatible
+  VkDescriptorSetLayoutBinding texture_descriptor_set_layout_binding{};
+  texture_descriptor_set_layout_binding.binding = 0;
+  texture_descriptor_set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  texture_descriptor_set_layout_binding.descriptorCount = 1;
+  texture_descriptor_set_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+  VkDescriptorSetLayoutCreateInfo texture_descriptor_set_layout_info{};
+  texture_descriptor_set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  texture_descriptor_set_layout_info.bindingCount = 1;
+  texture_descriptor_set_layout_info.pBindings = &texture_descriptor_set_layout_binding;
+
+  if (vkCreateDescriptorSetLayout(device_.GetHandle(), &texture_descriptor_set_layout_info, nullptr,
+                                  &texture_descriptor_set_layout_) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create descriptor set layout!"};
+  }
+}
+
+void ProceduralSphereRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout global_descriptor_set_layout) {
+  std::array<VkDescriptorSetLayout, 2> descriptor_set_layouts = {global_descriptor_set_layout,
+                                                                 texture_descriptor_set_layout_};
+
+  VkPushConstantRange push_constant_range{};
+  push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = sizeof(ProceduralSpherePushConstants);
+
+  VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+  pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_create_info.setLayoutCount = static_cast<uint32_t>(descriptor_set_layouts.size());
+  pipeline_layout_create_info.pSetLayouts = descriptor_set_layouts.data();
+  pipeline_layout_create_info.pushConstantRangeCount = 1;
+  pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+  if (vkCreatePipelineLayout(device_.GetHandle(), &pipeline_layout_create_info, nullptr, &pipeline_layout_) !=
+      VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create pipeline layout!"};
+  }
+}
+
+void ProceduralSphereRenderSystem::CreatePipeline(VkRenderPass render_pass) {
+  assert(pipeline_layout_);
+
+  GraphicsPipelineConfig pipeline_config = GraphicsPipelineConfig::Default();
+  pipeline_config.SetVertexLayout<VertexLayout<>>();  // Vertices come from gl_VertexIndex
+  pipeline_config.pipeline_layout = pipeline_layout_;
+  pipeline_config.render_pass = render_pass;
+  pipeline_ = std::make_unique<GraphicsPipeline>(device_, pipeline_config, "shaders/procedural_sphere.vert.spv",
+                                                 "shaders/model.frag.spv");
+}
+}  // namespace engine::systems
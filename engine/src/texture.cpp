@@ -1,20 +1,58 @@
 #include "engine/texture.h"
 
-#include "engine/buffer.h"
 #include "engine/utils.h"
 
 namespace engine {
-Texture* Texture::CreateFromFile(TextureManager& manager, const std::filesystem::path& file_path) {
-  return manager.Add(file_path.string(), std::unique_ptr<Texture>(new Texture{manager.device_, file_path}));
+TextureHandle Texture::CreateFromFile(TextureManager& manager, const std::filesystem::path& file_path) {
+  UploadBatch upload_batch{manager.device_};
+  TextureHandle texture = CreateFromFile(manager, upload_batch, file_path);
+  upload_batch.Submit();
+  return texture;
+}
+
+TextureHandle Texture::CreateFromFile(TextureManager& manager, UploadBatch& upload_batch,
+                                      const std::filesystem::path& file_path) {
+  const std::string name = file_path.string();
+  if (TextureHandle texture = manager.Get(name); !texture.IsNull()) {
+    return texture;
+  }
+  return manager.Add(name, Texture{manager.device_, upload_batch, file_path});
 }
 
 Texture::~Texture() {
-  vkDestroyDescriptorSetLayout(device_.GetHandle(), descriptor_set_layout_, nullptr);
+  if (!device_) {
+    return;
+  }
+  vkDestroyDescriptorSetLayout(device_->GetHandle(), descriptor_set_layout_, nullptr);
+
+  device_->GetDeletionQueue().Enqueue([device = device_, sampler = sampler_, image_view = image_view_,
+                                      image = image_, allocation = allocation_]() mutable {
+    vkDestroySampler(device->GetHandle(), sampler, nullptr);
+    vkDestroyImageView(device->GetHandle(), image_view, nullptr);
+    vkDestroyImage(device->GetHandle(), image, nullptr);
+    device->FreeMemory(allocation);
+  });
+}
 
-  vkDestroySampler(device_.GetHandle(), sampler_, nullptr);
-  vkDestroyImageView(device_.GetHandle(), image_view_, nullptr);
-  vkDestroyImage(device_.GetHandle(), image_, nullptr);
-  vkFreeMemory(device_.GetHandle(), memory_, nullptr);
+Texture::Texture(Texture&& other) noexcept
+    : device_{std::exchange(other.device_, nullptr)},
+      image_{std::exchange(other.image_, VK_NULL_HANDLE)},
+      allocation_{std::exchange(other.allocation_, {})},
+      image_view_{std::exchange(other.image_view_, VK_NULL_HANDLE)},
+      sampler_{std::exchange(other.sampler_, VK_NULL_HANDLE)},
+      descriptor_set_layout_{std::exchange(other.descriptor_set_layout_, VK_NULL_HANDLE)},
+      descriptor_set_{std::exchange(other.descriptor_set_, VK_NULL_HANDLE)} {}
+
+Texture& Texture::operator=(Texture&& other) noexcept {
+  // The previous resources are released by the moved-from texture
+  std::swap(device_, other.device_);
+  std::swap(image_, other.image_);
+  std::swap(allocation_, other.allocation_);
+  std::swap(image_view_, other.image_view_);
+  std::swap(sampler_, other.sampler_);
+  std::swap(descriptor_set_layout_, other.descriptor_set_layout_);
+  std::swap(descriptor_set_, other.descriptor_set_);
+  return *this;
 }
 
 void Texture::Bind(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) {
@@ -22,10 +60,11 @@ void Texture::Bind(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_lay
                           nullptr);
 }
 
-Texture::Texture(Device& device, const std::filesystem::path& file_path) : device_{device} {
+Texture::Texture(Device& device, UploadBatch& upload_batch, const std::filesystem::path& file_path)
+    : device_{&device} {
   uint32_t width, height, channels;
   const std::vector<uint8_t> image_bytes = utils::ReadImage(file_path, width, height, channels);
-  CreateImage(image_bytes, width, height);
+  CreateImage(upload_batch, image_bytes, width, height);
   CreateImageView();
   CreateSampler();
 
@@ -41,17 +80,17 @@ Texture::Texture(Device& device, const std::filesystem::path& file_path) : devic
       .bindingCount = 1,
       .pBindings = &layout_binding,
   };
-  if (vkCreateDescriptorSetLayout(device_.GetHandle(), &layout_info, nullptr, &descriptor_set_layout_) != VK_SUCCESS) {
+  if (vkCreateDescriptorSetLayout(device_->GetHandle(), &layout_info, nullptr, &descriptor_set_layout_) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to create descriptor set layout!"};
   }
 
   VkDescriptorSetAllocateInfo alloc_info = {
       .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-      .descriptorPool = device_.GetDescriptorPool(),
+      .descriptorPool = device_->GetDescriptorPool(),
       .descriptorSetCount = 1,
       .pSetLayouts = &descriptor_set_layout_,
   };
-  if (vkAllocateDescriptorSets(device_.GetHandle(), &alloc_info, &descriptor_set_) != VK_SUCCESS) {
+  if (vkAllocateDescriptorSets(device_->GetHandle(), &alloc_info, &descriptor_set_) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to allocate descriptor set!"};
   }
 
@@ -65,15 +104,11 @@ Texture::Texture(Device& device, const std::filesystem::path& file_path) : devic
       .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
       .pImageInfo = &image_info,
   };
-  vkUpdateDescriptorSets(device_.GetHandle(), 1, &descriptor_write, 0, nullptr);
+  vkUpdateDescriptorSets(device_->GetHandle(), 1, &descriptor_write, 0, nullptr);
 }
 
-void Texture::CreateImage(const std::vector<uint8_t>& bytes, uint32_t width, uint32_t height) {
-  Buffer staging_buffer{device_, bytes.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
-  staging_buffer.Map();
-  staging_buffer.Write(reinterpret_cast<const void*>(bytes.data()));
-
+void Texture::CreateImage(UploadBatch& upload_batch, const std::vector<uint8_t>& bytes, uint32_t width,
+                          uint32_t height) {
   VkImageCreateInfo image_info{};
   image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   image_info.imageType = VK_IMAGE_TYPE_2D;
@@ -88,45 +123,21 @@ void Texture::CreateImage(const std::vector<uint8_t>& bytes, uint32_t width, uin
   image_info.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
   image_info.samples = VK_SAMPLE_COUNT_1_BIT;
   image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-  if (vkCreateImage(device_.GetHandle(), &image_info, nullptr, &image_) != VK_SUCCESS) {
+  if (vkCreateImage(device_->GetHandle(), &image_info, nullptr, &image_) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to create image!"};
   }
 
   VkMemoryRequirements memory_requirements{};
-  vkGetImageMemoryRequirements(device_.GetHandle(), image_, &memory_requirements);
-
-  VkMemoryAllocateInfo memory_allocate_info{};
-  memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  memory_allocate_info.allocationSize = memory_requirements.size;
-  memory_allocate_info.memoryTypeIndex =
-      device_.QueryMemoryType(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  if (vkAllocateMemory(device_.GetHandle(), &memory_allocate_info, nullptr, &memory_) != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to allocate image memory!"};
-  }
+  vkGetImageMemoryRequirements(device_->GetHandle(), image_, &memory_requirements);
 
-  if (vkBindImageMemory(device_.GetHandle(), image_, memory_, 0) != VK_SUCCESS) {
+  allocation_ = device_->AllocateMemory(memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                       FreeListAllocator::ResourceKind::kOptimal, MemoryCategory::kTexture);
+
+  if (vkBindImageMemory(device_->GetHandle(), image_, allocation_.memory, allocation_.offset) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to bind image memory!"};
   }
 
-  TransitionImageLayout(image_, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-  VkBufferImageCopy region{};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
-  region.imageOffset = {0, 0, 0};
-  region.imageExtent = {width, height, 1};
-
-  VkCommandBuffer command_buffer = device_.BeginSingleTimeCommands();
-  vkCmdCopyBufferToImage(command_buffer, staging_buffer.GetHandle(), image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
-                         &region);
-  device_.EndSingleTimeCommands(command_buffer);
-
-  TransitionImageLayout(image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  upload_batch.UploadImage(image_, bytes.data(), width, height, 4);
 }
 
 void Texture::CreateImageView() {
@@ -140,7 +151,7 @@ void Texture::CreateImageView() {
   view_info.subresourceRange.levelCount = 1;
   view_info.subresourceRange.baseArrayLayer = 0;
   view_info.subresourceRange.layerCount = 1;
-  if (vkCreateImageView(device_.GetHandle(), &view_info, nullptr, &image_view_) != VK_SUCCESS) {
+  if (vkCreateImageView(device_->GetHandle(), &view_info, nullptr, &image_view_) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to create texture image view!"};
   }
 }
@@ -163,50 +174,9 @@ void Texture::CreateSampler() {
   sampler_info.mipLodBias = 0.0f;
   sampler_info.minLod = 0.0f;
   sampler_info.maxLod = 0.0f;
-  if (vkCreateSampler(device_.GetHandle(), &sampler_info, nullptr, &sampler_) != VK_SUCCESS) {
+  if (vkCreateSampler(device_->GetHandle(), &sampler_info, nullptr, &sampler_) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to create texture sampler!"};
   }
 }
 
-void Texture::TransitionImageLayout(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout) {
-  VkCommandBuffer command_buffer = device_.BeginSingleTimeCommands();
-
-  VkImageMemoryBarrier barrier{};
-  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.oldLayout = old_layout;
-  barrier.newLayout = new_layout;
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.image = image;
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.baseMipLevel = 0;
-  barrier.subresourceRange.levelCount = 1;
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
-
-  VkPipelineStageFlags source_stage;
-  VkPipelineStageFlags destination_stage;
-
-  if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-    source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-  } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-             new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  } else {
-    throw std::invalid_argument{"Unsupported layout transition!"};
-  }
-
-  vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-  device_.EndSingleTimeCommands(command_buffer);
-}
-
 }  // namespace engine
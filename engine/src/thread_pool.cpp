@@ -0,0 +1,101 @@
+#include "engine/thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace engine {
+ThreadPool::ThreadPool(uint32_t worker_count) {
+  workers_.reserve(worker_count);
+  for (uint32_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{mutex_};
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+ThreadPool& ThreadPool::Get() {
+  static ThreadPool thread_pool{std::max(std::thread::hardware_concurrency(), 1u) - 1};
+  return thread_pool;
+}
+
+void ThreadPool::ParallelFor(uint32_t task_count, const std::function<void(uint32_t)>& task) {
+  if (task_count == 0) {
+    return;
+  }
+  if (workers_.empty() || task_count == 1) {
+    for (uint32_t i = 0; i < task_count; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  std::lock_guard parallel_for_lock{parallel_for_mutex_};
+  std::unique_lock lock{mutex_};
+  task_ = &task;
+  task_count_ = task_count;
+  next_task_ = 0;
+  finished_task_count_ = 0;
+  ++generation_;
+  work_available_.notify_all();
+
+  RunTasks(lock);
+  work_finished_.wait(lock, [this] { return finished_task_count_ == task_count_; });
+  task_ = nullptr;
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+  if (workers_.empty()) {
+    job();
+    return;
+  }
+  {
+    std::lock_guard lock{mutex_};
+    jobs_.push_back(std::move(job));
+  }
+  work_available_.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+  std::unique_lock lock{mutex_};
+  uint64_t seen_generation = generation_;
+  while (true) {
+    work_available_.wait(lock, [&] { return stopping_ || generation_ != seen_generation || !jobs_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    // A ParallelFor has a caller waiting on it, so it goes before the jobs
+    if (generation_ != seen_generation) {
+      seen_generation = generation_;
+      RunTasks(lock);
+      continue;
+    }
+    const std::function<void()> job = std::move(jobs_.front());
+    jobs_.pop_front();
+    lock.unlock();
+    job();
+    lock.lock();
+  }
+}
+
+void ThreadPool::RunTasks(std::unique_lock<std::mutex>& lock) {
+  while (task_ && next_task_ < task_count_) {
+    const uint32_t task_index = next_task_++;
+    const auto& task = *task_;
+    lock.unlock();
+    task(task_index);
+    lock.lock();
+    if (++finished_task_count_ == task_count_) {
+      work_finished_.notify_one();
+    }
+  }
+}
+}  // namespace engine
@@ -0,0 +1,240 @@
+#include "engine/upload_batch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+#include "engine/buffer.h"
+#include "engine/device.h"
+
+namespace engine {
+UploadBatch::UploadBatch(Device& device) : device_{device}, staging_ring_{device.GetStagingRing()} {}
+
+UploadBatch::~UploadBatch() {
+  // Never leave acquired staging regions unsubmitted
+  if (!IsEmpty()) {
+    Submit();
+  }
+}
+
+void UploadBatch::Upload(const Buffer& dst, const void* data, VkDeviceSize size, VkDeviceSize dst_offset) {
+  if (dst.IsHostVisible()) {
+    // Unified memory or resizable BAR, skip the staging copy
+    dst.WriteDirect(data, size, dst_offset);
+    return;
+  }
+
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (VkDeviceSize copied = 0; copied < size;) {
+    const VkDeviceSize chunk_size = std::min(size - copied, staging_ring_.GetMaxChunkSize());
+    const StagingRing::Region region = Stage(bytes + copied, chunk_size, StagingRing::kDefaultAlignment);
+
+    VkBufferCopy copy_region{};
+    copy_region.srcOffset = region.offset;
+    copy_region.dstOffset = dst_offset + copied;
+    copy_region.size = chunk_size;
+    vkCmdCopyBuffer(GetCommandBuffer(), region.buffer, dst.GetHandle(), 1, &copy_region);
+
+    copied += chunk_size;
+  }
+  TransferOwnership(dst, dst_offset, size);
+}
+
+void UploadBatch::Copy(const Buffer& src, const Buffer& dst, VkDeviceSize size, VkDeviceSize src_offset,
+                       VkDeviceSize dst_offset) {
+  VkBufferCopy copy_region{};
+  copy_region.srcOffset = src_offset;
+  copy_region.dstOffset = dst_offset;
+  copy_region.size = size;
+  vkCmdCopyBuffer(GetCommandBuffer(), src.GetHandle(), dst.GetHandle(), 1, &copy_region);
+  TransferOwnership(dst, dst_offset, size);
+}
+
+void UploadBatch::UploadImage(VkImage image, const void* data, uint32_t width, uint32_t height, uint32_t texel_size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  const VkDeviceSize row_size = static_cast<VkDeviceSize>(width) * texel_size;
+  if (row_size > staging_ring_.GetSize()) {
+    throw std::invalid_argument{"Image row larger than the staging ring!"};
+  }
+  // Buffer offsets of image copies must be a multiple of the texel size
+  const VkDeviceSize alignment = std::lcm(StagingRing::kDefaultAlignment, static_cast<VkDeviceSize>(texel_size));
+  const auto rows_per_chunk =
+      static_cast<uint32_t>(std::max<VkDeviceSize>(staging_ring_.GetMaxChunkSize() / row_size, 1));
+
+  TransitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+  for (uint32_t row = 0; row < height;) {
+    const uint32_t row_count = std::min(height - row, rows_per_chunk);
+    const StagingRing::Region region = Stage(bytes + row * row_size, row_count * row_size, alignment);
+
+    VkBufferImageCopy copy_region{};
+    copy_region.bufferOffset = region.offset;
+    copy_region.bufferRowLength = 0;
+    copy_region.bufferImageHeight = 0;
+    copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy_region.imageSubresource.mipLevel = 0;
+    copy_region.imageSubresource.baseArrayLayer = 0;
+    copy_region.imageSubresource.layerCount = 1;
+    copy_region.imageOffset = {0, static_cast<int32_t>(row), 0};
+    copy_region.imageExtent = {width, row_count, 1};
+    vkCmdCopyBufferToImage(GetCommandBuffer(), region.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                           &copy_region);
+
+    row += row_count;
+  }
+
+  if (!device_.HasDedicatedTransferQueue()) {
+    TransitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    return;
+  }
+  // The layout transition happens as part of the ownership transfer
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcQueueFamilyIndex = device_.GetTransferQueueFamilyIndex();
+  barrier.dstQueueFamilyIndex = device_.GetGraphicsQueueFamilyIndex();
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+  image_ownership_transfers_.push_back(barrier);
+}
+
+void UploadBatch::TransitionImageLayout(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout) {
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+
+  VkPipelineStageFlags source_stage;
+  VkPipelineStageFlags destination_stage;
+
+  if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
+             new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  } else {
+    throw std::invalid_argument{"Unsupported layout transition!"};
+  }
+
+  vkCmdPipelineBarrier(GetCommandBuffer(), source_stage, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+uint64_t UploadBatch::Submit() {
+  constexpr VkAccessFlags kReadAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+                                            VK_ACCESS_SHADER_READ_BIT;
+  constexpr VkPipelineStageFlags kReadStageMask = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                                                  VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                                  VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+  VkCommandBuffer command_buffer = GetCommandBuffer();
+  command_buffer_ = VK_NULL_HANDLE;
+
+  if (!device_.HasDedicatedTransferQueue()) {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = kReadAccessMask;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, kReadStageMask, 0, 1, &barrier, 0, nullptr,
+                         0, nullptr);
+    return staging_ring_.Submit(command_buffer);
+  }
+
+  if (buffer_ownership_transfers_.empty() && image_ownership_transfers_.empty()) {
+    return staging_ring_.Submit(command_buffer);
+  }
+
+  // Release on the transfer queue...
+  for (auto& barrier : buffer_ownership_transfers_) {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+  }
+  for (auto& barrier : image_ownership_transfers_) {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+  }
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0,
+                       nullptr, static_cast<uint32_t>(buffer_ownership_transfers_.size()),
+                       buffer_ownership_transfers_.data(), static_cast<uint32_t>(image_ownership_transfers_.size()),
+                       image_ownership_transfers_.data());
+
+  // ...and acquire on the graphics queue once the transfer has signalled
+  for (auto& barrier : buffer_ownership_transfers_) {
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = kReadAccessMask;
+  }
+  for (auto& barrier : image_ownership_transfers_) {
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  }
+  VkCommandBuffer acquire_command_buffer = staging_ring_.BeginAcquireCommands();
+  vkCmdPipelineBarrier(acquire_command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, kReadStageMask, 0, 0, nullptr,
+                       static_cast<uint32_t>(buffer_ownership_transfers_.size()), buffer_ownership_transfers_.data(),
+                       static_cast<uint32_t>(image_ownership_transfers_.size()), image_ownership_transfers_.data());
+
+  buffer_ownership_transfers_.clear();
+  image_ownership_transfers_.clear();
+  return staging_ring_.Submit(command_buffer, acquire_command_buffer);
+}
+
+VkCommandBuffer UploadBatch::GetCommandBuffer() {
+  if (command_buffer_ == VK_NULL_HANDLE) {
+    command_buffer_ = staging_ring_.BeginCommands();
+  }
+  return command_buffer_;
+}
+
+void UploadBatch::TransferOwnership(const Buffer& buffer, VkDeviceSize offset, VkDeviceSize size) {
+  if (!device_.HasDedicatedTransferQueue()) {
+    return;
+  }
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcQueueFamilyIndex = device_.GetTransferQueueFamilyIndex();
+  barrier.dstQueueFamilyIndex = device_.GetGraphicsQueueFamilyIndex();
+  barrier.buffer = buffer.GetHandle();
+  barrier.offset = offset;
+  barrier.size = size;
+  buffer_ownership_transfers_.push_back(barrier);
+}
+
+StagingRing::Region UploadBatch::Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment) {
+  GetCommandBuffer();
+  auto region = staging_ring_.TryAcquire(size, alignment);
+  if (!region) {
+    // Hand the commands recorded so far over to the GPU so that their regions can be recycled.
+    // The barrier recorded by the final Submit() still covers these copies, since they precede it in submission order.
+    staging_ring_.Submit(command_buffer_);
+    command_buffer_ = VK_NULL_HANDLE;
+    GetCommandBuffer();
+    region = staging_ring_.Acquire(size, alignment);
+  }
+  std::memcpy(region->mapped, data, size);
+  staging_ring_.Flush(*region);
+  return *region;
+}
+
+}  // namespace engine
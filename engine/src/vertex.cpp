@@ -1,39 +1,120 @@
 #include "engine/vertex.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <glm/gtc/packing.hpp>
+
+namespace {
+int16_t EncodeSnorm16(float value) {
+  return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+uint16_t EncodeUnorm16(float value) {
+  return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+// Octahedral mapping of a unit vector onto [-1, 1]^2, decoded in model_quantized.vert
+glm::vec2 EncodeOctahedral(glm::vec3 normal) {
+  const float norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  if (norm == 0.0f) {
+    return {0.0f, 0.0f};
+  }
+  normal /= norm;
+  if (normal.z >= 0.0f) {
+    return {normal.x, normal.y};
+  }
+  return {(1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f),
+          (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f)};
+}
+}  // namespace
+
 namespace engine {
-std::array<VkVertexInputBindingDescription, 1> Vertex::BindingDescriptions() {
-  return {{{
-      .binding = 0,
-      .stride = sizeof(Vertex),
-      .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-  }}};
+glm::mat4 VertexDequantization::PositionMat4() const {
+  glm::mat4 mat4{1.0f};
+  mat4[0][0] = position_scale.x;
+  mat4[1][1] = position_scale.y;
+  mat4[2][2] = position_scale.z;
+  mat4[3] = glm::vec4{position_offset, 1.0f};
+  return mat4;
 }
 
-std::array<VkVertexInputAttributeDescription, 4> Vertex::AttributeDescriptions() {
-  return {{{
-               .location = 0,
-               .binding = 0,
-               .format = VK_FORMAT_R32G32B32_SFLOAT,
-               .offset = offsetof(Vertex, position),
-           },
-           {
-               .location = 1,
-               .binding = 0,
-               .format = VK_FORMAT_R32G32B32_SFLOAT,
-               .offset = offsetof(Vertex, normal),
-           },
-           {
-               .location = 2,
-               .binding = 0,
-               .format = VK_FORMAT_R32G32B32_SFLOAT,
-               .offset = offsetof(Vertex, color),
-           },
-           {
-               .location = 3,
-               .binding = 0,
-               .format = VK_FORMAT_R32G32_SFLOAT,
-               .offset = offsetof(Vertex, uv),
-           }}};
+std::vector<uint8_t> EncodeVertices(const std::vector<Vertex>& vertices, VertexFormat format,
+                                    VertexDequantization& dequantization) {
+  dequantization = {};
+  std::vector<uint8_t> bytes(vertices.size() * GetVertexStride(format));
+  if (format == VertexFormat::kFloat32) {
+    std::memcpy(bytes.data(), vertices.data(), bytes.size());
+    return bytes;
+  }
+
+  glm::vec3 position_min{std::numeric_limits<float>::max()};
+  glm::vec3 position_max{std::numeric_limits<float>::lowest()};
+  glm::vec2 uv_min{std::numeric_limits<float>::max()};
+  glm::vec2 uv_max{std::numeric_limits<float>::lowest()};
+  for (const Vertex& vertex : vertices) {
+    position_min = glm::min(position_min, vertex.position);
+    position_max = glm::max(position_max, vertex.position);
+    uv_min = glm::min(uv_min, vertex.uv);
+    uv_max = glm::max(uv_max, vertex.uv);
+  }
+  // Flat extents keep a unit scale to avoid dividing by zero
+  const glm::vec3 position_extent = (position_max - position_min) * 0.5f;
+  const glm::vec2 uv_extent = uv_max - uv_min;
+  dequantization.position_offset = (position_min + position_max) * 0.5f;
+  dequantization.position_scale = {position_extent.x > 0.0f ? position_extent.x : 1.0f,
+                                   position_extent.y > 0.0f ? position_extent.y : 1.0f,
+                                   position_extent.z > 0.0f ? position_extent.z : 1.0f};
+  dequantization.uv_transform = {uv_extent.x > 0.0f ? uv_extent.x : 1.0f, uv_extent.y > 0.0f ? uv_extent.y : 1.0f,
+                                 uv_min.x, uv_min.y};
+
+  auto* quantized_vertices = reinterpret_cast<QuantizedVertex*>(bytes.data());
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const Vertex& vertex = vertices[i];
+    QuantizedVertex& quantized_vertex = quantized_vertices[i];
+
+    const glm::vec3 position = (vertex.position - dequantization.position_offset) / dequantization.position_scale;
+    for (uint32_t j = 0; j < 3; ++j) {
+      quantized_vertex.position[j] = format == VertexFormat::kSnorm16
+                                         ? static_cast<uint16_t>(EncodeSnorm16(position[j]))
+                                         : glm::packHalf1x16(position[j]);
+    }
+    const glm::vec2 normal = EncodeOctahedral(vertex.normal);
+    quantized_vertex.normal = {EncodeSnorm16(normal.x), EncodeSnorm16(normal.y)};
+    const glm::vec2 uv = (vertex.uv - glm::vec2{dequantization.uv_transform.z, dequantization.uv_transform.w}) /
+                         glm::vec2{dequantization.uv_transform.x, dequantization.uv_transform.y};
+    quantized_vertex.uv = {EncodeUnorm16(uv.x), EncodeUnorm16(uv.y)};
+  }
+  return bytes;
 }
 
+std::array<std::vector<uint8_t>, 2> SplitVertexStreams(const std::vector<uint8_t>& encoded_vertices,
+                                                       VertexFormat format) {
+  return VisitVertexFormat(format, [&encoded_vertices]<typename Traits>() {
+    using Layout = typename Traits::Layout;
+    using SplitLayout = typename Traits::SplitLayout;
+    static_assert(Layout::kAttributeCount == SplitLayout::kAttributeCount && SplitLayout::kBindingCount == 2);
+
+    constexpr auto kSources = Layout::AttributeDescriptions();
+    constexpr auto kDestinations = SplitLayout::AttributeDescriptions();
+    constexpr auto kSizes = Layout::AttributeSizes();
+    constexpr uint32_t kStride = Layout::StrideOf();
+    constexpr std::array<uint32_t, 2> kStreamStrides{SplitLayout::template StrideOf<0>(),
+                                                     SplitLayout::template StrideOf<1>()};
+
+    const size_t vertex_count = encoded_vertices.size() / kStride;
+    std::array<std::vector<uint8_t>, 2> streams{std::vector<uint8_t>(vertex_count * kStreamStrides[0]),
+                                                std::vector<uint8_t>(vertex_count * kStreamStrides[1])};
+    for (size_t i = 0; i < vertex_count; ++i) {
+      for (uint32_t j = 0; j < Layout::kAttributeCount; ++j) {
+        const uint32_t binding = kDestinations[j].binding;
+        std::memcpy(streams[binding].data() + i * kStreamStrides[binding] + kDestinations[j].offset,
+                    encoded_vertices.data() + i * kStride + kSources[j].offset, kSizes[j]);
+      }
+    }
+    return streams;
+  });
+}
 }  // namespace engine
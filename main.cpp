@@ -1,20 +1,24 @@
 #include <cstdlib>
 #include <iostream>
+#include <utility>
 
 #include "engine/application.h"
 #include "engine/mesh.h"
+#include "engine/upload_batch.h"
 #include "engine/vertex.h"
 
 class HelloTriangleApplication : public engine::Application {
  public:
   explicit HelloTriangleApplication(const engine::ApplicationInfo& application_info = {.title = "Hello Triangle"})
       : engine::Application{application_info} {
-//    models_.emplace_back(engine::Model::CreateFromFile(device_, "assets/viking_room.obj"));
-//    models_.back()->AttachTexture(engine::Texture::CreateFromFile(texture_manager_, "assets/viking_room.png"));
+//    engine::Model viking_room = engine::Model::CreateFromFile(mesh_manager_, "assets/viking_room.obj");
+//    viking_room.AttachTexture(engine::Texture::CreateFromFile(texture_manager_, "assets/viking_room.png"));
+//    models_.Insert(std::move(viking_room));
 
-    models_.push_back(std::make_unique<engine::Model>());
-    models_.back()->AttachMesh(engine::Mesh::CreateSphereMesh(device_, 512));
-    models_.back()->AttachTexture(engine::Texture::CreateFromFile(texture_manager_, "assets/earth.jpg"));
+    procedural_spheres_.Insert({
+        .cube_face_resolution = 512,
+        .texture = engine::Texture::CreateFromFile(texture_manager_, "assets/earth.jpg"),
+    });
   }
 
   void OnFrame(float frame_time) override {}
@@ -19,16 +19,23 @@ layout (set = 0, binding = 0) uniform UniformBufferObject {
   vec4 lightColor;  // w is intensity
 } ubo;
 
-layout (push_constant) uniform PushConstant {
+struct ObjectData {
   mat4 model;
-} pushConstant;
+  mat4 normal;
+  vec4 uvTransform;  // xy scale, zw offset
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer ObjectBuffer {
+  ObjectData objects[];
+} objectBuffer;
 
 void main() {
-  vec4 positionWorld = pushConstant.model * vec4(position, 1.0);
+  ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+  vec4 positionWorld = object.model * vec4(position, 1.0);
   gl_Position = ubo.projection * ubo.view * positionWorld;
 
   fragPosition = positionWorld.xyz;
-  fragNormal = normalize(mat3(pushConstant.model) * normal);
+  fragNormal = normalize(mat3(object.normal) * normal);
   fragColor = color;
-  fragUV = uv;
+  fragUV = uv * object.uvTransform.xy + object.uvTransform.zw;
 }
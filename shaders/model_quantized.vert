@@ -0,0 +1,49 @@
+#version 450
+
+// Quantized vertices, see engine::QuantizedVertex. The position is dequantized by the model matrix.
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 octahedralNormal;
+layout (location = 3) in vec2 uv;
+
+layout (location = 0) out vec3 fragPosition;
+layout (location = 1) out vec3 fragNormal;
+layout (location = 2) out vec3 fragColor;
+layout (location = 3) out vec2 fragUV;
+
+layout (set = 0, binding = 0) uniform UniformBufferObject {
+  mat4 projection;
+  mat4 view;
+
+  vec4 ambientLightColor;  // w is intensity
+  vec3 lightPosition;
+  vec4 lightColor;  // w is intensity
+} ubo;
+
+struct ObjectData {
+  mat4 model;
+  mat4 normal;
+  vec4 uvTransform;  // xy scale, zw offset
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer ObjectBuffer {
+  ObjectData objects[];
+} objectBuffer;
+
+vec3 DecodeOctahedral(vec2 e) {
+  vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-v.z, 0.0);
+  v.x += v.x >= 0.0 ? -t : t;
+  v.y += v.y >= 0.0 ? -t : t;
+  return normalize(v);
+}
+
+void main() {
+  ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+  vec4 positionWorld = object.model * vec4(position, 1.0);
+  gl_Position = ubo.projection * ubo.view * positionWorld;
+
+  fragPosition = positionWorld.xyz;
+  fragNormal = normalize(mat3(object.normal) * DecodeOctahedral(octahedralNormal));
+  fragColor = vec3(1.0);
+  fragUV = uv * object.uvTransform.xy + object.uvTransform.zw;
+}
@@ -0,0 +1,99 @@
+#version 450
+
+// Cube-sphere without vertex or index buffers, see engine::systems::ProceduralSphereRenderSystem. Every 6 vertices are
+// a quad of a cube face grid, triangulated and mapped like engine::Mesh::CreateSphereMesh().
+layout (location = 0) out vec3 fragPosition;
+layout (location = 1) out vec3 fragNormal;
+layout (location = 2) out vec3 fragColor;
+layout (location = 3) out vec2 fragUV;
+
+layout (set = 0, binding = 0) uniform UniformBufferObject {
+  mat4 projection;
+  mat4 view;
+
+  vec4 ambientLightColor;  // w is intensity
+  vec3 lightPosition;
+  vec4 lightColor;  // w is intensity
+} ubo;
+
+layout (push_constant) uniform PushConstants {
+  mat4 model;
+  uint cubeFaceResolution;  // Grid points along a cube face edge
+} pushConstants;
+
+// Cube faces spanning [-1, 1]: origin, then the u and v edges
+const vec3 FACE_ORIGINS[6] = vec3[](
+vec3(-1.0, -1.0, -1.0),
+vec3(1.0, -1.0, -1.0),
+vec3(-1.0, -1.0, -1.0),
+vec3(-1.0, -1.0, 1.0),
+vec3(-1.0, -1.0, -1.0),
+vec3(-1.0, 1.0, -1.0)
+);
+const vec3 FACE_US[6] = vec3[](
+vec3(2.0, 0.0, 0.0),
+vec3(0.0, 0.0, 2.0),
+vec3(0.0, 0.0, 2.0),
+vec3(0.0, 2.0, 0.0),
+vec3(0.0, 2.0, 0.0),
+vec3(2.0, 0.0, 0.0)
+);
+const vec3 FACE_VS[6] = vec3[](
+vec3(0.0, 2.0, 0.0),
+vec3(0.0, 2.0, 0.0),
+vec3(2.0, 0.0, 0.0),
+vec3(2.0, 0.0, 0.0),
+vec3(0.0, 0.0, 2.0),
+vec3(0.0, 0.0, 2.0)
+);
+
+// Quad corners (u, v) of the triangles (0, 0) (0, 1) (1, 1) and (0, 0) (1, 1) (1, 0)
+const uvec2 CORNERS[6] = uvec2[](
+uvec2(0, 0),
+uvec2(0, 1),
+uvec2(1, 1),
+uvec2(0, 0),
+uvec2(1, 1),
+uvec2(1, 0)
+);
+
+const float PI = 3.14159265358979;
+
+// See engine::sphere_math::CubeToSphere()
+vec3 CubeToSphere(vec3 p) {
+  vec3 p2 = p * p;
+  return p * sqrt(1.0 - (p2.yxx + p2.zzy) / 2.0 + (p2.yxx * p2.zzy) / 3.0);
+}
+
+// See engine::sphere_math::SphereToUV()
+vec2 SphereToUV(vec3 p) {
+  return vec2(-0.5 - atan(p.z, p.x) / (2.0 * PI), 0.5 - asin(clamp(p.y, -1.0, 1.0)) / PI);
+}
+
+vec3 ToSphere(uint face, vec2 gridPoint) {
+  vec2 t = gridPoint / float(pushConstants.cubeFaceResolution - 1);
+  return CubeToSphere(FACE_ORIGINS[face] + FACE_US[face] * t.x + FACE_VS[face] * t.y);
+}
+
+void main() {
+  uint quadsPerRow = pushConstants.cubeFaceResolution - 1;
+  uint quad = uint(gl_VertexIndex) / 6;
+  uint face = quad / (quadsPerRow * quadsPerRow);
+  uint faceQuad = quad % (quadsPerRow * quadsPerRow);
+  uvec2 quadOrigin = uvec2(faceQuad / quadsPerRow, faceQuad % quadsPerRow);
+
+  vec3 position = ToSphere(face, vec2(quadOrigin + CORNERS[uint(gl_VertexIndex) % 6]));
+  vec4 positionWorld = pushConstants.model * vec4(position, 1.0);
+  gl_Position = ubo.projection * ubo.view * positionWorld;
+
+  // The texture's U wraps around, every corner of a quad takes the side of the quad's center so that no triangle
+  // interpolates across the whole texture
+  vec2 uv = SphereToUV(position);
+  float centerU = SphereToUV(ToSphere(face, vec2(quadOrigin) + 0.5)).x;
+  uv.x += round(centerU - uv.x);
+
+  fragPosition = positionWorld.xyz;
+  fragNormal = normalize(mat3(pushConstants.model) * position);
+  fragColor = vec3(1.0);
+  fragUV = uv;
+}
@@ -0,0 +1,58 @@
+#include <random>
+#include <vector>
+
+#include "engine/bounds.h"
+#include "test.h"
+
+namespace {
+// The box is the exact per-axis extremes and the sphere contains every vertex, for counts that leave the vectorized
+// reduction each possible tail
+void TestContainment() {
+  std::mt19937 random{1};
+  std::uniform_real_distribution<float> distribution{-3.0f, 5.0f};
+  for (const size_t count : {1, 2, 3, 4, 5, 7, 1000, 4097}) {
+    std::vector<engine::Vertex> vertices(count);
+    for (engine::Vertex& vertex : vertices) {
+      vertex.position = {distribution(random), 0.3f * distribution(random), distribution(random)};
+      // Read along with the position by the reduction, must not leak into the box
+      vertex.normal = {1e9f, -1e9f, 0.0f};
+    }
+    const engine::Bounds bounds = engine::ComputeBounds(vertices);
+
+    glm::vec3 min = vertices[0].position;
+    glm::vec3 max = vertices[0].position;
+    float box_sphere_radius = 0.0f;
+    for (const engine::Vertex& vertex : vertices) {
+      min = glm::min(min, vertex.position);
+      max = glm::max(max, vertex.position);
+    }
+    for (const engine::Vertex& vertex : vertices) {
+      box_sphere_radius = std::max(box_sphere_radius, glm::length(vertex.position - (min + max) * 0.5f));
+      CHECK(glm::length(vertex.position - bounds.sphere.center) <= bounds.sphere.radius);
+    }
+    CHECK(bounds.box.min == min);
+    CHECK(bounds.box.max == max);
+    // No worse than the sphere around the box's center
+    CHECK(bounds.sphere.radius <= box_sphere_radius);
+  }
+}
+
+void TestTransformed() {
+  const engine::Bounds bounds{
+      .box = {.min = {-1.0f, -1.0f, -1.0f}, .max = {1.0f, 2.0f, 3.0f}},
+      .sphere = {.center = {0.0f, 0.5f, 1.0f}, .radius = 2.0f},
+  };
+  // A negative scale mirrors the box, whose bounds swap
+  const engine::Bounds transformed = bounds.Transformed({.translation = {1.0f, 0.0f, 0.0f}, .scale = -2.0f});
+  CHECK(transformed.box.min == glm::vec3(-1.0f, -4.0f, -6.0f));
+  CHECK(transformed.box.max == glm::vec3(3.0f, 2.0f, 2.0f));
+  CHECK(transformed.sphere.center == glm::vec3(1.0f, -1.0f, -2.0f));
+  CHECK(transformed.sphere.radius == 4.0f);
+}
+}  // namespace
+
+int main() {
+  TestContainment();
+  TestTransformed();
+  return test::Finish();
+}
@@ -0,0 +1,141 @@
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "engine/free_list_allocator.h"
+#include "test.h"
+
+namespace {
+using ResourceKind = engine::FreeListAllocator::ResourceKind;
+
+bool FreeThrows(engine::FreeListAllocator& allocator, uint64_t offset) {
+  try {
+    allocator.Free(offset);
+  } catch (const std::invalid_argument&) {
+    return true;
+  }
+  return false;
+}
+
+void TestAlignment() {
+  engine::FreeListAllocator allocator{1 << 20};
+  std::mt19937 random{5};
+  std::vector<uint64_t> offsets;
+  for (uint32_t i = 0; i < 200; ++i) {
+    const uint64_t size = 1 + random() % 1000;
+    const uint64_t alignment = uint64_t{1} << (random() % 9);
+    const std::optional<uint64_t> offset = allocator.Allocate(size, alignment);
+    CHECK(offset && *offset % alignment == 0 && *offset + size <= allocator.GetSize());
+    if (offset) {
+      offsets.push_back(*offset);
+    }
+    // Frees some to reuse the holes left
+    if (i % 3 == 2) {
+      const size_t freed = random() % offsets.size();
+      allocator.Free(offsets[freed]);
+      offsets[freed] = offsets.back();
+      offsets.pop_back();
+    }
+  }
+}
+
+void TestGranularity() {
+  // A linear allocation pushes an optimal one after it onto the next page and vice versa, the same kind packs tightly
+  for (const auto& [first, second] : {std::pair{ResourceKind::kLinear, ResourceKind::kOptimal},
+                                     std::pair{ResourceKind::kOptimal, ResourceKind::kLinear}}) {
+    engine::FreeListAllocator allocator{4096, 1024};
+    CHECK(allocator.Allocate(100, 1, first) == 0);
+    CHECK(allocator.Allocate(100, 1, first) == 100);
+    CHECK(allocator.Allocate(100, 1, second) == 1024);
+    CHECK(allocator.Allocate(100, 1, second) == 1124);
+  }
+
+  // A free range followed by an optimal allocation on the same page can't end with a linear one on that page
+  engine::FreeListAllocator allocator{4096, 1024};
+  CHECK(allocator.Allocate(1600, 1, ResourceKind::kLinear) == 0);
+  const std::optional<uint64_t> optimal = allocator.Allocate(100, 1, ResourceKind::kOptimal);
+  CHECK(optimal == 2048);
+  CHECK(allocator.Allocate(100, 1, ResourceKind::kOptimal) == 2148);
+  allocator.Free(*optimal);  // Leaves [1600, 2148) free before the optimal allocation at 2148
+  // [1600, 2148) is the best fit, but [1600, 2100) would share the optimal allocation's page
+  CHECK(allocator.Allocate(500, 1, ResourceKind::kLinear) == 3072);
+  // Once the smaller [3572, 4096) is taken, [1600, 2000) ending on the page before is fine
+  CHECK(allocator.Allocate(400, 1, ResourceKind::kLinear) == 3572);
+  CHECK(allocator.Allocate(400, 1, ResourceKind::kLinear) == 1600);
+}
+
+void TestBestFit() {
+  engine::FreeListAllocator allocator{1000};
+  CHECK(allocator.Allocate(100) == 0);
+  const std::optional<uint64_t> medium = allocator.Allocate(200);
+  CHECK(allocator.Allocate(100) == 300);
+  const std::optional<uint64_t> small = allocator.Allocate(50);
+  CHECK(allocator.Allocate(50) == 450);
+  allocator.Free(*medium);  // [100, 300)
+  allocator.Free(*small);  // [400, 450), with [500, 1000) still free
+
+  CHECK(allocator.Allocate(40) == 400);
+  CHECK(allocator.Allocate(150) == 100);
+  CHECK(allocator.Allocate(400) == 500);
+  // What is left is [250, 300), [440, 450) and [900, 1000)
+  CHECK(allocator.QueryStatistics().free_range_count == 3);
+  CHECK(!allocator.Allocate(200));
+  CHECK(!allocator.Allocate(100, 16));
+  CHECK(allocator.Allocate(100) == 900);
+  CHECK(allocator.QueryStatistics().largest_free_range == 50);
+}
+
+void TestCoalescing() {
+  engine::FreeListAllocator allocator{1000};
+  const std::optional<uint64_t> a = allocator.Allocate(100);
+  const std::optional<uint64_t> b = allocator.Allocate(100);
+  const std::optional<uint64_t> c = allocator.Allocate(100);
+  CHECK(allocator.QueryStatistics().free_range_count == 1);
+  CHECK(allocator.QueryStatistics().largest_free_range == 700);
+
+  allocator.Free(*a);
+  CHECK(allocator.QueryStatistics().free_range_count == 2);
+  // With the next free range
+  allocator.Free(*c);
+  CHECK(allocator.QueryStatistics().free_range_count == 2);
+  CHECK(allocator.QueryStatistics().largest_free_range == 800);
+  // With both
+  allocator.Free(*b);
+  const engine::FreeListAllocator::Statistics statistics = allocator.QueryStatistics();
+  CHECK(statistics.free_range_count == 1);
+  CHECK(statistics.largest_free_range == 1000);
+  CHECK(statistics.used == 0 && statistics.allocation_count == 0);
+  CHECK(allocator.IsEmpty());
+
+  // With the previous free range
+  const std::optional<uint64_t> d = allocator.Allocate(100);
+  const std::optional<uint64_t> e = allocator.Allocate(100);
+  allocator.Free(*d);
+  allocator.Free(*e);
+  CHECK(allocator.QueryStatistics().free_range_count == 1);
+  CHECK(allocator.QueryStatistics().largest_free_range == 1000);
+}
+
+void TestInvalidFree() {
+  engine::FreeListAllocator allocator{1000};
+  const std::optional<uint64_t> a = allocator.Allocate(100);
+  CHECK(allocator.Allocate(100) == 100);
+  CHECK(FreeThrows(allocator, 50));
+  CHECK(FreeThrows(allocator, 200));  // The free range after the allocations
+  allocator.Free(*a);
+  CHECK(FreeThrows(allocator, *a));
+  CHECK(allocator.GetAllocationCount() == 1 && allocator.GetUsed() == 100);
+}
+}  // namespace
+
+int main() {
+  TestAlignment();
+  TestGranularity();
+  TestBestFit();
+  TestCoalescing();
+  TestInvalidFree();
+  return test::Finish();
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "engine/index_codec.h"
+#include "engine/mesh_optimizer.h"
+#include "test.h"
+#include "test_mesh.h"
+
+namespace {
+// Decodes to the same triangles with the same winding, each possibly rotated
+bool IsSameTriangleList(const std::vector<uint32_t>& expected, const std::vector<uint32_t>& indices) {
+  if (expected.size() != indices.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < expected.size(); i += 3) {
+    bool same = false;
+    for (size_t rotation = 0; rotation < 3; ++rotation) {
+      same |= indices[i] == expected[i + rotation] && indices[i + 1] == expected[i + (rotation + 1) % 3] &&
+              indices[i + 2] == expected[i + (rotation + 2) % 3];
+    }
+    if (!same) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Throws(const std::vector<uint8_t>& data, size_t size, uint32_t index_count) {
+  try {
+    static_cast<void>(engine::DecodeIndices(data.data(), size, index_count));
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+void TestRoundTrip() {
+  test::MeshData mesh = test::CreateUvSphere(48, 64);
+  engine::OptimizeMesh(mesh.vertices, mesh.indices);
+  std::vector<uint32_t> shuffled_indices = mesh.indices;
+  std::vector<uint32_t> triangles(shuffled_indices.size() / 3);
+  for (uint32_t i = 0; i < triangles.size(); ++i) {
+    triangles[i] = i;
+  }
+  std::shuffle(triangles.begin(), triangles.end(), std::mt19937{2});
+  for (uint32_t i = 0; i < triangles.size(); ++i) {
+    std::copy_n(mesh.indices.begin() + 3 * triangles[i], 3, shuffled_indices.begin() + 3 * i);
+  }
+
+  for (const std::vector<uint32_t>& indices : {mesh.indices, shuffled_indices, std::vector<uint32_t>{}}) {
+    const std::vector<uint8_t> encoded = engine::EncodeIndices(indices);
+    const auto index_count = static_cast<uint32_t>(indices.size());
+    CHECK(IsSameTriangleList(indices, engine::DecodeIndices(encoded.data(), encoded.size(), index_count)));
+  }
+}
+
+void TestInvalidData() {
+  const test::MeshData mesh = test::CreateUvSphere(8, 8);
+  const std::vector<uint8_t> encoded = engine::EncodeIndices(mesh.indices);
+  const auto index_count = static_cast<uint32_t>(mesh.indices.size());
+  CHECK(Throws(encoded, encoded.size() - 1, index_count));
+  CHECK(Throws(encoded, encoded.size(), index_count + 1));
+  CHECK(Throws(encoded, encoded.size(), index_count + 3));
+  // Rejected before the indices are allocated
+  CHECK(Throws(encoded, encoded.size(), 0xFFFFFFFF - 0xFFFFFFFF % 3));
+}
+}  // namespace
+
+int main() {
+  TestRoundTrip();
+  TestInvalidData();
+  return test::Finish();
+}
@@ -0,0 +1,130 @@
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "engine/mesh_bvh.h"
+#include "test.h"
+#include "test_mesh.h"
+
+namespace {
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+// Moller-Trumbore against every triangle
+std::optional<engine::RayHit> IntersectBruteForce(const test::MeshData& mesh, const engine::Ray& ray) {
+  std::optional<engine::RayHit> nearest;
+  float max_t = ray.max_t;
+  for (uint32_t triangle = 0; triangle < mesh.indices.size() / 3; ++triangle) {
+    const glm::vec3& v0 = mesh.vertices[mesh.indices[3 * triangle + 0]].position;
+    const glm::vec3 e1 = mesh.vertices[mesh.indices[3 * triangle + 1]].position - v0;
+    const glm::vec3 e2 = mesh.vertices[mesh.indices[3 * triangle + 2]].position - v0;
+    const glm::vec3 p = glm::cross(ray.direction, e2);
+    const float determinant = glm::dot(e1, p);
+    if (determinant == 0.0f) {
+      continue;
+    }
+    const glm::vec3 s = ray.origin - v0;
+    const float u = glm::dot(s, p) / determinant;
+    const glm::vec3 q = glm::cross(s, e1);
+    const float v = glm::dot(ray.direction, q) / determinant;
+    const float t = glm::dot(e2, q) / determinant;
+    if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= max_t) {
+      max_t = t;
+      nearest = engine::RayHit{.t = t, .triangle = triangle, .barycentrics = {u, v}};
+    }
+  }
+  return nearest;
+}
+
+// Hits within a relative tolerance, rays grazing an edge may hit or miss depending on the order of operations
+uint32_t CountMismatches(const test::MeshData& mesh, const engine::MeshBvh& bvh, const std::vector<engine::Ray>& rays) {
+  uint32_t mismatch_count = 0;
+  for (const engine::Ray& ray : rays) {
+    const std::optional<engine::RayHit> expected = IntersectBruteForce(mesh, ray);
+    const std::optional<engine::RayHit> hit = bvh.Intersect(ray);
+    if (hit.has_value() != expected.has_value() || bvh.IntersectsAny(ray) != expected.has_value() ||
+        (hit && std::abs(hit->t - expected->t) > 1e-5f * std::max(1.0f, expected->t))) {
+      ++mismatch_count;
+    }
+  }
+  return mismatch_count;
+}
+
+// Rays from a sphere around the mesh towards random points within its bounds, some of them axis-aligned
+std::vector<engine::Ray> CreateRays(uint32_t count, float max_t) {
+  std::mt19937 random{7};
+  std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+  std::vector<engine::Ray> rays(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const glm::vec3 origin =
+        3.0f * glm::normalize(glm::vec3{distribution(random), distribution(random), distribution(random)});
+    const glm::vec3 target{distribution(random), distribution(random), distribution(random)};
+    rays[i] = {.origin = origin, .direction = target - origin, .max_t = max_t};
+    if (i % 8 == 0) {
+      rays[i] = {.origin = {target.x, target.y, 3.0f}, .direction = {0.0f, 0.0f, -1.0f}, .max_t = max_t};
+    }
+  }
+  return rays;
+}
+
+test::MeshData CreateTriangleSoup(uint32_t triangle_count) {
+  std::mt19937 random{3};
+  std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+  test::MeshData mesh;
+  for (uint32_t i = 0; i < 3 * triangle_count; ++i) {
+    engine::Vertex vertex{};
+    vertex.position = {distribution(random), distribution(random), distribution(random)};
+    if (i % 3 != 0) {
+      vertex.position = mesh.vertices.back().position + 0.2f * vertex.position;
+    }
+    mesh.vertices.push_back(vertex);
+    mesh.indices.push_back(i);
+  }
+  return mesh;
+}
+
+void TestAgainstBruteForce() {
+  for (const test::MeshData& mesh : {test::CreateUvSphere(32, 48), CreateTriangleSoup(3000)}) {
+    const engine::MeshBvh bvh{mesh.vertices, mesh.indices};
+    CHECK(bvh.GetNodeCount() > 1);
+    for (const float max_t : {std::numeric_limits<float>::max(), kInfinity, 0.6f}) {
+      CHECK(CountMismatches(mesh, bvh, CreateRays(2000, max_t)) == 0);
+    }
+  }
+}
+
+// Unused child lanes must not be taken for children whatever the ray's extent, a root with a single leaf has three
+void TestInfiniteMaxT() {
+  for (const uint32_t triangle_count : {1u, 3u, 5u, 17u}) {
+    const test::MeshData mesh = CreateTriangleSoup(triangle_count);
+    const engine::MeshBvh bvh{mesh.vertices, mesh.indices};
+    CHECK(CountMismatches(mesh, bvh, CreateRays(200, kInfinity)) == 0);
+  }
+  const test::MeshData triangle{
+      .vertices = {{.position = {-1.0f, -1.0f, 0.0f}},
+                   {.position = {1.0f, -1.0f, 0.0f}},
+                   {.position = {0.0f, 1.0f, 0.0f}}},
+      .indices = {0, 1, 2},
+  };
+  const engine::MeshBvh bvh{triangle.vertices, triangle.indices};
+  const std::optional<engine::RayHit> hit =
+      bvh.Intersect({.origin = {0.0f, 0.0f, 2.0f}, .direction = {0.0f, 0.0f, -1.0f}, .max_t = kInfinity});
+  CHECK(hit && hit->t == 2.0f && hit->triangle == 0);
+  CHECK(!bvh.IntersectsAny({.origin = {0.0f, 0.0f, 2.0f}, .direction = {0.0f, 0.0f, 1.0f}, .max_t = kInfinity}));
+  CHECK(!bvh.IntersectsAny({.origin = {5.0f, 0.0f, 2.0f}, .direction = {0.0f, 0.0f, -1.0f}, .max_t = kInfinity}));
+}
+
+void TestEmpty() {
+  const engine::MeshBvh bvh{{}, {}};
+  CHECK(bvh.GetNodeCount() == 0);
+  CHECK(!bvh.Intersect({.max_t = kInfinity}));
+}
+}  // namespace
+
+int main() {
+  TestAgainstBruteForce();
+  TestInfiniteMaxT();
+  TestEmpty();
+  return test::Finish();
+}
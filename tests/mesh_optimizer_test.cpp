@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "engine/mesh_optimizer.h"
+#include "test.h"
+#include "test_mesh.h"
+
+namespace {
+using Triangle = std::array<float, 9>;
+
+// Triangles by their corners' positions, each rotated to start at its smallest corner to keep the winding, sorted
+std::vector<Triangle> GetTriangles(const test::MeshData& mesh) {
+  std::vector<Triangle> triangles;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    std::array<glm::vec3, 3> corners{mesh.vertices[mesh.indices[i]].position,
+                                     mesh.vertices[mesh.indices[i + 1]].position,
+                                     mesh.vertices[mesh.indices[i + 2]].position};
+    auto less = [](const glm::vec3& lhs, const glm::vec3& rhs) {
+      return std::tie(lhs.x, lhs.y, lhs.z) < std::tie(rhs.x, rhs.y, rhs.z);
+    };
+    std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end(), less), corners.end());
+    Triangle& triangle = triangles.emplace_back();
+    for (size_t corner = 0; corner < 3; ++corner) {
+      triangle[3 * corner + 0] = corners[corner].x;
+      triangle[3 * corner + 1] = corners[corner].y;
+      triangle[3 * corner + 2] = corners[corner].z;
+    }
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+test::MeshData Shuffle(test::MeshData mesh, uint32_t seed) {
+  std::mt19937 random{seed};
+  std::vector<uint32_t> order(mesh.indices.size() / 3);
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), random);
+  std::vector<uint32_t> indices;
+  for (const uint32_t triangle : order) {
+    indices.insert(indices.end(), mesh.indices.begin() + 3 * triangle, mesh.indices.begin() + 3 * triangle + 3);
+  }
+  mesh.indices = std::move(indices);
+  return mesh;
+}
+
+// Whatever the input order, the optimized grid transforms few vertices more than once. With two triangles per vertex
+// and a 16 entry cache, about 1.2 transforms per vertex is as good as it gets.
+void TestCacheGains() {
+  const test::MeshData grid = test::CreateGrid(64);
+  for (test::MeshData mesh : {grid, Shuffle(grid, 7)}) {
+    const std::vector<Triangle> triangles = GetTriangles(mesh);
+    const engine::MeshOptimizationStatistics statistics = engine::OptimizeMesh(mesh.vertices, mesh.indices);
+    CHECK(statistics.after.acmr < statistics.before.acmr);
+    CHECK(statistics.after.atvr < 1.25f);
+    const engine::VertexCacheStatistics analyzed =
+        engine::AnalyzeVertexCache(mesh.indices, static_cast<uint32_t>(mesh.vertices.size()));
+    CHECK(analyzed.acmr == statistics.after.acmr && analyzed.atvr == statistics.after.atvr);
+    CHECK(GetTriangles(mesh) == triangles);
+  }
+
+  // A lone triangle misses on each corner, the two triangles of a quad share two of them
+  CHECK(engine::AnalyzeVertexCache({0, 1, 2}, 3).acmr == 3.0f);
+  const engine::VertexCacheStatistics strip = engine::AnalyzeVertexCache(test::CreateGrid(1).indices, 4);
+  CHECK(strip.acmr == 2.0f && strip.atvr == 1.0f);
+}
+
+void TestVertexFetch() {
+  test::MeshData mesh = Shuffle(test::CreateUvSphere(16, 24), 3);
+  // Vertices no triangle uses
+  engine::Vertex unused{};
+  unused.position = {5.0f, 5.0f, 5.0f};
+  mesh.vertices.insert(mesh.vertices.begin(), unused);
+  mesh.vertices.push_back(unused);
+  for (uint32_t& index : mesh.indices) {
+    ++index;
+  }
+  const std::vector<Triangle> triangles = GetTriangles(mesh);
+
+  engine::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+  uint32_t next_vertex = 0;
+  bool first_use_order = true;
+  for (const uint32_t index : mesh.indices) {
+    first_use_order &= index <= next_vertex;
+    next_vertex = std::max(next_vertex, index + 1);
+  }
+  CHECK(first_use_order);
+  CHECK(next_vertex == mesh.vertices.size());
+  CHECK(std::none_of(mesh.vertices.begin(), mesh.vertices.end(),
+                     [&](const engine::Vertex& vertex) { return vertex.position == unused.position; }));
+  CHECK(GetTriangles(mesh) == triangles);
+}
+
+// Segments are optimized independently, yet together keep every triangle. Segments of a few grid rows gain less than
+// the whole mesh, a fraction of a row has nothing to gain.
+void TestSegments() {
+  for (const uint32_t segment_triangle_count : {1u, 100u, 1000u, 100000u}) {
+    test::MeshData mesh = test::CreateGrid(48);
+    const std::vector<Triangle> triangles = GetTriangles(mesh);
+    const auto vertex_count = mesh.vertices.size();
+    const engine::MeshOptimizationStatistics statistics =
+        engine::OptimizeMesh(mesh.vertices, mesh.indices, segment_triangle_count);
+    CHECK(mesh.vertices.size() == vertex_count);
+    CHECK(GetTriangles(mesh) == triangles);
+    if (segment_triangle_count >= 1000) {
+      CHECK(statistics.after.acmr < 0.7f * statistics.before.acmr);
+    }
+  }
+}
+}  // namespace
+
+int main() {
+  TestCacheGains();
+  TestVertexFetch();
+  TestSegments();
+  return test::Finish();
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "engine/mesh_simplifier.h"
+#include "test.h"
+#include "test_mesh.h"
+
+namespace {
+bool IsDegenerate(const std::vector<engine::Vertex>& vertices, const uint32_t* triangle) {
+  const glm::vec3& p0 = vertices[triangle[0]].position;
+  const glm::vec3& p1 = vertices[triangle[1]].position;
+  const glm::vec3& p2 = vertices[triangle[2]].position;
+  return p0 == p1 || p1 == p2 || p2 == p0;
+}
+
+// The UV sphere's poles are fans of degenerate triangles, which the simplifier would drop from the first level only
+test::MeshData CreateSphere() {
+  test::MeshData mesh = test::CreateUvSphere(48, 64);
+  std::vector<uint32_t> indices;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    if (!IsDegenerate(mesh.vertices, &mesh.indices[i])) {
+      indices.insert(indices.end(), mesh.indices.begin() + static_cast<std::ptrdiff_t>(i),
+                     mesh.indices.begin() + static_cast<std::ptrdiff_t>(i + 3));
+    }
+  }
+  mesh.indices = std::move(indices);
+  return mesh;
+}
+
+void TestLodChain() {
+  test::MeshData mesh = CreateSphere();
+  const auto vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+  const size_t original_index_count = mesh.indices.size();
+  const std::vector<engine::LodLevel> levels = engine::BuildLodChain(mesh.vertices, mesh.indices);
+  CHECK(levels.size() > 2 && levels.size() <= engine::kMaxLodCount);
+  CHECK(levels[0].first_index == 0 && levels[0].index_count == original_index_count && levels[0].error == 0.0f);
+
+  uint32_t next_index = 0;
+  for (size_t lod = 0; lod < levels.size(); ++lod) {
+    const engine::LodLevel& level = levels[lod];
+    CHECK(level.first_index == next_index);
+    CHECK(level.index_count > 0 && level.index_count % 3 == 0);
+    next_index = level.first_index + level.index_count;
+    bool in_range = true;
+    bool degenerate = false;
+    for (uint32_t i = level.first_index; i < next_index; i += 3) {
+      in_range &= mesh.indices[i] < vertex_count && mesh.indices[i + 1] < vertex_count &&
+                  mesh.indices[i + 2] < vertex_count;
+      degenerate |= in_range && IsDegenerate(mesh.vertices, &mesh.indices[i]);
+    }
+    CHECK(in_range);
+    CHECK(!degenerate);
+    if (lod > 0) {
+      CHECK(4 * static_cast<size_t>(level.index_count) <= 3 * static_cast<size_t>(levels[lod - 1].index_count));
+      CHECK(level.error >= levels[lod - 1].error);
+    }
+  }
+  CHECK(next_index == mesh.indices.size());
+  // A sphere simplified to an eighth of the triangles is still close to it
+  CHECK(levels[1].error > 0.0f && levels[1].error < 0.05f);
+}
+
+// The border only collapses along itself: the remaining open edges lie on the square's sides and the square stays
+// covered without overlaps, as the triangles keep their orientation
+void TestBorder() {
+  const test::MeshData mesh = test::CreateGrid(16);
+  const std::vector<uint32_t> indices = engine::SimplifyMesh(mesh.vertices, mesh.indices, mesh.indices.size() / 8);
+  CHECK(!indices.empty() && indices.size() <= mesh.indices.size() / 8);
+
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> edge_counts;
+  float area = 0.0f;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const glm::vec3& p0 = mesh.vertices[indices[i]].position;
+    const glm::vec3& p1 = mesh.vertices[indices[i + 1]].position;
+    const glm::vec3& p2 = mesh.vertices[indices[i + 2]].position;
+    const float signed_area = 0.5f * glm::cross(p1 - p0, p2 - p0).z;
+    CHECK(signed_area > 0.0f);
+    area += signed_area;
+    for (size_t corner = 0; corner < 3; ++corner) {
+      const uint32_t a = indices[i + corner];
+      const uint32_t b = indices[i + (corner + 1) % 3];
+      ++edge_counts[std::minmax(a, b)];
+    }
+  }
+  CHECK(std::abs(area - 1.0f) < 1e-4f);
+
+  auto on_same_side = [&](uint32_t a, uint32_t b) {
+    const glm::vec3& pa = mesh.vertices[a].position;
+    const glm::vec3& pb = mesh.vertices[b].position;
+    return (pa.x == 0.0f && pb.x == 0.0f) || (pa.x == 1.0f && pb.x == 1.0f) || (pa.y == 0.0f && pb.y == 0.0f) ||
+           (pa.y == 1.0f && pb.y == 1.0f);
+  };
+  float border_length = 0.0f;
+  for (const auto& [edge, count] : edge_counts) {
+    CHECK(count <= 2);
+    if (count == 1) {
+      CHECK(on_same_side(edge.first, edge.second));
+      border_length += glm::length(mesh.vertices[edge.first].position - mesh.vertices[edge.second].position);
+    }
+  }
+  CHECK(std::abs(border_length - 4.0f) < 1e-4f);
+}
+
+// The sphere's UV seam joins wedges with u = 0 to wedges with u = 1 at the same positions. A wedge moved onto the
+// other side's would give a triangle spanning the whole texture. The seam only gives way once little else is left.
+void TestSeam() {
+  const test::MeshData mesh = CreateSphere();
+  for (const size_t target_index_count : {mesh.indices.size() / 8, mesh.indices.size() / 128}) {
+    const std::vector<uint32_t> indices = engine::SimplifyMesh(mesh.vertices, mesh.indices, target_index_count);
+    CHECK(!indices.empty() && indices.size() <= target_index_count);
+    bool torn = false;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      const float u0 = mesh.vertices[indices[i]].uv.x;
+      const float u1 = mesh.vertices[indices[i + 1]].uv.x;
+      const float u2 = mesh.vertices[indices[i + 2]].uv.x;
+      torn |= std::max({u0, u1, u2}) - std::min({u0, u1, u2}) > 0.5f;
+    }
+    CHECK(!torn);
+  }
+}
+}  // namespace
+
+int main() {
+  TestLodChain();
+  TestBorder();
+  TestSeam();
+  return test::Finish();
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "engine/mesh_optimizer.h"
+#include "engine/meshlet.h"
+#include "test.h"
+#include "test_mesh.h"
+
+namespace {
+// Meshlets cover every triangle in order and each stays within the limits, with vertex_count its unique vertices
+void CheckLimits(const test::MeshData& mesh, const std::vector<engine::Meshlet>& meshlets, uint32_t max_vertices,
+                 uint32_t max_triangles) {
+  uint32_t next_triangle = 0;
+  for (const engine::Meshlet& meshlet : meshlets) {
+    CHECK(meshlet.first_triangle == next_triangle);
+    CHECK(meshlet.triangle_count > 0 && meshlet.triangle_count <= max_triangles);
+    std::unordered_set<uint32_t> unique_vertices;
+    for (uint32_t i = 3 * meshlet.first_triangle; i < 3 * (meshlet.first_triangle + meshlet.triangle_count); ++i) {
+      unique_vertices.insert(mesh.indices[i]);
+    }
+    CHECK(meshlet.vertex_count == unique_vertices.size());
+    CHECK(meshlet.vertex_count <= max_vertices);
+    next_triangle = meshlet.first_triangle + meshlet.triangle_count;
+  }
+  CHECK(next_triangle == mesh.indices.size() / 3);
+}
+
+// A backfacing meshlet has no triangle facing the viewer, and its sphere contains its vertices
+void CheckBounds(const test::MeshData& mesh, const std::vector<engine::Meshlet>& meshlets) {
+  const std::vector<glm::vec3> view_positions{{3.0f, 0.0f, 0.0f}, {0.0f, -2.0f, 0.5f}, {1.0f, 1.0f, 1.0f}};
+  for (const engine::Meshlet& meshlet : meshlets) {
+    for (uint32_t triangle = meshlet.first_triangle; triangle < meshlet.first_triangle + meshlet.triangle_count;
+         ++triangle) {
+      const glm::vec3& p0 = mesh.vertices[mesh.indices[3 * triangle + 0]].position;
+      const glm::vec3& p1 = mesh.vertices[mesh.indices[3 * triangle + 1]].position;
+      const glm::vec3& p2 = mesh.vertices[mesh.indices[3 * triangle + 2]].position;
+      for (const glm::vec3& p : {p0, p1, p2}) {
+        CHECK(glm::length(p - meshlet.bounds.center) <= meshlet.bounds.radius * 1.0001f);
+      }
+      const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      for (const glm::vec3& view_position : view_positions) {
+        if (meshlet.bounds.IsBackfacing(view_position)) {
+          CHECK(glm::dot(normal, view_position - p0) <= 0.0f);
+        }
+      }
+    }
+  }
+}
+
+void TestLimits() {
+  test::MeshData mesh = test::CreateUvSphere(96, 128);
+  engine::OptimizeMesh(mesh.vertices, mesh.indices);
+  const std::vector<engine::Meshlet> meshlets = engine::BuildMeshlets(mesh.vertices, mesh.indices);
+  CHECK(!meshlets.empty());
+  CheckLimits(mesh, meshlets, engine::kMaxMeshletVertices, engine::kMaxMeshletTriangles);
+  CheckBounds(mesh, meshlets);
+
+  const std::vector<engine::Meshlet> small_meshlets = engine::BuildMeshlets(mesh.vertices, mesh.indices, 16, 8);
+  CheckLimits(mesh, small_meshlets, 16, 8);
+  CheckBounds(mesh, small_meshlets);
+}
+
+void TestDeterminism() {
+  test::MeshData mesh = test::CreateUvSphere(64, 64);
+  engine::OptimizeMesh(mesh.vertices, mesh.indices);
+  const std::vector<engine::Meshlet> first = engine::BuildMeshlets(mesh.vertices, mesh.indices);
+  const std::vector<engine::Meshlet> second = engine::BuildMeshlets(mesh.vertices, mesh.indices);
+  CHECK(first.size() == second.size());
+  for (size_t i = 0; i < std::min(first.size(), second.size()); ++i) {
+    CHECK(first[i].first_triangle == second[i].first_triangle);
+    CHECK(first[i].triangle_count == second[i].triangle_count);
+    CHECK(first[i].vertex_count == second[i].vertex_count);
+    CHECK(first[i].bounds.center == second[i].bounds.center);
+    CHECK(first[i].bounds.radius == second[i].bounds.radius);
+    CHECK(first[i].bounds.cone_axis == second[i].bounds.cone_axis);
+    CHECK(first[i].bounds.cone_cutoff == second[i].bounds.cone_cutoff);
+  }
+}
+
+void TestEmpty() {
+  CHECK(engine::BuildMeshlets({}, {}).empty());
+}
+}  // namespace
+
+int main() {
+  TestLimits();
+  TestDeterminism();
+  TestEmpty();
+  return test::Finish();
+}
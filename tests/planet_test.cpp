@@ -0,0 +1,82 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "engine/planet.h"
+#include "test.h"
+
+namespace {
+void TestHorizon() {
+  const glm::vec3 camera_position{0.0f, 0.0f, 3.0f};
+  // Points p of the unit sphere with dot(p, camera) >= 1 are visible, i.e. z >= 1/3 from here
+  CHECK(!engine::Planet::IsBehindHorizon({0.0f, 0.0f, 1.0f}, 0.1f, camera_position));
+  CHECK(!engine::Planet::IsBehindHorizon({std::sqrt(0.75f), 0.0f, 0.5f}, 0.0f, camera_position));
+  CHECK(engine::Planet::IsBehindHorizon({1.0f, 0.0f, 0.0f}, 0.0f, camera_position));
+  CHECK(engine::Planet::IsBehindHorizon({0.0f, 0.0f, -1.0f}, 0.5f, camera_position));
+  // Bounds reaching over the horizon are visible
+  CHECK(!engine::Planet::IsBehindHorizon({1.0f, 0.0f, 0.0f}, 0.5f, camera_position));
+  // Nothing is hidden from inside the sphere
+  CHECK(!engine::Planet::IsBehindHorizon({0.0f, 0.0f, -1.0f}, 0.1f, {0.0f, 0.0f, 0.5f}));
+
+  // Conservative: no point of the surface within hidden bounds is visible
+  std::mt19937 random{11};
+  std::normal_distribution<float> normal;
+  std::uniform_real_distribution<float> uniform{0.0f, 1.0f};
+  auto random_direction = [&] { return glm::normalize(glm::vec3{normal(random), normal(random), normal(random)}); };
+  bool visible_point_hidden = false;
+  uint32_t hidden_count = 0;
+  uint32_t tested_count = 0;
+  for (uint32_t i = 0; i < 2000; ++i) {
+    const glm::vec3 camera = random_direction() * (1.0f + 4.0f * uniform(random));
+    const glm::vec3 center = random_direction();
+    const float radius = 0.5f * uniform(random);
+    if (!engine::Planet::IsBehindHorizon(center, radius, camera)) {
+      continue;
+    }
+    ++hidden_count;
+    for (uint32_t j = 0; j < 64; ++j) {
+      const glm::vec3 p = glm::normalize(center + radius * uniform(random) * random_direction());
+      if (glm::length(p - center) <= radius) {
+        visible_point_hidden |= glm::dot(p, camera) >= 1.0f;
+        ++tested_count;
+      }
+    }
+  }
+  CHECK(hidden_count > 100 && tested_count > 1000);
+  CHECK(!visible_point_hidden);
+}
+
+void TestSplit() {
+  const engine::PlanetInfo info{.max_level = 12, .split_distance = 3.0f};
+  // 0.5 across on the cube, so split within 1.5 and merged beyond 1.5 * 1.25
+  const engine::CubeSpherePatch patch{.face = 0, .level = 2, .x = 1, .y = 1};
+  const glm::vec3 center{1.0f, 0.0f, 0.0f};
+  constexpr float kRadius = 0.2f;
+  auto should_split = [&](float camera_x, bool split) {
+    return engine::Planet::ShouldSplit(patch, center, kRadius, split, {camera_x, 0.0f, 0.0f}, info);
+  };
+  CHECK(should_split(1.1f, false));
+  CHECK(should_split(2.6f, false));
+  CHECK(!should_split(2.8f, false));
+  // Hysteresis: a split patch stays split a little further out
+  CHECK(should_split(2.8f, true));
+  CHECK(!should_split(3.2f, true));
+  // Inside the bounds
+  CHECK(should_split(1.0f, false));
+
+  // The finest level never splits
+  const engine::CubeSpherePatch finest_patch{.face = 0, .level = info.max_level};
+  CHECK(!engine::Planet::ShouldSplit(finest_patch, center, 0.0f, false, {1.01f, 0.0f, 0.0f}, info));
+
+  // Within the split distance, but behind the horizon
+  const engine::CubeSpherePatch root_patch{.face = 4};
+  CHECK(!engine::Planet::ShouldSplit(root_patch, {0.0f, 0.0f, 1.0f}, 0.3f, false, {0.0f, 0.0f, -1.5f}, info));
+  CHECK(engine::Planet::ShouldSplit(root_patch, {0.0f, 0.0f, 1.0f}, 0.3f, false, {0.0f, 0.0f, 1.5f}, info));
+}
+}  // namespace
+
+int main() {
+  TestHorizon();
+  TestSplit();
+  return test::Finish();
+}
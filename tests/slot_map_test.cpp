@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "engine/slot_map.h"
+#include "test.h"
+
+namespace {
+using StringHandle = engine::Handle<std::string>;
+
+void TestStaleHandles() {
+  engine::SlotMap<std::string> slot_map;
+  const StringHandle a = slot_map.Insert("a");
+  const StringHandle b = slot_map.Insert("b");
+  const StringHandle c = slot_map.Insert("c");
+  CHECK(slot_map.GetSize() == 3);
+
+  CHECK(slot_map.Remove(a));
+  CHECK(!slot_map.Remove(a));
+  CHECK(slot_map.Get(a) == nullptr);
+  // The last value moved into the hole keeps its handle
+  CHECK(slot_map.Get(b) && *slot_map.Get(b) == "b");
+  CHECK(slot_map.Get(c) && *slot_map.Get(c) == "c");
+
+  // The slot is reused with a new generation, the old handle still misses
+  const StringHandle d = slot_map.Insert("d");
+  CHECK(d.GetIndex() == a.GetIndex());
+  CHECK(d.GetGeneration() != a.GetGeneration());
+  CHECK(slot_map.Get(a) == nullptr);
+  CHECK(slot_map.Get(d) && *slot_map.Get(d) == "d");
+  CHECK(slot_map.GetSize() == 3);
+
+  CHECK(slot_map.Get(StringHandle{}) == nullptr);
+  CHECK(StringHandle{}.IsNull());
+  CHECK(!slot_map.Remove(StringHandle{}));
+  // Out of range of the slots
+  CHECK(slot_map.Get(StringHandle{StringHandle::kMaxIndex, 1}) == nullptr);
+
+  slot_map.Clear();
+  CHECK(slot_map.IsEmpty());
+  CHECK(slot_map.GetSize() == 0);
+  CHECK(slot_map.Get(b) == nullptr);
+  CHECK(slot_map.Get(c) == nullptr);
+  CHECK(slot_map.Get(d) == nullptr);
+}
+
+void TestIteration() {
+  engine::SlotMap<uint32_t> slot_map;
+  std::vector<engine::Handle<uint32_t>> handles;
+  for (uint32_t i = 0; i < 16; ++i) {
+    handles.push_back(slot_map.Insert(i));
+  }
+  for (uint32_t i = 0; i < 16; i += 3) {
+    CHECK(slot_map.Remove(handles[i]));
+  }
+
+  // Every remaining value once, each with the handle it was inserted with
+  std::vector<uint32_t> values(slot_map.begin(), slot_map.end());
+  std::sort(values.begin(), values.end());
+  std::vector<uint32_t> expected;
+  for (uint32_t i = 0; i < 16; ++i) {
+    if (i % 3 != 0) {
+      expected.push_back(i);
+    }
+  }
+  CHECK(values == expected);
+  for (uint32_t i = 0; i < slot_map.GetSize(); ++i) {
+    CHECK(slot_map.GetHandle(i) == handles[slot_map[i]]);
+  }
+}
+
+// Random inserts and removes against a plain list of what should be there
+void TestRandomOperations() {
+  engine::SlotMap<uint32_t> slot_map;
+  std::vector<std::pair<engine::Handle<uint32_t>, uint32_t>> live;
+  std::vector<engine::Handle<uint32_t>> removed;
+  std::mt19937 random{3};
+  for (uint32_t i = 0; i < 20000; ++i) {
+    if (live.empty() || random() % 3 != 0) {
+      live.emplace_back(slot_map.Insert(i), i);
+    } else {
+      const size_t victim = random() % live.size();
+      CHECK(slot_map.Remove(live[victim].first));
+      removed.push_back(live[victim].first);
+      live[victim] = live.back();
+      live.pop_back();
+    }
+  }
+  CHECK(slot_map.GetSize() == live.size());
+  bool all_found = true;
+  for (const auto& [handle, value] : live) {
+    const uint32_t* found = slot_map.Get(handle);
+    all_found &= found && *found == value;
+  }
+  CHECK(all_found);
+  CHECK(std::none_of(removed.begin(), removed.end(), [&](auto handle) { return slot_map.Contains(handle); }));
+}
+
+// A slot removed from so often that its generation would wrap around is retired rather than reused
+void TestGenerationWrap() {
+  engine::SlotMap<uint32_t> slot_map;
+  const engine::Handle<uint32_t> first = slot_map.Insert(0);
+  engine::Handle<uint32_t> handle = first;
+  while (handle.GetIndex() == first.GetIndex()) {
+    CHECK(handle.GetGeneration() >= 1);
+    slot_map.Remove(handle);
+    handle = slot_map.Insert(0);
+  }
+  CHECK(slot_map.Get(first) == nullptr);
+  CHECK(slot_map.GetSize() == 1);
+}
+}  // namespace
+
+int main() {
+  TestStaleHandles();
+  TestIteration();
+  TestRandomOperations();
+  TestGenerationWrap();
+  return test::Finish();
+}
@@ -0,0 +1,135 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "engine/sphere_math.h"
+#include "test.h"
+
+// Built once per SIMD backend the host can run, see CMakeLists.txt
+namespace {
+constexpr int kSkipped = 77;  // Exit code for a backend the host cannot run
+constexpr float kSentinel = -123.0f;
+// The batch CubeToSphere evaluates the same expression as the scalar one, only rounding may differ
+constexpr float kMaxCubeToSphereError = 1e-6f;
+
+struct Points {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+
+  void Add(const glm::vec3& p) {
+    x.push_back(p.x);
+    y.push_back(p.y);
+    z.push_back(p.z);
+  }
+};
+
+// Random points on the unit sphere, led by the poles and both sides of the seam at atan2's branch cut
+Points CreateSpherePoints(uint32_t count) {
+  Points points;
+  const std::vector<glm::vec3> special_points{{0.0f, 1.0f, 0.0f},  {-0.0f, -1.0f, 0.0f}, {-1.0f, 0.0f, 0.0f},
+                                              {-1.0f, 0.0f, -0.0f}, {1.0f, 0.0f, 0.0f},  {0.0f, 0.0f, -1.0f}};
+  for (const glm::vec3& p : special_points) {
+    points.Add(p);
+  }
+  std::mt19937 random{5};
+  std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+  while (points.x.size() < count) {
+    const glm::vec3 p{distribution(random), distribution(random), distribution(random)};
+    if (glm::length(p) > 1e-3f) {
+      points.Add(glm::normalize(p));
+    }
+  }
+  return points;
+}
+
+// Points on the faces of the [-1, 1] cube, edges and corners included
+Points CreateCubePoints(uint32_t count) {
+  Points points;
+  std::mt19937 random{9};
+  std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+  for (uint32_t i = 0; i < count; ++i) {
+    glm::vec3 p{distribution(random), distribution(random), distribution(random)};
+    p[i % 3] = i % 2 == 0 ? 1.0f : -1.0f;
+    if (i % 7 == 0) {
+      p[(i + 1) % 3] = 1.0f;
+    }
+    points.Add(p);
+  }
+  return points;
+}
+
+// Counts around multiples of the batch width exercise the padded tail. Outputs past the count must be left alone.
+std::vector<uint32_t> GetCounts() {
+  const uint32_t width = engine::sphere_math::GetBatchWidth();
+  return {0, 1, width - 1, width, width + 1, 2 * width + 3, 1000, 100003};
+}
+
+void TestCubeToSphere() {
+  for (const uint32_t count : GetCounts()) {
+    const Points points = CreateCubePoints(count);
+    std::vector<float> x(count + 1, kSentinel);
+    std::vector<float> y(count + 1, kSentinel);
+    std::vector<float> z(count + 1, kSentinel);
+    engine::sphere_math::CubeToSphere(points.x.data(), points.y.data(), points.z.data(), x.data(), y.data(), z.data(),
+                                      count);
+    float max_error = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) {
+      const glm::vec3 expected = engine::sphere_math::CubeToSphere({points.x[i], points.y[i], points.z[i]});
+      max_error = std::max(max_error, glm::length(glm::vec3{x[i], y[i], z[i]} - expected));
+    }
+    CHECK(max_error <= kMaxCubeToSphereError);
+    CHECK(x[count] == kSentinel && y[count] == kSentinel && z[count] == kSentinel);
+  }
+}
+
+void TestSphereToUV() {
+  for (const uint32_t count : GetCounts()) {
+    const Points points = CreateSpherePoints(count);
+    std::vector<float> u(count + 1, kSentinel);
+    std::vector<float> v(count + 1, kSentinel);
+    engine::sphere_math::SphereToUV(points.x.data(), points.y.data(), points.z.data(), u.data(), v.data(), count);
+    float max_longitude_error = 0.0f;
+    float max_latitude_error = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) {
+      const glm::vec2 expected = engine::sphere_math::SphereToUV({points.x[i], points.y[i], points.z[i]});
+      // u spans the longitude's 2 pi, v the latitude's pi
+      max_longitude_error = std::max(max_longitude_error, std::abs(u[i] - expected.x) * 2.0f * glm::pi<float>());
+      max_latitude_error = std::max(max_latitude_error, std::abs(v[i] - expected.y) * glm::pi<float>());
+    }
+    CHECK(max_longitude_error <= engine::sphere_math::kMaxAngleError);
+    CHECK(max_latitude_error <= engine::sphere_math::kMaxAngleError);
+    CHECK(u[count] == kSentinel && v[count] == kSentinel);
+  }
+}
+
+// Outputs may alias the inputs
+void TestInPlace() {
+  const uint32_t count = 2 * engine::sphere_math::GetBatchWidth() + 1;
+  Points points = CreateCubePoints(count);
+  const Points cube_points = points;
+  engine::sphere_math::CubeToSphere(points.x.data(), points.y.data(), points.z.data(), points.x.data(),
+                                    points.y.data(), points.z.data(), count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const glm::vec3 expected =
+        engine::sphere_math::CubeToSphere({cube_points.x[i], cube_points.y[i], cube_points.z[i]});
+    CHECK(glm::length(glm::vec3{points.x[i], points.y[i], points.z[i]} - expected) <= kMaxCubeToSphereError);
+  }
+}
+}  // namespace
+
+int main() {
+#if defined(__AVX2__)
+  if (!__builtin_cpu_supports("avx2")) {
+    return kSkipped;
+  }
+#endif
+#if defined(EXPECTED_BATCH_WIDTH)
+  CHECK(engine::sphere_math::GetBatchWidth() == EXPECTED_BATCH_WIDTH);
+#endif
+  TestCubeToSphere();
+  TestSphereToUV();
+  TestInPlace();
+  return test::Finish();
+}
@@ -0,0 +1,48 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "engine/mesh.h"
+#include "engine/thread_pool.h"
+#include "test.h"
+
+namespace {
+// The faces are generated in bands of rows on the workers, the result must not depend on how many there are.
+// Resolutions that are not a multiple of the band size leave a partial band per face.
+void TestWorkerCountIndependence() {
+  for (const bool welded : {true, false}) {
+    for (const uint32_t resolution : {2u, 33u, 70u}) {
+      std::vector<engine::Vertex> expected_vertices;
+      std::vector<uint32_t> expected_indices;
+      engine::ThreadPool calling_thread_only{0};
+      engine::Mesh::GenerateSphere(resolution, welded, expected_vertices, expected_indices, calling_thread_only);
+
+      const uint32_t quad_count = 6 * (resolution - 1) * (resolution - 1);
+      CHECK(expected_indices.size() == 6 * quad_count);
+      const uint32_t unwelded_vertex_count = 6 * resolution * resolution;
+      CHECK(welded ? expected_vertices.size() < unwelded_vertex_count
+                   : expected_vertices.size() == unwelded_vertex_count);
+      for (const uint32_t index : expected_indices) {
+        CHECK(index < expected_vertices.size());
+      }
+      for (const engine::Vertex& vertex : expected_vertices) {
+        CHECK(std::abs(glm::length(vertex.position) - 1.0f) < 1e-5f);
+      }
+
+      for (const uint32_t worker_count : {1u, 3u}) {
+        std::vector<engine::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        engine::ThreadPool thread_pool{worker_count};
+        engine::Mesh::GenerateSphere(resolution, welded, vertices, indices, thread_pool);
+        CHECK(vertices == expected_vertices);
+        CHECK(indices == expected_indices);
+      }
+    }
+  }
+}
+}  // namespace
+
+int main() {
+  TestWorkerCountIndependence();
+  return test::Finish();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the test executables. A failed check is reported and fails the test, the checks after it still
+// run so that one run shows every failure.
+#define CHECK(condition)                                                                   \
+  do {                                                                                     \
+    if (!(condition)) {                                                                    \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      ++test::failure_count;                                                               \
+    }                                                                                      \
+  } while (false)
+
+namespace test {
+inline int failure_count = 0;
+
+// Exit code of main()
+inline int Finish() {
+  if (failure_count > 0) {
+    std::fprintf(stderr, "%d check(s) failed\n", failure_count);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+}  // namespace test
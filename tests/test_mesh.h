@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "engine/math.h"
+#include "engine/vertex.h"
+
+namespace test {
+struct MeshData {
+  std::vector<engine::Vertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+// Unit sphere of rings x segments quads in latitude and longitude, wound counter-clockwise seen from outside. The
+// first and last vertex of each ring are at the same position with u = 0 and u = 1, and each pole is a single position.
+inline MeshData CreateUvSphere(uint32_t rings, uint32_t segments) {
+  MeshData mesh;
+  for (uint32_t ring = 0; ring <= rings; ++ring) {
+    const float latitude = glm::pi<float>() * static_cast<float>(ring) / static_cast<float>(rings);
+    for (uint32_t segment = 0; segment <= segments; ++segment) {
+      const float longitude =
+          2.0f * glm::pi<float>() * static_cast<float>(segment % segments) / static_cast<float>(segments);
+      engine::Vertex vertex{};
+      if (ring == 0 || ring == rings) {
+        vertex.position = {0.0f, ring == 0 ? 1.0f : -1.0f, 0.0f};
+      } else {
+        vertex.position = {std::sin(latitude) * std::cos(longitude), std::cos(latitude),
+                           std::sin(latitude) * std::sin(longitude)};
+      }
+      vertex.normal = vertex.position;
+      vertex.uv = {static_cast<float>(segment) / static_cast<float>(segments),
+                   static_cast<float>(ring) / static_cast<float>(rings)};
+      mesh.vertices.push_back(vertex);
+    }
+  }
+  for (uint32_t ring = 0; ring < rings; ++ring) {
+    for (uint32_t segment = 0; segment < segments; ++segment) {
+      const uint32_t a = ring * (segments + 1) + segment;
+      const uint32_t b = a + segments + 1;
+      mesh.indices.insert(mesh.indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+    }
+  }
+  return mesh;
+}
+
+// Flat unit square of size x size quads in the xy plane, in rows, wound counter-clockwise seen from +z
+inline MeshData CreateGrid(uint32_t size) {
+  MeshData mesh;
+  for (uint32_t y = 0; y <= size; ++y) {
+    for (uint32_t x = 0; x <= size; ++x) {
+      engine::Vertex vertex{};
+      vertex.position = {static_cast<float>(x) / static_cast<float>(size),
+                         static_cast<float>(y) / static_cast<float>(size), 0.0f};
+      vertex.normal = {0.0f, 0.0f, 1.0f};
+      vertex.uv = {vertex.position.x, vertex.position.y};
+      mesh.vertices.push_back(vertex);
+    }
+  }
+  for (uint32_t y = 0; y < size; ++y) {
+    for (uint32_t x = 0; x < size; ++x) {
+      const uint32_t a = y * (size + 1) + x;
+      const uint32_t b = a + size + 1;
+      mesh.indices.insert(mesh.indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+    }
+  }
+  return mesh;
+}
+}  // namespace test
@@ -0,0 +1,71 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "engine/thread_pool.h"
+#include "test.h"
+
+namespace {
+// Whether the count reaches the expected one within a generous timeout
+bool WaitFor(const std::atomic<uint32_t>& count, uint32_t expected) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+  while (count.load() != expected && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  return count.load() == expected;
+}
+
+void TestParallelFor() {
+  for (const uint32_t worker_count : {0u, 1u, 3u}) {
+    engine::ThreadPool thread_pool{worker_count};
+    CHECK(thread_pool.GetWorkerCount() == worker_count);
+    for (const uint32_t task_count : {0u, 1u, 2u, 1000u}) {
+      std::vector<std::atomic<uint32_t>> runs(task_count);
+      thread_pool.ParallelFor(task_count, [&](uint32_t i) { ++runs[i]; });
+      bool once = true;
+      for (const std::atomic<uint32_t>& run : runs) {
+        once &= run.load() == 1;
+      }
+      CHECK(once);
+    }
+  }
+}
+
+void TestSubmit() {
+  // Without workers the job has run by the time Submit returns
+  {
+    engine::ThreadPool thread_pool{0};
+    std::atomic<uint32_t> count = 0;
+    thread_pool.Submit([&] { ++count; });
+    CHECK(count.load() == 1);
+  }
+
+  engine::ThreadPool thread_pool{2};
+  std::atomic<uint32_t> count = 0;
+  std::atomic<bool> release = false;
+  // Jobs that keep a worker busy don't hold up a ParallelFor, its caller runs the tasks itself if need be
+  thread_pool.Submit([&] {
+    while (!release.load()) {
+      std::this_thread::yield();
+    }
+    ++count;
+  });
+  for (uint32_t i = 0; i < 100; ++i) {
+    thread_pool.Submit([&] { ++count; });
+  }
+  std::atomic<uint32_t> task_count = 0;
+  thread_pool.ParallelFor(64, [&](uint32_t) { ++task_count; });
+  CHECK(task_count.load() == 64);
+  CHECK(WaitFor(count, 100));
+  release = true;
+  CHECK(WaitFor(count, 101));
+}
+}  // namespace
+
+int main() {
+  TestParallelFor();
+  TestSubmit();
+  return test::Finish();
+}